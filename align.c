@@ -0,0 +1,143 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "align.h"
+#include "kernels.h"
+
+uint64_t align_sad_u8(const uint8_t *a, const uint8_t *b, int n)
+{
+	return kernels_get()->sad_u8(a, b, n);
+}
+
+void align_overlap(int width, int height, int dx, int dy, int *x, int *y, int *w, int *h)
+{
+	int x0 = dx < 0 ? -dx : 0;
+	int y0 = dy < 0 ? -dy : 0;
+	int x1 = dx > 0 ? width - dx : width;
+	int y1 = dy > 0 ? height - dy : height;
+
+	*x = x0;
+	*y = y0;
+	*w = x1 - x0;
+	*h = y1 - y0;
+}
+
+/* SAD of the reference interior (margin pixels in from every edge) against the
+ * distorted plane shifted by dx, dy. A fixed interior keeps the compared area
+ * identical for every candidate offset.
+ */
+static uint64_t shifted_sad(const uint8_t *ref, const uint8_t *dist, int width, int height, int margin, int dx, int dy)
+{
+	uint64_t sad = 0;
+	int w = width - (margin * 2);
+
+	for (int y = margin; y < height - margin; y++) {
+		sad += align_sad_u8(ref + (y * width) + margin, dist + ((y + dy) * width) + margin + dx, w);
+	}
+
+	return sad;
+}
+
+static uint8_t *downscale_box(const uint8_t *src, int width, int height, int factor, int *dw, int *dh)
+{
+	int w = width / factor;
+	int h = height / factor;
+
+	uint8_t *dst = (uint8_t *)malloc(w * h);
+	if (dst == NULL) {
+		return NULL;
+	}
+
+	int area = factor * factor;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			int sum = 0;
+			for (int j = 0; j < factor; j++) {
+				const uint8_t *p = src + (((y * factor) + j) * width) + (x * factor);
+				for (int i = 0; i < factor; i++) {
+					sum += p[i];
+				}
+			}
+			dst[(y * w) + x] = (sum + (area / 2)) / area;
+		}
+	}
+
+	*dw = w;
+	*dh = h;
+	return dst;
+}
+
+int align_spatial_search(const uint8_t *ref, const uint8_t *dist, int width, int height, int range,
+	struct spatial_offset_s *result, int verbose)
+{
+	const int f = ALIGN_COARSE_FACTOR;
+
+	int crange = (range + f - 1) / f;
+
+	if (range <= 0 || (width / f) <= (crange * 4) || (height / f) <= (crange * 4)) {
+		return -1;
+	}
+
+	/* Coarse pass on the downscaled planes */
+	int cw, ch;
+	uint8_t *cref = downscale_box(ref, width, height, f, &cw, &ch);
+	uint8_t *cdist = downscale_box(dist, width, height, f, &cw, &ch);
+	if (cref == NULL || cdist == NULL) {
+		free(cref);
+		free(cdist);
+		return -1;
+	}
+
+	int cbx = 0, cby = 0;
+	uint64_t best = UINT64_MAX;
+
+	for (int dy = -crange; dy <= crange; dy++) {
+		for (int dx = -crange; dx <= crange; dx++) {
+			uint64_t sad = shifted_sad(cref, cdist, cw, ch, crange, dx, dy);
+			if (sad < best) {
+				best = sad;
+				cbx = dx;
+				cby = dy;
+			}
+		}
+	}
+
+	free(cref);
+	free(cdist);
+
+	if (verbose) {
+		printf("# coarse offset %d, %d (1/%d scale)\n", cbx, cby, f);
+	}
+
+	/* Refine at full resolution around the coarse winner, the coarse
+	 * grid is f pixels so search +/- f, clamped to the requested range.
+	 */
+	int bx = 0, by = 0;
+	best = UINT64_MAX;
+	for (int dy = (cby * f) - f; dy <= (cby * f) + f; dy++) {
+		if (dy < -range || dy > range) {
+			continue;
+		}
+		for (int dx = (cbx * f) - f; dx <= (cbx * f) + f; dx++) {
+			if (dx < -range || dx > range) {
+				continue;
+			}
+			uint64_t sad = shifted_sad(ref, dist, width, height, range, dx, dy);
+			if (sad < best) {
+				best = sad;
+				bx = dx;
+				by = dy;
+			}
+		}
+	}
+
+	result->dx = bx;
+	result->dy = by;
+	result->sad = (double)best / ((width - (range * 2)) * (height - (range * 2)));
+
+	return 0; /* Success */
+}
@@ -0,0 +1,35 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef ALIGN_H
+#define ALIGN_H
+
+#include <stdint.h>
+
+/* Spatial (translation) alignment between a reference and distorted luma plane.
+ * The distorted pixel at (x + dx, y + dy) corresponds to the reference pixel at (x, y).
+ */
+struct spatial_offset_s
+{
+	int dx;
+	int dy;
+	double sad;     /* Mean absolute difference per pixel at the chosen offset */
+};
+
+#define ALIGN_COARSE_FACTOR 4
+
+/* Sum of absolute differences over n bytes, the dispatched kernels.h sad_u8. */
+uint64_t align_sad_u8(const uint8_t *a, const uint8_t *b, int n);
+
+/* Search +/- range pixels, coarse on a 4x box downscaled luma then refined at full
+ * resolution. Both planes are width x height with a stride of width.
+ * Returns 0 on success, -1 if the image is too small for the range.
+ */
+int align_spatial_search(const uint8_t *ref, const uint8_t *dist, int width, int height, int range,
+	struct spatial_offset_s *result, int verbose);
+
+/* Overlapping region of two planes for a given offset, as (x, y, w, h) in reference
+ * coordinates. The distorted region is the same size at (x + dx, y + dy).
+ */
+void align_overlap(int width, int height, int dx, int dy, int *x, int *y, int *w, int *h);
+
+#endif /* ALIGN_H */
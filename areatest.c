@@ -0,0 +1,157 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "kernels.h"
+
+using namespace cv;
+
+/* Checks the hash downsample against the cv::resize(INTER_AREA) reference the DCT
+ * hashes are defined by, on every kernel path this cpu runs. Exits non zero on the
+ * first difference.
+ */
+
+#define ITERATIONS_DEFAULT 4
+
+struct tool_context_s {
+	int verbose;
+	int iterations;
+	unsigned int seed;
+};
+
+/* Frame sizes seen in practice plus odd, prime and barely larger than the thumbnail
+ * sizes, so every fast and fractional path is exercised. 0 terminated.
+ */
+static const int sizes[][2] = {
+	{ 3840, 2160 }, { 1920, 1080 }, { 1280, 720 }, { 720, 576 }, { 720, 480 },
+	{ 640, 360 }, { 352, 288 }, { 176, 144 }, { 64, 64 }, { 96, 32 }, { 32, 32 },
+	{ 33, 33 }, { 1919, 1079 }, { 997, 541 }, { 100, 40 }, { 47, 61 },
+	{ 0, 0 },
+};
+
+static const char *isas[] = { "scalar", "sse42", "avx2", "avx512", NULL };
+
+/* Random noise, flat and ramps, the saturating and rounding corners of the kernels */
+static void fill(uint8_t *buf, int stride, int width, int height, int pattern, unsigned int *seed)
+{
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			uint8_t v;
+			switch (pattern) {
+			case 0: v = rand_r(seed) & 0xff; break;
+			case 1: v = 255; break;
+			case 2: v = (x + y) & 0xff; break;
+			default: v = (rand_r(seed) & 1) ? 255 : 0; break;
+			}
+			buf[(y * stride) + x] = v;
+		}
+	}
+}
+
+static int check(struct tool_context_s *ctx, const char *isa, int width, int height, int pattern)
+{
+	/* A padded stride, the kernels must not assume packed rows */
+	int stride = width + 13;
+	Mat image = Mat(height, width, CV_8UC1);
+	uint8_t *buf = (uint8_t *)malloc((size_t)stride * height);
+	if (buf == NULL) {
+		fprintf(stderr, "unable to allocate memory for %dx%d, aborting\n", width, height);
+		exit(1);
+	}
+	fill(buf, stride, width, height, pattern, &ctx->seed);
+	for (int y = 0; y < height; y++) {
+		memcpy(image.ptr<uint8_t>(y), buf + ((size_t)y * stride), width);
+	}
+
+	Mat ref;
+	resize(image, ref, Size(32, 32), 0, 0, INTER_AREA);
+
+	float thumb[32 * 32];
+	if (kernels_downsample_area(buf, stride, width, height, thumb, 32, 32) < 0) {
+		fprintf(stderr, "%s: %dx%d downsample failed\n", isa, width, height);
+		free(buf);
+		return -1;
+	}
+	free(buf);
+
+	for (int i = 0; i < 32 * 32; i++) {
+		if (thumb[i] != ref.data[i]) {
+			fprintf(stderr, "%s: %dx%d pattern %d differs from cv::resize at %d,%d (%.0f vs %d)\n",
+				isa, width, height, pattern, i % 32, i / 32, thumb[i], ref.data[i]);
+			return -1;
+		}
+	}
+
+	return 0; /* Success */
+}
+
+void usage()
+{
+        printf("A test that the hash downsample matches cv::resize(INTER_AREA) bit for bit, on every kernel path.\n");
+        printf("Usage:\n");
+        printf("  -n random frames per size and kernel path [def: %d]\n", ITERATIONS_DEFAULT);
+        printf("  -e seed for the random frames [def: 1]\n");
+        printf("  -v raise verbosity\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct tool_context_s tool_ctx, *ctx = &tool_ctx;
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->iterations = ITERATIONS_DEFAULT;
+	ctx->seed = 1;
+
+	int ch;
+
+	while ((ch = getopt(argc, argv, "?he:n:v")) != -1) {
+		switch (ch) {
+		case 'e':
+			ctx->seed = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			ctx->iterations = atoi(optarg);
+			break;
+		case 'v':
+			ctx->verbose++;
+			break;
+		default:
+		case '?':
+		case 'h':
+			usage();
+			exit(1);
+		}
+	}
+
+	int cases = 0, failed = 0;
+	for (int k = 0; isas[k]; k++) {
+		if (kernels_force(isas[k]) < 0) {
+			printf("# %s: not supported by this cpu, skipped\n", isas[k]);
+			continue;
+		}
+
+		int before = failed;
+		for (int s = 0; sizes[s][0]; s++) {
+			/* The fixed patterns once, noise as often as asked */
+			for (int p = 0; p < 3 + ctx->iterations; p++) {
+				int pattern = p < 3 ? p + 1 : 0;
+				cases++;
+				if (check(ctx, isas[k], sizes[s][0], sizes[s][1], pattern) < 0) {
+					failed++;
+				}
+			}
+			if (ctx->verbose) {
+				printf("# %s: %dx%d\n", isas[k], sizes[s][0], sizes[s][1]);
+			}
+		}
+		printf("# %s: %s\n", isas[k], failed == before ? "ok" : "FAILED");
+	}
+
+	printf("# %d cases, %d failed\n", cases, failed);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <mutex>
+
+#include "arena.h"
+
+/* Buffers */
+
+enum {
+	BUFFER_HEAP = 0,
+	BUFFER_MAP,
+};
+
+/* Lives in the page in front of the buffer */
+struct arena_buffer_s
+{
+	size_t size;                /* Usable bytes */
+	size_t length;              /* Whole allocation, header page included */
+	int kind;
+	struct arena_buffer_s *next;
+};
+
+static std::mutex pool_lock;
+static struct arena_buffer_s *pool_head;
+static int pool_count;
+static int huge_mode = -1;
+
+int arena_huge_lookup(const char *name)
+{
+	if (strcmp(name, "off") == 0) {
+		return ARENA_HUGE_OFF;
+	}
+	if (strcmp(name, "thp") == 0) {
+		return ARENA_HUGE_THP;
+	}
+	if (strcmp(name, "hugetlb") == 0) {
+		return ARENA_HUGE_TLB;
+	}
+	return -1;
+}
+
+const char *arena_huge_name(int mode)
+{
+	switch (mode) {
+	case ARENA_HUGE_OFF:
+		return "off";
+	case ARENA_HUGE_TLB:
+		return "hugetlb";
+	default:
+		return "thp";
+	}
+}
+
+int arena_huge_mode(void)
+{
+	if (huge_mode < 0) {
+		const char *env = getenv("VMAF_TOOLS_HUGEPAGES");
+		int mode = env ? arena_huge_lookup(env) : -1;
+		huge_mode = mode < 0 ? ARENA_HUGE_THP : mode;
+	}
+	return huge_mode;
+}
+
+void arena_set_huge(int mode)
+{
+	std::lock_guard<std::mutex> guard(pool_lock);
+	huge_mode = mode;
+}
+
+static struct arena_buffer_s *buffer_map(size_t size, int mode)
+{
+	size_t length = (ARENA_PAGE + size + ARENA_HUGE_PAGE - 1) & ~((size_t)ARENA_HUGE_PAGE - 1);
+	void *p = MAP_FAILED;
+
+	if (mode == ARENA_HUGE_TLB) {
+		p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+	if (p == MAP_FAILED) {
+		p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED) {
+			return NULL;
+		}
+		madvise(p, length, MADV_HUGEPAGE);
+	}
+
+	struct arena_buffer_s *b = (struct arena_buffer_s *)p;
+	b->length = length;
+	b->kind = BUFFER_MAP;
+	return b;
+}
+
+static struct arena_buffer_s *buffer_heap(size_t size)
+{
+	void *p;
+	if (posix_memalign(&p, ARENA_PAGE, ARENA_PAGE + size) != 0) {
+		return NULL;
+	}
+
+	struct arena_buffer_s *b = (struct arena_buffer_s *)p;
+	b->length = ARENA_PAGE + size;
+	b->kind = BUFFER_HEAP;
+	return b;
+}
+
+static void buffer_release(struct arena_buffer_s *b)
+{
+	if (b->kind == BUFFER_MAP) {
+		munmap(b, b->length);
+	} else {
+		free(b);
+	}
+}
+
+void *arena_buffer_alloc(size_t size)
+{
+	size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+
+	int mode;
+	{
+		std::lock_guard<std::mutex> guard(pool_lock);
+		for (struct arena_buffer_s **link = &pool_head; *link; link = &(*link)->next) {
+			if ((*link)->size == size) {
+				struct arena_buffer_s *b = *link;
+				*link = b->next;
+				pool_count--;
+				return (uint8_t *)b + ARENA_PAGE;
+			}
+		}
+		mode = arena_huge_mode();
+	}
+
+	/* Huge pages only pay off for buffers that span a few of them */
+	struct arena_buffer_s *b = NULL;
+	if (mode != ARENA_HUGE_OFF && size >= ARENA_HUGE_PAGE) {
+		b = buffer_map(size, mode);
+	}
+	if (b == NULL) {
+		b = buffer_heap(size);
+	}
+	if (b == NULL) {
+		return NULL;
+	}
+	b->size = size;
+	b->next = NULL;
+
+	return (uint8_t *)b + ARENA_PAGE;
+}
+
+void arena_buffer_free(void *p)
+{
+	if (p == NULL) {
+		return;
+	}
+
+	struct arena_buffer_s *b = (struct arena_buffer_s *)((uint8_t *)p - ARENA_PAGE);
+	{
+		std::lock_guard<std::mutex> guard(pool_lock);
+		if (pool_count < ARENA_POOL_MAX) {
+			b->next = pool_head;
+			pool_head = b;
+			pool_count++;
+			return;
+		}
+	}
+
+	buffer_release(b);
+}
+
+/* Scratch. Offsets are logical, the block holds [0, size), anything past it was
+ * served from overflow chunks that are freed on release. Once everything is
+ * released the block is regrown to the peak, so overflow only happens while the
+ * arena is still learning the working set.
+ */
+
+struct arena_chunk_s
+{
+	struct arena_chunk_s *next;
+	size_t offset;              /* Logical offset it was taken at */
+	void *data;
+};
+
+struct arena_s
+{
+	uint8_t *block;
+	size_t size;
+	size_t used;
+	size_t peak;
+	struct arena_chunk_s *overflow;
+};
+
+static void arena_free(struct arena_s *a)
+{
+	arena_release(a, 0);
+	free(a->block);
+	free(a);
+}
+
+struct arena_holder_s
+{
+	struct arena_s *arena;
+	~arena_holder_s()
+	{
+		if (arena) {
+			arena_free(arena);
+		}
+	}
+};
+
+static thread_local struct arena_holder_s thread_arena;
+
+struct arena_s *arena_thread(void)
+{
+	if (thread_arena.arena == NULL) {
+		/* Stays NULL when out of memory, the calls below then treat it as empty */
+		thread_arena.arena = (struct arena_s *)calloc(1, sizeof(struct arena_s));
+	}
+	return thread_arena.arena;
+}
+
+void *arena_alloc(struct arena_s *a, size_t size)
+{
+	if (a == NULL) {
+		return NULL;
+	}
+
+	size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+
+	size_t offset = a->used;
+	a->used += size;
+	if (a->used > a->peak) {
+		a->peak = a->used;
+	}
+
+	if (a->used <= a->size) {
+		return a->block + offset;
+	}
+
+	struct arena_chunk_s *c = (struct arena_chunk_s *)malloc(sizeof(*c));
+	if (c == NULL || posix_memalign(&c->data, ARENA_ALIGN, size) != 0) {
+		free(c);
+		a->used = offset;
+		return NULL;
+	}
+	c->offset = offset;
+	c->next = a->overflow;
+	a->overflow = c;
+
+	return c->data;
+}
+
+size_t arena_mark(const struct arena_s *a)
+{
+	return a ? a->used : 0;
+}
+
+void arena_release(struct arena_s *a, size_t mark)
+{
+	if (a == NULL) {
+		return;
+	}
+
+	while (a->overflow && a->overflow->offset >= mark) {
+		struct arena_chunk_s *c = a->overflow;
+		a->overflow = c->next;
+		free(c->data);
+		free(c);
+	}
+	a->used = mark;
+
+	if (mark == 0 && a->peak > a->size) {
+		size_t size = ARENA_BLOCK_MIN;
+		while (size < a->peak) {
+			size *= 2;
+		}
+		void *p;
+		if (posix_memalign(&p, ARENA_ALIGN, size) == 0) {
+			free(a->block);
+			a->block = (uint8_t *)p;
+			a->size = size;
+		}
+	}
+}
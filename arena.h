@@ -0,0 +1,59 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Frame buffers and kernel scratch without allocator churn.
+ *
+ * Frame buffers come from a shared pool. They are page aligned (so also good for
+ * O_DIRECT and 64 byte vector loads), and large ones are huge page backed. A
+ * freed buffer is kept for the next request of the same size, so passes that
+ * allocate per input or per window reuse the same memory.
+ *
+ * Kernels take their per frame temporaries (the DCT hash float planes and the
+ * like) from the calling thread's scratch arena, a bump allocator that's
+ * released back to a mark when the kernel returns. Once the arena has grown to
+ * the largest working set it has seen, a frame costs no heap allocations.
+ */
+
+#define ARENA_ALIGN 64
+#define ARENA_PAGE 4096
+#define ARENA_HUGE_PAGE (2 * 1024 * 1024)
+#define ARENA_POOL_MAX 16           /* Free buffers kept for reuse */
+#define ARENA_BLOCK_MIN (256 * 1024)
+
+enum arena_huge_e {
+	ARENA_HUGE_OFF = 0,         /* Plain aligned heap memory */
+	ARENA_HUGE_THP,             /* Anonymous maps advised MADV_HUGEPAGE, the default */
+	ARENA_HUGE_TLB,             /* MAP_HUGETLB from the reserved pool, THP when it's empty */
+};
+
+/* Huge page policy for buffers allocated from now on. The default comes from
+ * VMAF_TOOLS_HUGEPAGES=off|thp|hugetlb in the environment, else thp.
+ */
+void arena_set_huge(int mode);
+int  arena_huge_mode(void);
+int  arena_huge_lookup(const char *name);
+const char *arena_huge_name(int mode);
+
+/* Page aligned buffer of at least size bytes, NULL when out of memory */
+void *arena_buffer_alloc(size_t size);
+void arena_buffer_free(void *p);
+
+/* Per thread scratch */
+struct arena_s;
+
+/* The calling thread's arena, created on first use and freed when the thread exits.
+ * NULL when it can't be created, arena_alloc() then returns NULL and mark and
+ * release do nothing, so callers only check the allocations.
+ */
+struct arena_s *arena_thread(void);
+
+/* ARENA_ALIGN aligned scratch, valid until released. NULL when out of memory. */
+void *arena_alloc(struct arena_s *a, size_t size);
+size_t arena_mark(const struct arena_s *a);
+void arena_release(struct arena_s *a, size_t mark);
+
+#endif /* ARENA_H */
@@ -0,0 +1,193 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "blockmse.h"
+#include "kernels.h"
+#include "align.h"
+
+using namespace cv;
+
+uint64_t blockmse_sse_u8(const uint8_t *a, const uint8_t *b, int n)
+{
+	return kernels_get()->sse_u8(a, b, n);
+}
+
+uint64_t blockmse_plane(const uint8_t *a, int astride, const uint8_t *b, int bstride, int w, int h,
+	struct block_grid_s *grid, int gx, int gy)
+{
+	const struct kernels_s *k = kernels_get();
+	uint64_t sse = 0;
+
+	for (int y = 0; y < h; y++) {
+		const uint8_t *pa = a + (y * astride);
+		const uint8_t *pb = b + (y * bstride);
+
+		if (grid == NULL) {
+			sse += k->sse_u8(pa, pb, w);
+			continue;
+		}
+
+		/* Walk the row in block sized segments, each lands in one grid cell */
+		int bs = grid->block_size;
+		uint32_t *cells = grid->sse + (((gy + y) / bs) * grid->cols);
+		int x = 0;
+		while (x < w) {
+			int col = (gx + x) / bs;
+			int len = ((col + 1) * bs) - (gx + x);
+			if (x + len > w) {
+				len = w - x;
+			}
+			uint64_t s = k->sse_u8(pa + x, pb + x, len);
+			cells[col] += (uint32_t)s;
+			sse += s;
+			x += len;
+		}
+	}
+
+	return sse;
+}
+
+void blockmse_frame_420(const uint8_t *a[3], const int astride[3], const uint8_t *b[3], const int bstride[3],
+	int width, int height, int dx, int dy, struct block_grid_s *grid, double mse[3])
+{
+	int x, y, w, h;
+
+	align_overlap(width, height, dx, dy, &x, &y, &w, &h);
+	uint64_t sse = blockmse_plane(a[0] + (y * astride[0]) + x, astride[0],
+		b[0] + ((y + dy) * bstride[0]) + x + dx, bstride[0], w, h, grid, x, y);
+	mse[0] = (double)sse / (w * h);
+
+	int cdx = dx / 2;
+	int cdy = dy / 2;
+	align_overlap(width / 2, height / 2, cdx, cdy, &x, &y, &w, &h);
+	for (int p = 1; p < 3; p++) {
+		sse = blockmse_plane(a[p] + (y * astride[p]) + x, astride[p],
+			b[p] + ((y + cdy) * bstride[p]) + x + cdx, bstride[p], w, h, NULL, 0, 0);
+		mse[p] = (double)sse / (w * h);
+	}
+}
+
+int blockmse_grid_alloc(struct block_grid_s *grid, int width, int height, int block_size)
+{
+	memset(grid, 0, sizeof(*grid));
+
+	if (block_size <= 0 || block_size > BLOCKMSE_SIZE_MAX) {
+		return -1;
+	}
+
+	grid->width = width;
+	grid->height = height;
+	grid->block_size = block_size;
+	grid->cols = (width + block_size - 1) / block_size;
+	grid->rows = (height + block_size - 1) / block_size;
+	grid->sse = (uint32_t *)calloc(grid->cols * grid->rows, sizeof(uint32_t));
+	grid->total = (uint64_t *)calloc(grid->cols * grid->rows, sizeof(uint64_t));
+	if (grid->sse == NULL || grid->total == NULL) {
+		blockmse_grid_free(grid);
+		return -1;
+	}
+
+	return 0; /* Success */
+}
+
+void blockmse_grid_free(struct block_grid_s *grid)
+{
+	free(grid->sse);
+	free(grid->total);
+	grid->sse = NULL;
+	grid->total = NULL;
+}
+
+void blockmse_grid_begin_frame(struct block_grid_s *grid)
+{
+	memset(grid->sse, 0, grid->cols * grid->rows * sizeof(uint32_t));
+}
+
+void blockmse_grid_end_frame(struct block_grid_s *grid)
+{
+	for (int i = 0; i < grid->cols * grid->rows; i++) {
+		grid->total[i] += grid->sse[i];
+	}
+	grid->frames++;
+}
+
+int blockmse_write_header(FILE *fh, const struct block_grid_s *grid)
+{
+	struct blockmse_file_header_s hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, BLOCKMSE_MAGIC, sizeof(hdr.magic));
+	hdr.version = BLOCKMSE_VERSION;
+	hdr.width = grid->width;
+	hdr.height = grid->height;
+	hdr.block_size = grid->block_size;
+	hdr.cols = grid->cols;
+	hdr.rows = grid->rows;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, fh) != 1) {
+		return -1;
+	}
+
+	return 0; /* Success */
+}
+
+int blockmse_write_frame(FILE *fh, const struct block_grid_s *grid, uint32_t frame_nr)
+{
+	size_t count = grid->cols * grid->rows;
+
+	if (fwrite(&frame_nr, sizeof(frame_nr), 1, fh) != 1) {
+		return -1;
+	}
+	if (fwrite(grid->sse, sizeof(uint32_t), count, fh) != count) {
+		return -1;
+	}
+
+	return 0; /* Success */
+}
+
+int blockmse_write_heatmap(const struct block_grid_s *grid, const char *fn)
+{
+	if (grid->frames == 0) {
+		return -1;
+	}
+
+	/* One byte per block, 255 = 20dB or worse, 0 = 50dB or better */
+	Mat cells = Mat(grid->rows, grid->cols, CV_8UC1);
+	for (int r = 0; r < grid->rows; r++) {
+		for (int c = 0; c < grid->cols; c++) {
+			int bw = grid->block_size;
+			int bh = grid->block_size;
+			if ((c + 1) * bw > grid->width) {
+				bw = grid->width - (c * bw);
+			}
+			if ((r + 1) * bh > grid->height) {
+				bh = grid->height - (r * bh);
+			}
+
+			double mse = (double)grid->total[(r * grid->cols) + c] / ((double)bw * bh * grid->frames);
+			double psnr = mse > 0.0 ? 10.0 * log10((255.0 * 255.0) / mse) : 50.0;
+			double v = (50.0 - psnr) / 30.0;
+			if (v < 0.0) {
+				v = 0.0;
+			}
+			if (v > 1.0) {
+				v = 1.0;
+			}
+			cells.at<unsigned char>(r, c) = (unsigned char)(v * 255.0);
+		}
+	}
+
+	Mat scaled, heatmap;
+	resize(cells, scaled, Size(grid->cols * grid->block_size, grid->rows * grid->block_size), 0, 0, INTER_NEAREST);
+	applyColorMap(scaled(Rect(0, 0, grid->width, grid->height)), heatmap, COLORMAP_JET);
+
+	if (!cv::imwrite(fn, heatmap, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 })) {
+		return -1;
+	}
+
+	return 0; /* Success */
+}
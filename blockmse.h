@@ -0,0 +1,75 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef BLOCKMSE_H
+#define BLOCKMSE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Fused squared error kernel. A single pass over each plane produces the
+ * plane SSE and, optionally, the SSE of every block x block tile, so the
+ * block grid costs no extra memory traffic.
+ *
+ * Sidecar file layout, little endian:
+ *   struct blockmse_file_header_s
+ *   per frame: uint32_t frame_nr, then rows * cols uint32_t block SSE values, row major
+ */
+
+#define BLOCKMSE_SIZE_DEFAULT 16
+#define BLOCKMSE_SIZE_MAX 256       /* 256 * 256 * 255 * 255 still fits a uint32_t */
+#define BLOCKMSE_MAGIC "VTBLKSSE"
+#define BLOCKMSE_VERSION 1
+
+struct blockmse_file_header_s
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t block_size;
+	uint32_t cols;
+	uint32_t rows;
+};
+
+struct block_grid_s
+{
+	int width;          /* Plane dimensions the grid covers */
+	int height;
+	int block_size;
+	int cols;
+	int rows;
+	uint32_t *sse;      /* Current frame, rows * cols */
+	uint64_t *total;    /* Summed over all frames, for the heatmap */
+	uint64_t frames;
+};
+
+/* Sum of squared differences over n bytes, the dispatched kernels.h sse_u8. */
+uint64_t blockmse_sse_u8(const uint8_t *a, const uint8_t *b, int n);
+
+/* SSE over a w x h region. When grid is not NULL, block SSE values are accumulated
+ * into grid->sse, with the region positioned at (gx, gy) in grid (plane) coordinates.
+ */
+uint64_t blockmse_plane(const uint8_t *a, int astride, const uint8_t *b, int bstride, int w, int h,
+	struct block_grid_s *grid, int gx, int gy);
+
+/* MSE of the Y, U and V planes of a 4:2:0 frame pair. Only the region that overlaps
+ * at luma offset (dx, dy) is compared, chroma at half the offset, see align.h.
+ * Luma block SSE lands in grid when not NULL.
+ */
+void blockmse_frame_420(const uint8_t *a[3], const int astride[3], const uint8_t *b[3], const int bstride[3],
+	int width, int height, int dx, int dy, struct block_grid_s *grid, double mse[3]);
+
+int  blockmse_grid_alloc(struct block_grid_s *grid, int width, int height, int block_size);
+void blockmse_grid_free(struct block_grid_s *grid);
+void blockmse_grid_begin_frame(struct block_grid_s *grid);
+void blockmse_grid_end_frame(struct block_grid_s *grid);
+
+int  blockmse_write_header(FILE *fh, const struct block_grid_s *grid);
+int  blockmse_write_frame(FILE *fh, const struct block_grid_s *grid, uint32_t frame_nr);
+
+/* Render the per block MSE summed over all frames as a color heatmap PNG at
+ * plane resolution. Blocks are colored on a PSNR scale, 20dB (hot) .. 50dB (cold).
+ */
+int  blockmse_write_heatmap(const struct block_grid_s *grid, const char *fn);
+
+#endif /* BLOCKMSE_H */
@@ -0,0 +1,197 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+
+void checkpoint_identify(struct checkpoint_header_s *hdr, uint32_t mode, int width, int height,
+	char *const fn[CHECKPOINT_INPUTS])
+{
+	memset(hdr, 0, sizeof(*hdr));
+	memcpy(hdr->magic, CHECKPOINT_MAGIC, sizeof(hdr->magic));
+	hdr->version = CHECKPOINT_VERSION;
+	hdr->mode = mode;
+	hdr->width = width;
+	hdr->height = height;
+
+	for (int i = 0; i < CHECKPOINT_INPUTS; i++) {
+		struct stat s;
+		if (fn[i] && stat(fn[i], &s) == 0) {
+			hdr->input_size[i] = s.st_size;
+			hdr->input_mtime[i] = s.st_mtime;
+		}
+	}
+}
+
+int checkpoint_begin(struct checkpoint_s *cp, const char *fn, const struct checkpoint_header_s *hdr)
+{
+	memset(cp, 0, sizeof(*cp));
+	cp->hdr = *hdr;
+	cp->hdr.sections = 0;
+
+	cp->fn = strdup(fn);
+	cp->tmpfn = (char *)malloc(strlen(fn) + 5);
+	if (cp->fn == NULL || cp->tmpfn == NULL) {
+		checkpoint_free(cp);
+		return -1;
+	}
+	sprintf(cp->tmpfn, "%s.tmp", fn);
+
+	cp->fh = fopen(cp->tmpfn, "wb");
+	if (cp->fh == NULL || fwrite(&cp->hdr, sizeof(cp->hdr), 1, cp->fh) != 1) {
+		checkpoint_free(cp);
+		return -1;
+	}
+
+	return 0; /* Success */
+}
+
+int checkpoint_put(struct checkpoint_s *cp, uint32_t tag, const void *data, size_t length)
+{
+	struct checkpoint_section_s sec;
+	memset(&sec, 0, sizeof(sec));
+	sec.tag = tag;
+	sec.length = length;
+
+	if (fwrite(&sec, sizeof(sec), 1, cp->fh) != 1 || (length && fwrite(data, length, 1, cp->fh) != 1)) {
+		return -1;
+	}
+	cp->hdr.sections++;
+
+	return 0; /* Success */
+}
+
+int checkpoint_commit(struct checkpoint_s *cp)
+{
+	int ret = 0;
+
+	/* Section count last, then make it durable before it replaces the previous one */
+	if (fseeko(cp->fh, 0, SEEK_SET) < 0 || fwrite(&cp->hdr, sizeof(cp->hdr), 1, cp->fh) != 1 ||
+		fflush(cp->fh) != 0 || fsync(fileno(cp->fh)) < 0) {
+		ret = -1;
+	}
+	if (fclose(cp->fh) != 0) {
+		ret = -1;
+	}
+	cp->fh = NULL;
+
+	if (ret == 0 && rename(cp->tmpfn, cp->fn) < 0) {
+		ret = -1;
+	}
+	if (ret < 0) {
+		unlink(cp->tmpfn);
+	}
+
+	checkpoint_free(cp);
+
+	return ret;
+}
+
+int checkpoint_load(struct checkpoint_s *cp, const char *fn, const struct checkpoint_header_s *hdr)
+{
+	memset(cp, 0, sizeof(*cp));
+
+	FILE *fh = fopen(fn, "rb");
+	if (fh == NULL) {
+		return -1;
+	}
+
+	fseeko(fh, 0, SEEK_END);
+	off_t len = ftello(fh);
+	rewind(fh);
+
+	if (len < (off_t)sizeof(cp->hdr)) {
+		fclose(fh);
+		return -1;
+	}
+
+	cp->data = (uint8_t *)malloc(len);
+	if (cp->data == NULL || fread(cp->data, 1, len, fh) != (size_t)len) {
+		fclose(fh);
+		checkpoint_free(cp);
+		return -1;
+	}
+	fclose(fh);
+	cp->length = len;
+	memcpy(&cp->hdr, cp->data, sizeof(cp->hdr));
+
+	if (memcmp(cp->hdr.magic, CHECKPOINT_MAGIC, sizeof(cp->hdr.magic)) != 0 || cp->hdr.version != CHECKPOINT_VERSION) {
+		checkpoint_free(cp);
+		return -1;
+	}
+	if (cp->hdr.mode != hdr->mode || cp->hdr.width != hdr->width || cp->hdr.height != hdr->height ||
+		memcmp(cp->hdr.input_size, hdr->input_size, sizeof(hdr->input_size)) != 0 ||
+		memcmp(cp->hdr.input_mtime, hdr->input_mtime, sizeof(hdr->input_mtime)) != 0) {
+		checkpoint_free(cp);
+		return -2;
+	}
+
+	/* Walk the sections once, a truncated file is rejected */
+	size_t pos = sizeof(cp->hdr);
+	for (uint32_t i = 0; i < cp->hdr.sections; i++) {
+		struct checkpoint_section_s sec;
+		if (pos + sizeof(sec) > cp->length) {
+			checkpoint_free(cp);
+			return -1;
+		}
+		memcpy(&sec, cp->data + pos, sizeof(sec));
+		pos += sizeof(sec);
+		if (sec.length > cp->length - pos) {
+			checkpoint_free(cp);
+			return -1;
+		}
+		pos += sec.length;
+	}
+
+	return 0; /* Success */
+}
+
+const void *checkpoint_get(const struct checkpoint_s *cp, uint32_t tag, size_t *length)
+{
+	size_t pos = sizeof(cp->hdr);
+
+	for (uint32_t i = 0; cp->data && i < cp->hdr.sections; i++) {
+		struct checkpoint_section_s sec;
+		memcpy(&sec, cp->data + pos, sizeof(sec));
+		pos += sizeof(sec);
+		if (sec.tag == tag) {
+			if (length) {
+				*length = sec.length;
+			}
+			return cp->data + pos;
+		}
+		pos += sec.length;
+	}
+
+	return NULL;
+}
+
+void checkpoint_free(struct checkpoint_s *cp)
+{
+	if (cp->fh) {
+		fclose(cp->fh);
+		unlink(cp->tmpfn);
+	}
+	free(cp->fn);
+	free(cp->tmpfn);
+	free(cp->data);
+	memset(cp, 0, sizeof(*cp));
+}
+
+FILE *checkpoint_reopen(const char *fn, off_t length)
+{
+	FILE *fh = fopen(fn, "r+b");
+	if (fh == NULL) {
+		return NULL;
+	}
+	if (ftruncate(fileno(fh), length) < 0 || fseeko(fh, length, SEEK_SET) < 0) {
+		fclose(fh);
+		return NULL;
+	}
+
+	return fh;
+}
@@ -0,0 +1,96 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Resumable analysis state for long yuvmse runs. Every so many frames the state a
+ * pass has built up (running aggregates, partial hash lists, sidecar file lengths)
+ * is written to a small state file, and --resume picks the pass up from there.
+ * A killed run loses at most one checkpoint interval.
+ *
+ * The file is written next to itself as fn.tmp, synced and renamed over fn, so a
+ * kill during a checkpoint leaves the previous one intact.
+ *
+ * Layout, native endian, the file only ever returns to the machine that wrote it:
+ *   struct checkpoint_header_s
+ *   sections: struct checkpoint_section_s, then length bytes of payload
+ */
+
+#define CHECKPOINT_MAGIC "VTCKPT01"
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_INTERVAL_DEFAULT 1000    /* Frames */
+#define CHECKPOINT_INPUTS 2
+
+enum checkpoint_mode_e {
+	CHECKPOINT_MSE = 1,         /* compute_sequence_mse */
+	CHECKPOINT_SIGNATURES,      /* Whole file hash lists for -F and -R */
+};
+
+struct checkpoint_header_s
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t mode;
+	uint32_t width;
+	uint32_t height;
+	uint32_t sections;
+	uint32_t reserved;
+	/* The inputs the state belongs to, a resume against different files is refused */
+	uint64_t input_size[CHECKPOINT_INPUTS];
+	int64_t input_mtime[CHECKPOINT_INPUTS];
+};
+
+struct checkpoint_section_s
+{
+	uint32_t tag;
+	uint32_t reserved;
+	uint64_t length;
+};
+
+struct checkpoint_s
+{
+	struct checkpoint_header_s hdr;
+
+	/* Writing */
+	char *fn;
+	char *tmpfn;
+	FILE *fh;
+
+	/* Loaded, the whole file */
+	uint8_t *data;
+	size_t length;
+};
+
+/* Fill in the header identity, mode, dimensions and the inputs' size and mtime.
+ * fn entries may be NULL.
+ */
+void checkpoint_identify(struct checkpoint_header_s *hdr, uint32_t mode, int width, int height,
+	char *const fn[CHECKPOINT_INPUTS]);
+
+/* Write a checkpoint, begin, put each section, commit. Returns -1 on any I/O error,
+ * the previous checkpoint is then still in place.
+ */
+int  checkpoint_begin(struct checkpoint_s *cp, const char *fn, const struct checkpoint_header_s *hdr);
+int  checkpoint_put(struct checkpoint_s *cp, uint32_t tag, const void *data, size_t length);
+int  checkpoint_commit(struct checkpoint_s *cp);
+
+/* Read a checkpoint and check it matches hdr (from checkpoint_identify). Returns 0 on
+ * success, -1 if it can't be read, -2 if it belongs to another mode or other inputs.
+ */
+int  checkpoint_load(struct checkpoint_s *cp, const char *fn, const struct checkpoint_header_s *hdr);
+
+/* Payload of a loaded section, NULL when missing. length may be NULL. */
+const void *checkpoint_get(const struct checkpoint_s *cp, uint32_t tag, size_t *length);
+
+void checkpoint_free(struct checkpoint_s *cp);
+
+/* Reopen an output written before the checkpoint, cut back to length bytes, positioned
+ * at its end for appending. NULL on failure.
+ */
+FILE *checkpoint_reopen(const char *fn, off_t length);
+
+#endif /* CHECKPOINT_H */
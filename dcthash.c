@@ -0,0 +1,81 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <algorithm>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "dcthash.h"
+#include "kernels.h"
+#include "arena.h"
+
+using namespace cv;
+
+uint64_t dcthash_compute(const uint8_t *src, int stride, int width, int height, double *mean, float *coeffs)
+{
+	/* Both 32x32 float planes live in this thread's scratch, dct() writes into the
+	 * preallocated output in place, no per frame heap traffic.
+	 */
+	struct arena_s *arena = arena_thread();
+	size_t mark = arena_mark(arena);
+	void *fbuf = arena_alloc(arena, 32 * 32 * sizeof(float));
+	void *dbuf = arena_alloc(arena, 32 * 32 * sizeof(float));
+	Mat floatImage, dctImage;
+	if (fbuf && dbuf) {
+		floatImage = Mat(32, 32, CV_32F, fbuf);
+		dctImage = Mat(32, 32, CV_32F, dbuf);
+	} else {
+		floatImage.create(32, 32, CV_32F);
+	}
+
+	/* Get the image down to a meaningful 32x32 sample, as floats for the DCT.
+	 * The dispatched area kernel handles downsampling, anything smaller than
+	 * 32x32 goes through OpenCV.
+	 */
+	if (kernels_downsample_area(src, stride, width, height, floatImage.ptr<float>(0), 32, 32) < 0) {
+		Mat image = Mat(height, width, CV_8UC1, (void *)src, stride);
+		Mat resized;
+		resize(image, resized, Size(32, 32), 0, 0, INTER_AREA);
+		resized.convertTo(floatImage, CV_32F); // Convert to float for DCT
+	}
+	dct(floatImage, dctImage);
+
+	/* Orthonormal 32x32 DCT, the DC term is sum / 32, or mean * 32 */
+	if (mean) {
+		*mean = dctImage.at<float>(0, 0) / 32.0;
+	}
+
+	/* Get the dct block top left cols 0..7 and rows 0..7 from the dct'd image */
+	float values[64];
+	for (int i = 0; i < 8; ++i) {
+		for (int j = 0; j < 8; ++j) {
+			values[i * 8 + j] = dctImage.at<float>(i, j);
+		}
+	}
+	if (coeffs) {
+		std::copy(values, values + 64, coeffs);
+	}
+
+	/* Get the high and low medians, be careful not to disrupt
+	 * the 'values' array, copy and nth_element sort on copy. */
+	float temp[64];
+	std::copy(values, values + 64, temp);
+	std::nth_element(temp, temp + 31, temp + 64);
+	float low = temp[31];
+	std::nth_element(temp, temp + 32, temp + 64);
+	float high = temp[32];
+
+	float median = (low + high) / 2.0f;
+
+	/* Compute the hash */
+	uint64_t hash = 0;
+	for (int i = 0; i < 64; ++i) {
+		if (values[i] > median) {
+			hash |= (1ULL << (63 - i));
+		}
+	}
+
+	arena_release(arena, mark);
+
+	return hash;
+}
@@ -0,0 +1,17 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef DCTHASH_H
+#define DCTHASH_H
+
+#include <stdint.h>
+
+/* Perceptual 64bit hash of an 8bit luma plane. The plane is area downsampled to
+ * 32x32, DCT'd, and each of the top left 8x8 coefficients sets a bit when it's
+ * above the median of the 64. Near identical pictures differ by a few bits.
+ *
+ * mean, when not NULL, receives the plane mean (from the DC term).
+ * coeffs, when not NULL, receives the 8x8 coefficients, row major.
+ */
+uint64_t dcthash_compute(const uint8_t *src, int stride, int width, int height, double *mean, float *coeffs);
+
+#endif /* DCTHASH_H */
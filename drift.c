@@ -0,0 +1,261 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "drift.h"
+
+#define BACK_NONE  0
+#define BACK_DIAG  1
+#define BACK_DROP  2
+#define BACK_DUP   3
+#define BACK_START 4
+
+const char *drift_event_name(enum drift_event_e event)
+{
+	switch (event) {
+	case DRIFT_MATCH: return "match";
+	case DRIFT_DROP:  return "drop";
+	case DRIFT_DUP:   return "dup";
+	}
+	return "unknown";
+}
+
+int drift_align(const uint64_t *a, int na, const uint64_t *b, int nb, int offset, int band,
+	struct drift_step_s **path, int *count)
+{
+	if (na <= 0 || nb <= 0 || band < 1) {
+		return -1;
+	}
+
+	int width = (band * 2) + 1;
+
+	/* Per row band origin and back pointers, plus two rows of accumulated cost */
+	int *lo = (int *)malloc(na * sizeof(int));
+	unsigned char *back = (unsigned char *)calloc((size_t)na * width, 1);
+	int *prev = (int *)malloc(width * sizeof(int));
+	int *cur = (int *)malloc(width * sizeof(int));
+	if (lo == NULL || back == NULL || prev == NULL || cur == NULL) {
+		free(lo);
+		free(back);
+		free(prev);
+		free(cur);
+		return -1;
+	}
+
+	int prev_lo = 0, prev_valid = 0;
+	int last_row = -1, last_k = -1;
+
+	for (int i = 0; i < na; i++) {
+		/* Center the band one step on from the previous row's best cell */
+		int center = i + offset;
+		if (prev_valid) {
+			int bk = 0;
+			for (int k = 1; k < width; k++) {
+				if (prev[k] < prev[bk]) {
+					bk = k;
+				}
+			}
+			center = prev_lo + bk + 1;
+		}
+		lo[i] = center - band;
+
+		int valid = 0;
+		for (int k = 0; k < width; k++) {
+			int j = lo[i] + k;
+			cur[k] = INT_MAX;
+			if (j < 0 || j >= nb) {
+				continue;
+			}
+
+			int c = __builtin_popcountll(a[i] ^ b[j]);
+			int best = INT_MAX;
+			unsigned char dir = BACK_START;
+
+			if (prev_valid) {
+				/* Diagonal from (i - 1, j - 1), drop from (i - 1, j) */
+				int pk = (j - 1) - prev_lo;
+				if (pk >= 0 && pk < width && prev[pk] != INT_MAX) {
+					best = prev[pk];
+					dir = BACK_DIAG;
+				}
+				pk = j - prev_lo;
+				if (pk >= 0 && pk < width && prev[pk] != INT_MAX && prev[pk] + DRIFT_STEP_PENALTY < best) {
+					best = prev[pk] + DRIFT_STEP_PENALTY;
+					dir = BACK_DROP;
+				}
+			}
+			/* Dup from (i, j - 1) */
+			if (k > 0 && cur[k - 1] != INT_MAX && cur[k - 1] + DRIFT_STEP_PENALTY < best) {
+				best = cur[k - 1] + DRIFT_STEP_PENALTY;
+				dir = BACK_DUP;
+			}
+			if (best == INT_MAX) {
+				/* Open begin, no predecessor in the band */
+				best = 0;
+				dir = BACK_START;
+			}
+
+			cur[k] = best + c;
+			back[((size_t)i * width) + k] = dir;
+			valid = 1;
+		}
+
+		if (valid) {
+			int bk = -1;
+			for (int k = 0; k < width; k++) {
+				if (cur[k] != INT_MAX && (bk < 0 || cur[k] < cur[bk])) {
+					bk = k;
+				}
+			}
+			last_row = i;
+			last_k = bk;
+		}
+
+		int *t = prev;
+		prev = cur;
+		cur = t;
+		prev_lo = lo[i];
+		prev_valid = valid;
+	}
+
+	free(prev);
+	free(cur);
+
+	if (last_row < 0) {
+		free(lo);
+		free(back);
+		return -1;
+	}
+
+	/* Backtrack, the path can't be longer than na + nb */
+	struct drift_step_s *steps = (struct drift_step_s *)malloc((size_t)(na + nb) * sizeof(*steps));
+	if (steps == NULL) {
+		free(lo);
+		free(back);
+		return -1;
+	}
+
+	int n = 0;
+	int i = last_row, k = last_k;
+	while (i >= 0) {
+		int j = lo[i] + k;
+		unsigned char dir = back[((size_t)i * width) + k];
+
+		steps[n].a = i;
+		steps[n].b = j;
+		steps[n].dist = __builtin_popcountll(a[i] ^ b[j]);
+		steps[n].event = dir == BACK_DROP ? DRIFT_DROP : dir == BACK_DUP ? DRIFT_DUP : DRIFT_MATCH;
+		n++;
+
+		if (dir == BACK_DIAG) {
+			i--;
+			k = (j - 1) - lo[i];
+		} else if (dir == BACK_DROP) {
+			i--;
+			k = j - lo[i];
+		} else if (dir == BACK_DUP) {
+			k--;
+		} else {
+			break;
+		}
+	}
+
+	free(lo);
+	free(back);
+
+	/* Reverse into file1 order */
+	for (int x = 0; x < n / 2; x++) {
+		struct drift_step_s t = steps[x];
+		steps[x] = steps[n - 1 - x];
+		steps[n - 1 - x] = t;
+	}
+
+	/* Trim unmatched content off both ends (pre-roll, trailing frames) */
+	int first = 0, last = n - 1;
+	while (first <= last && steps[first].dist > DRIFT_MATCH_THRESHOLD) {
+		first++;
+	}
+	while (last >= first && steps[last].dist > DRIFT_MATCH_THRESHOLD) {
+		last--;
+	}
+	if (first > last) {
+		free(steps);
+		return -1;
+	}
+	if (first > 0) {
+		memmove(steps, steps + first, (last - first + 1) * sizeof(*steps));
+	}
+	steps[0].event = DRIFT_MATCH;
+
+	*path = steps;
+	*count = last - first + 1;
+
+	return 0; /* Success */
+}
+
+int drift_map_write(FILE *fh, const struct drift_step_s *path, int count)
+{
+	fprintf(fh, "%8s %9s %5s %6s\n", "#  file1", "file2", "Dist", "Event");
+	for (int i = 0; i < count; i++) {
+		if (fprintf(fh, "%08d, %08d, %4d, %5s\n", path[i].a, path[i].b, path[i].dist,
+			drift_event_name(path[i].event)) < 0) {
+			return -1;
+		}
+	}
+
+	return 0; /* Success */
+}
+
+int drift_map_read(const char *fn, struct drift_step_s **path, int *count)
+{
+	FILE *fh = fopen(fn, "rb");
+	if (!fh) {
+		return -1;
+	}
+
+	int alloc = 4096, n = 0;
+	struct drift_step_s *steps = (struct drift_step_s *)malloc(alloc * sizeof(*steps));
+	if (steps == NULL) {
+		fclose(fh);
+		return -1;
+	}
+
+	char line[128];
+	while (fgets(line, sizeof(line), fh)) {
+		if (line[0] == '#' || line[0] == ' ' || line[0] == ';') {
+			continue;
+		}
+
+		int fa, fb, dist;
+		char event[16];
+		if (sscanf(line, "%d, %d, %d, %15s", &fa, &fb, &dist, event) != 4) {
+			continue;
+		}
+
+		if (n == alloc) {
+			alloc *= 2;
+			struct drift_step_s *p = (struct drift_step_s *)realloc(steps, alloc * sizeof(*steps));
+			if (p == NULL) {
+				free(steps);
+				fclose(fh);
+				return -1;
+			}
+			steps = p;
+		}
+
+		steps[n].a = fa;
+		steps[n].b = fb;
+		steps[n].dist = dist;
+		steps[n].event = strcmp(event, "drop") == 0 ? DRIFT_DROP :
+			strcmp(event, "dup") == 0 ? DRIFT_DUP : DRIFT_MATCH;
+		n++;
+	}
+	fclose(fh);
+
+	*path = steps;
+	*count = n;
+
+	return 0; /* Success */
+}
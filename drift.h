@@ -0,0 +1,47 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef DRIFT_H
+#define DRIFT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Drift tolerant alignment of two hash sequences, a banded dynamic programming
+ * (DTW style) search. Unlike a single constant offset, the path may step
+ * sideways, so frames dropped or duplicated by a live encoder are absorbed and
+ * reported rather than breaking the alignment.
+ *
+ * The band follows the best cell of the previous row, so slow accumulated drift
+ * over a long file never walks out of it.
+ */
+
+#define DRIFT_STEP_PENALTY 8      /* Cost of a drop or dup step, in hamming bits */
+#define DRIFT_MATCH_THRESHOLD 10  /* Ends of the path above this are trimmed */
+
+enum drift_event_e {
+	DRIFT_MATCH = 0,  /* Both sequences advanced */
+	DRIFT_DROP,       /* file1 advanced, file2 did not, file2 dropped a frame */
+	DRIFT_DUP,        /* file2 advanced, file1 did not, file2 duplicated a frame */
+};
+
+struct drift_step_s
+{
+	int a;            /* file1 frame */
+	int b;            /* file2 frame */
+	int dist;         /* Hamming distance between the two hashes */
+	enum drift_event_e event;
+};
+
+const char *drift_event_name(enum drift_event_e event);
+
+/* Align a and b, starting around b[i + offset] == a[i] and searching +/- band
+ * frames. The path (caller frees) is returned in file1 order.
+ * Returns 0 on success, -1 on error or no path.
+ */
+int drift_align(const uint64_t *a, int na, const uint64_t *b, int nb, int offset, int band,
+	struct drift_step_s **path, int *count);
+
+int drift_map_write(FILE *fh, const struct drift_step_s *path, int count);
+int drift_map_read(const char *fn, struct drift_step_s **path, int *count);
+
+#endif /* DRIFT_H */
@@ -0,0 +1,65 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fingerprint.h"
+#include "dcthash.h"
+#include "kernels.h"
+#include "arena.h"
+
+int fingerprint_list_alloc(struct fingerprint_list_s *l, int frames)
+{
+	memset(l, 0, sizeof(*l));
+	for (int w = 0; w < FINGERPRINT_WORDS; w++) {
+		l->word[w] = (uint64_t *)calloc(frames > 0 ? frames : 1, sizeof(uint64_t));
+		if (l->word[w] == NULL) {
+			fingerprint_list_free(l);
+			return -1;
+		}
+	}
+
+	return 0; /* Success */
+}
+
+void fingerprint_list_free(struct fingerprint_list_s *l)
+{
+	for (int w = 0; w < FINGERPRINT_WORDS; w++) {
+		free(l->word[w]);
+		l->word[w] = NULL;
+	}
+	l->count = 0;
+}
+
+void fingerprint_frame(const uint8_t *frame, const uint8_t *prev, int width, int height, uint64_t luma_hash,
+	uint64_t words[FINGERPRINT_WORDS])
+{
+	int cw = width / 2;
+	int ch = height / 2;
+	const uint8_t *u = frame + ((size_t)width * height);
+	const uint8_t *v = u + ((size_t)cw * ch);
+
+	words[FINGERPRINT_LUMA] = luma_hash;
+	words[FINGERPRINT_CHROMA_U] = dcthash_compute(u, cw, cw, ch, NULL, NULL);
+	words[FINGERPRINT_CHROMA_V] = dcthash_compute(v, cw, cw, ch, NULL, NULL);
+	words[FINGERPRINT_MOTION] = 0;
+
+	if (prev == NULL) {
+		return;
+	}
+
+	/* The difference plane is thread scratch, its mean falls out of the hash */
+	struct arena_s *a = arena_thread();
+	size_t mark = arena_mark(a);
+	uint8_t *diff = (uint8_t *)arena_alloc(a, (size_t)width * height);
+	if (diff) {
+		kernels_get()->absdiff_u8(frame, prev, diff, width * height);
+
+		double mad = 0;
+		uint64_t hash = dcthash_compute(diff, width, width, height, &mad, NULL);
+		if (mad >= FINGERPRINT_STATIC_MAD) {
+			words[FINGERPRINT_MOTION] = hash;
+		}
+	}
+	arena_release(a, mark);
+}
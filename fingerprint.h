@@ -0,0 +1,51 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdint.h>
+
+/* Extended 256 bit frame fingerprint, for alignment of mostly static content.
+ *
+ * The 64 bit luma DCT hash can't tell the frames of a talking head or a slide
+ * apart, so a search finds long runs of near identical hashes at many offsets.
+ * The fingerprint adds three more DCT hash words:
+ *
+ *   luma    the 64 bit hash, unchanged, so it's still there for everything else
+ *   U, V    the chroma planes, colour changes luma doesn't see
+ *   motion  the absolute luma difference to the previous frame, where things
+ *           moved. Frames that barely change (mean difference under
+ *           FINGERPRINT_STATIC_MAD) get 0, a hash of sensor and encoder noise
+ *           would differ between two captures of the same frame.
+ *
+ * Lists are planar, one array per word, 32 bytes a frame. Each word is then a
+ * plain hash list for the popcount kernels, see hashmatrix.h.
+ */
+
+#define FINGERPRINT_WORDS 4
+#define FINGERPRINT_STATIC_MAD 1.0
+
+enum fingerprint_word_e {
+	FINGERPRINT_LUMA = 0,
+	FINGERPRINT_CHROMA_U,
+	FINGERPRINT_CHROMA_V,
+	FINGERPRINT_MOTION,
+};
+
+struct fingerprint_list_s
+{
+	int count;
+	uint64_t *word[FINGERPRINT_WORDS];
+};
+
+/* Room for frames fingerprints, zeroed. Returns 0, or -1 when out of memory. */
+int fingerprint_list_alloc(struct fingerprint_list_s *l, int frames);
+void fingerprint_list_free(struct fingerprint_list_s *l);
+
+/* The remaining words for a 4:2:0 frame whose luma hash the caller already has.
+ * prev is the previous frame's luma plane, NULL for the first frame.
+ */
+void fingerprint_frame(const uint8_t *frame, const uint8_t *prev, int width, int height, uint64_t luma_hash,
+	uint64_t words[FINGERPRINT_WORDS]);
+
+#endif /* FINGERPRINT_H */
@@ -0,0 +1,109 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "follow.h"
+
+struct follow_s
+{
+	int count;
+	int fd[FOLLOW_FILES_MAX];   /* Kept open so a rename over the file doesn't lose it */
+	int inotify;                /* -1 when polling */
+	int poll_ms;
+};
+
+struct follow_s *follow_open(char *const *fn, int count, int poll_ms)
+{
+	if (count < 1 || count > FOLLOW_FILES_MAX) {
+		return NULL;
+	}
+
+	struct follow_s *f = (struct follow_s *)calloc(1, sizeof(*f));
+	if (f == NULL) {
+		return NULL;
+	}
+	f->count = count;
+	f->poll_ms = poll_ms > 0 ? poll_ms : FOLLOW_POLL_MS_DEFAULT;
+	f->inotify = -1;
+	for (int i = 0; i < FOLLOW_FILES_MAX; i++) {
+		f->fd[i] = -1;
+	}
+
+	for (int i = 0; i < count; i++) {
+		f->fd[i] = open(fn[i], O_RDONLY | O_CLOEXEC);
+		if (f->fd[i] < 0) {
+			follow_close(f);
+			return NULL;
+		}
+	}
+
+	f->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	for (int i = 0; f->inotify >= 0 && i < count; i++) {
+		if (inotify_add_watch(f->inotify, fn[i], IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+			close(f->inotify);
+			f->inotify = -1;
+		}
+	}
+
+	return f;
+}
+
+void follow_close(struct follow_s *f)
+{
+	if (f == NULL) {
+		return;
+	}
+	for (int i = 0; i < FOLLOW_FILES_MAX; i++) {
+		if (f->fd[i] >= 0) {
+			close(f->fd[i]);
+		}
+	}
+	if (f->inotify >= 0) {
+		close(f->inotify);
+	}
+	free(f);
+}
+
+int follow_wait(struct follow_s *f)
+{
+	if (f->inotify < 0) {
+		usleep(f->poll_ms * 1000);
+		return 0;
+	}
+
+	struct pollfd p;
+	p.fd = f->inotify;
+	p.events = POLLIN;
+	p.revents = 0;
+	if (poll(&p, 1, f->poll_ms) <= 0) {
+		return 0;
+	}
+
+	/* Only the wake up matters, the sizes are read back by the caller */
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	while (read(f->inotify, buf, sizeof(buf)) > 0) {
+	}
+
+	return 1;
+}
+
+int64_t follow_size(struct follow_s *f, int i)
+{
+	struct stat s;
+	if (i < 0 || i >= f->count || fstat(f->fd[i], &s) < 0) {
+		return -1;
+	}
+	return s.st_size;
+}
+
+const char *follow_method(const struct follow_s *f)
+{
+	return f->inotify >= 0 ? "inotify" : "polling";
+}
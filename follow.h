@@ -0,0 +1,37 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef FOLLOW_H
+#define FOLLOW_H
+
+#include <stdint.h>
+
+/* Waiting on files that are still being written, for yuvmse --follow.
+ *
+ * The files are watched with inotify where the kernel allows it, so a new frame
+ * is picked up as soon as it's written. inotify doesn't see writes made on other
+ * NFS/SMB clients, so a wait never lasts longer than the poll interval either,
+ * the caller re-checks the sizes after every wait. That bounds the latency from a
+ * frame landing on disk to its result to one interval, whatever the filesystem.
+ */
+
+#define FOLLOW_POLL_MS_DEFAULT 100
+#define FOLLOW_FILES_MAX 2
+
+struct follow_s;
+
+/* NULL if a file can't be opened */
+struct follow_s *follow_open(char *const *fn, int count, int poll_ms);
+void follow_close(struct follow_s *f);
+
+/* Return when a watched file changes or after the poll interval, whichever is
+ * first. Returns 1 for a change, 0 for a timeout or a signal.
+ */
+int follow_wait(struct follow_s *f);
+
+/* Current size of file i, -1 on error */
+int64_t follow_size(struct follow_s *f, int i);
+
+/* "inotify" or "polling" */
+const char *follow_method(const struct follow_s *f);
+
+#endif /* FOLLOW_H */
@@ -0,0 +1,190 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "framecache.h"
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t w)
+{
+	acc += w * PRIME64_2;
+	acc = rotl64(acc, 31);
+	return acc * PRIME64_1;
+}
+
+static inline uint64_t merge64(uint64_t h, uint64_t v)
+{
+	h ^= round64(0, v);
+	return (h * PRIME64_1) + PRIME64_4;
+}
+
+static inline uint64_t avalanche64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+void framecache_fingerprint(const uint8_t *src, size_t len, uint64_t fp[2])
+{
+	uint64_t v[4] = { PRIME64_1 + PRIME64_2, PRIME64_2, 0, 0 - PRIME64_1 };
+	size_t i = 0;
+
+	/* Four independent lanes over 32 byte stripes keep the multipliers busy */
+	for (; i + 32 <= len; i += 32) {
+		uint64_t w[4];
+		memcpy(w, src + i, sizeof(w));
+		v[0] = round64(v[0], w[0]);
+		v[1] = round64(v[1], w[1]);
+		v[2] = round64(v[2], w[2]);
+		v[3] = round64(v[3], w[3]);
+	}
+	for (; i < len; i++) {
+		v[i & 3] = round64(v[i & 3], src[i] + PRIME64_5);
+	}
+
+	/* Two finalisations over the 256bit lane state, in opposite lane orders */
+	uint64_t h0 = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+	uint64_t h1 = rotl64(v[3], 1) + rotl64(v[2], 7) + rotl64(v[1], 12) + rotl64(v[0], 18) + PRIME64_5;
+	for (int l = 0; l < 4; l++) {
+		h0 = merge64(h0, v[l]);
+		h1 = merge64(h1, v[3 - l]);
+	}
+
+	fp[0] = avalanche64(h0 + len);
+	fp[1] = avalanche64(h1 ^ (len * PRIME64_3));
+}
+
+static int key_bucket(const struct framecache_s *c, const struct framecache_key_s *key)
+{
+	/* The fingerprints are already well mixed */
+	return (int)((key->a[0] ^ rotl64(key->b[0], 17)) & (c->buckets - 1));
+}
+
+static void lru_unlink(struct framecache_s *c, int i)
+{
+	struct framecache_entry_s *e = &c->entry[i];
+	if (e->lru_prev >= 0) {
+		c->entry[e->lru_prev].lru_next = e->lru_next;
+	} else {
+		c->lru_head = e->lru_next;
+	}
+	if (e->lru_next >= 0) {
+		c->entry[e->lru_next].lru_prev = e->lru_prev;
+	} else {
+		c->lru_tail = e->lru_prev;
+	}
+}
+
+static void lru_push_head(struct framecache_s *c, int i)
+{
+	struct framecache_entry_s *e = &c->entry[i];
+	e->lru_prev = -1;
+	e->lru_next = c->lru_head;
+	if (c->lru_head >= 0) {
+		c->entry[c->lru_head].lru_prev = i;
+	}
+	c->lru_head = i;
+	if (c->lru_tail < 0) {
+		c->lru_tail = i;
+	}
+}
+
+int framecache_alloc(struct framecache_s *c, int entries, size_t value_size)
+{
+	memset(c, 0, sizeof(*c));
+
+	if (entries <= 0) {
+		return -1;
+	}
+
+	c->buckets = 1;
+	while (c->buckets < entries * 2) {
+		c->buckets <<= 1;
+	}
+
+	c->entries = entries;
+	c->value_size = value_size;
+	c->entry = (struct framecache_entry_s *)calloc(entries, sizeof(*c->entry));
+	c->values = (uint8_t *)malloc(entries * value_size);
+	c->bucket = (int *)malloc(c->buckets * sizeof(int));
+	if (c->entry == NULL || c->values == NULL || c->bucket == NULL) {
+		framecache_free(c);
+		return -1;
+	}
+
+	for (int i = 0; i < c->buckets; i++) {
+		c->bucket[i] = -1;
+	}
+	c->lru_head = -1;
+	c->lru_tail = -1;
+
+	return 0; /* Success */
+}
+
+void framecache_free(struct framecache_s *c)
+{
+	free(c->entry);
+	free(c->values);
+	free(c->bucket);
+	memset(c, 0, sizeof(*c));
+}
+
+void *framecache_lookup(struct framecache_s *c, const struct framecache_key_s *key)
+{
+	for (int i = c->bucket[key_bucket(c, key)]; i >= 0; i = c->entry[i].bucket_next) {
+		if (memcmp(&c->entry[i].key, key, sizeof(*key)) == 0) {
+			lru_unlink(c, i);
+			lru_push_head(c, i);
+			c->hits++;
+			return c->values + (i * c->value_size);
+		}
+	}
+
+	c->misses++;
+	return NULL;
+}
+
+void *framecache_insert(struct framecache_s *c, const struct framecache_key_s *key)
+{
+	int i;
+
+	if (c->count < c->entries) {
+		i = c->count++;
+	} else {
+		/* Evict the least recently used, off its hash chain first */
+		i = c->lru_tail;
+		lru_unlink(c, i);
+
+		int *link = &c->bucket[key_bucket(c, &c->entry[i].key)];
+		while (*link != i) {
+			link = &c->entry[*link].bucket_next;
+		}
+		*link = c->entry[i].bucket_next;
+	}
+
+	struct framecache_entry_s *e = &c->entry[i];
+	e->key = *key;
+	e->used = 1;
+
+	int b = key_bucket(c, key);
+	e->bucket_next = c->bucket[b];
+	c->bucket[b] = i;
+	lru_push_head(c, i);
+
+	return c->values + (i * c->value_size);
+}
@@ -0,0 +1,66 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Repeated content short circuit. Freezes, slates and black runs are the same bytes
+ * frame after frame, so each frame gets a 128bit fingerprint of its raw planes, one
+ * pass at memory speed, and the measurements for a (reference, distorted) pair of
+ * fingerprints are kept in a bounded LRU cache. A repeat costs the fingerprint
+ * instead of the whole metric stack.
+ *
+ * The fingerprint isn't cryptographic, it's a 4 lane multiply/rotate hash (xxh64
+ * style rounds) finalised twice. Accidental collisions over 128 bits don't happen
+ * in practice.
+ */
+
+#define FRAMECACHE_ENTRIES_DEFAULT 0     /* Opt in, a size that suits repeated content is 256 */
+
+struct framecache_key_s
+{
+	uint64_t a[2];          /* Reference fingerprint */
+	uint64_t b[2];          /* Distorted fingerprint, 0 when there's no distorted frame */
+};
+
+struct framecache_entry_s
+{
+	struct framecache_key_s key;
+	int used;
+	int bucket_next;        /* Hash chain, -1 terminates */
+	int lru_prev;           /* Most recently used at the head */
+	int lru_next;
+};
+
+struct framecache_s
+{
+	int entries;
+	size_t value_size;
+	struct framecache_entry_s *entry;
+	uint8_t *values;        /* entries * value_size */
+	int *bucket;            /* Power of two, at least 2 * entries */
+	int buckets;
+	int lru_head;
+	int lru_tail;
+	int count;
+
+	uint64_t hits;
+	uint64_t misses;
+};
+
+void framecache_fingerprint(const uint8_t *src, size_t len, uint64_t fp[2]);
+
+int  framecache_alloc(struct framecache_s *c, int entries, size_t value_size);
+void framecache_free(struct framecache_s *c);
+
+/* The cached value for key, or NULL. A hit becomes the most recently used entry. */
+void *framecache_lookup(struct framecache_s *c, const struct framecache_key_s *key);
+
+/* Slot for key's value, for the caller to fill in, evicting the least recently used
+ * entry when full. key must not already be cached.
+ */
+void *framecache_insert(struct framecache_s *c, const struct framecache_key_s *key);
+
+#endif /* FRAMECACHE_H */
@@ -0,0 +1,586 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "framereader.h"
+#include "arena.h"
+
+enum {
+	SLOT_FREE = 0,
+	SLOT_QUEUED,    /* Waiting for an I/O thread */
+	SLOT_BUSY,      /* Read in progress */
+	SLOT_DONE,
+};
+
+struct framereader_slot_s
+{
+	uint8_t *buf;
+	int64_t nr;
+	off_t offset;       /* Start of the read, block aligned with O_DIRECT */
+	size_t length;      /* Bytes requested */
+	size_t skew;        /* Frame start within buf */
+	ssize_t result;
+	int state;
+};
+
+struct uring_s
+{
+	int fd;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+	unsigned unsubmitted;
+};
+
+struct framereader_s
+{
+	int fd;
+	int engine;
+	int direct;
+	size_t frame_size;
+	int64_t frames;     /* Whole frames in the file */
+
+	int nslots;         /* depth + the one held by the caller */
+	struct framereader_slot_s *slot;
+	int head;           /* Oldest of count queued slots */
+	int count;
+	int64_t tail_nr;    /* Newest queued frame */
+	int held;           /* The head slot was returned to the caller */
+
+	/* Optional read ahead order, ascending frame numbers owned by the caller */
+	const int64_t *plan;
+	int plan_count;
+	int plan_pos;       /* First entry after tail_nr */
+
+	struct uring_s uring;
+
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable cond;
+	int terminate;
+};
+
+static ssize_t pread_full(int fd, uint8_t *buf, size_t length, off_t offset)
+{
+	size_t done = 0;
+	while (done < length) {
+		ssize_t l = pread(fd, buf + done, length - done, offset + done);
+		if (l < 0 && errno == EINTR) {
+			continue;
+		}
+		if (l < 0) {
+			return done ? (ssize_t)done : -1;
+		}
+		if (l == 0) {
+			break;
+		}
+		done += l;
+	}
+	return done;
+}
+
+/* io_uring, straight on the syscalls */
+
+static int uring_setup(struct uring_s *u, unsigned entries)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	memset(u, 0, sizeof(*u));
+
+	u->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (u->fd < 0) {
+		return -1;
+	}
+
+	u->sq_ring_size = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+	u->cq_ring_size = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (u->cq_ring_size > u->sq_ring_size) {
+			u->sq_ring_size = u->cq_ring_size;
+		}
+		u->cq_ring_size = u->sq_ring_size;
+	}
+
+	u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+	if (u->sq_ring == MAP_FAILED) {
+		close(u->fd);
+		return -1;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		u->cq_ring = u->sq_ring;
+	} else {
+		u->cq_ring = mmap(NULL, u->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+		if (u->cq_ring == MAP_FAILED) {
+			munmap(u->sq_ring, u->sq_ring_size);
+			close(u->fd);
+			return -1;
+		}
+	}
+
+	u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	u->sqes = (struct io_uring_sqe *)mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		if (u->cq_ring != u->sq_ring) {
+			munmap(u->cq_ring, u->cq_ring_size);
+		}
+		munmap(u->sq_ring, u->sq_ring_size);
+		close(u->fd);
+		return -1;
+	}
+
+	uint8_t *sq = (uint8_t *)u->sq_ring;
+	uint8_t *cq = (uint8_t *)u->cq_ring;
+	u->sq_head = (unsigned *)(sq + p.sq_off.head);
+	u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	u->sq_array = (unsigned *)(sq + p.sq_off.array);
+	u->cq_head = (unsigned *)(cq + p.cq_off.head);
+	u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	return 0; /* Success */
+}
+
+static void uring_free(struct uring_s *u)
+{
+	munmap(u->sqes, u->sqes_size);
+	if (u->cq_ring != u->sq_ring) {
+		munmap(u->cq_ring, u->cq_ring_size);
+	}
+	munmap(u->sq_ring, u->sq_ring_size);
+	close(u->fd);
+}
+
+static int uring_enter(struct uring_s *u, unsigned submit, unsigned wait)
+{
+	int ret;
+	do {
+		ret = syscall(__NR_io_uring_enter, u->fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret > 0) {
+		u->unsubmitted -= ret;
+	}
+	return ret;
+}
+
+static void uring_queue_read(struct framereader_s *r, int i)
+{
+	struct uring_s *u = &r->uring;
+	struct framereader_slot_s *s = &r->slot[i];
+
+	unsigned tail = *u->sq_tail;
+	unsigned idx = tail & *u->sq_mask;
+	struct io_uring_sqe *sqe = &u->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = r->fd;
+	sqe->addr = (uint64_t)(uintptr_t)s->buf;
+	sqe->len = s->length;
+	sqe->off = s->offset;
+	sqe->user_data = i;
+	u->sq_array[idx] = idx;
+	__atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	u->unsubmitted++;
+}
+
+static void uring_reap(struct framereader_s *r)
+{
+	struct uring_s *u = &r->uring;
+	unsigned head = *u->cq_head;
+	unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; head++) {
+		struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+		struct framereader_slot_s *s = &r->slot[cqe->user_data];
+		s->result = cqe->res;
+		s->state = SLOT_DONE;
+	}
+	__atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* I/O threads, the fallback. Oldest queued frame first. */
+
+static void framereader_worker(struct framereader_s *r)
+{
+	std::unique_lock<std::mutex> guard(r->lock);
+
+	while (1) {
+		struct framereader_slot_s *s = NULL;
+		for (int i = 0; i < r->nslots; i++) {
+			if (r->slot[i].state == SLOT_QUEUED && (s == NULL || r->slot[i].nr < s->nr)) {
+				s = &r->slot[i];
+			}
+		}
+		if (s == NULL) {
+			if (r->terminate) {
+				return;
+			}
+			r->cond.wait(guard);
+			continue;
+		}
+
+		s->state = SLOT_BUSY;
+		guard.unlock();
+		ssize_t result = pread_full(r->fd, s->buf, s->length, s->offset);
+		guard.lock();
+		s->result = result;
+		s->state = SLOT_DONE;
+		r->cond.notify_all();
+	}
+}
+
+/* Slots */
+
+static void slot_start(struct framereader_s *r, int i, int64_t nr)
+{
+	struct framereader_slot_s *s = &r->slot[i];
+	off_t offset = (off_t)nr * r->frame_size;
+
+	s->nr = nr;
+	s->result = 0;
+	if (r->direct) {
+		s->offset = offset & ~((off_t)FRAMEREADER_ALIGN - 1);
+		s->skew = offset - s->offset;
+		s->length = (s->skew + r->frame_size + FRAMEREADER_ALIGN - 1) & ~((size_t)FRAMEREADER_ALIGN - 1);
+	} else {
+		s->offset = offset;
+		s->skew = 0;
+		s->length = r->frame_size;
+	}
+
+	switch (r->engine) {
+	case FRAMEREADER_URING:
+		s->state = SLOT_BUSY;
+		uring_queue_read(r, i);
+		break;
+	case FRAMEREADER_THREADS:
+		{
+			std::lock_guard<std::mutex> guard(r->lock);
+			s->state = SLOT_QUEUED;
+		}
+		r->cond.notify_one();
+		break;
+	default:
+		s->state = SLOT_QUEUED;
+		break;
+	}
+}
+
+static void slot_wait(struct framereader_s *r, int i)
+{
+	struct framereader_slot_s *s = &r->slot[i];
+
+	switch (r->engine) {
+	case FRAMEREADER_URING:
+		while (s->state != SLOT_DONE) {
+			if (uring_enter(&r->uring, r->uring.unsubmitted, 1) < 0) {
+				/* Ring unusable, finish this one by hand */
+				s->result = -1;
+				s->state = SLOT_DONE;
+				break;
+			}
+			uring_reap(r);
+		}
+		break;
+	case FRAMEREADER_THREADS:
+		{
+			std::unique_lock<std::mutex> guard(r->lock);
+			r->cond.wait(guard, [s] { return s->state == SLOT_DONE; });
+		}
+		break;
+	default:
+		s->result = pread_full(r->fd, s->buf, s->length, s->offset);
+		s->state = SLOT_DONE;
+		break;
+	}
+
+	/* Short reads and kernels without IORING_OP_READ, finish synchronously */
+	size_t want = s->skew + r->frame_size;
+	if (s->result < 0 && r->engine == FRAMEREADER_URING && s->result != -EIO) {
+		s->result = pread_full(r->fd, s->buf, s->length, s->offset);
+	} else if (s->result > 0 && (size_t)s->result < want && (size_t)s->result < s->length) {
+		ssize_t l = pread_full(r->fd, s->buf + s->result, s->length - s->result, s->offset + s->result);
+		if (l > 0) {
+			s->result += l;
+		}
+	}
+}
+
+/* Let every outstanding read land, the buffers are about to be reused */
+static void framereader_drain(struct framereader_s *r)
+{
+	for (int n = 0; n < r->count; n++) {
+		int i = (r->head + n) % r->nslots;
+		if (r->engine == FRAMEREADER_THREADS) {
+			std::lock_guard<std::mutex> guard(r->lock);
+			if (r->slot[i].state == SLOT_QUEUED) {
+				r->slot[i].state = SLOT_FREE;
+				continue;
+			}
+		}
+		if (r->slot[i].state != SLOT_FREE && (r->engine != FRAMEREADER_SYNC || r->slot[i].state != SLOT_QUEUED)) {
+			slot_wait(r, i);
+		}
+		r->slot[i].state = SLOT_FREE;
+	}
+	r->count = 0;
+	r->held = 0;
+}
+
+struct framereader_s *framereader_open(const char *fn, size_t frame_size, int depth, int engine, int direct)
+{
+	/* Nothing to read ahead without a queue */
+	if (depth <= 0) {
+		depth = 0;
+		engine = FRAMEREADER_SYNC;
+	}
+
+	int fd = -1;
+	if (direct) {
+		fd = open(fn, O_RDONLY | O_DIRECT);
+		if (fd < 0 && errno == EINVAL) {
+			direct = 0;     /* tmpfs and friends, buffered it is */
+		}
+	}
+	if (fd < 0) {
+		fd = open(fn, O_RDONLY);
+	}
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat s;
+	if (fstat(fd, &s) < 0) {
+		close(fd);
+		return NULL;
+	}
+	if (!direct) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+
+	struct framereader_s *r = new framereader_s;
+	r->fd = fd;
+	r->direct = direct;
+	r->frame_size = frame_size;
+	r->frames = s.st_size / frame_size;
+	r->nslots = depth + 1;
+	r->head = 0;
+	r->count = 0;
+	r->tail_nr = -1;
+	r->plan = NULL;
+	r->plan_count = 0;
+	r->plan_pos = 0;
+	r->held = 0;
+	r->terminate = 0;
+	memset(&r->uring, 0, sizeof(r->uring));
+	r->uring.fd = -1;
+
+	if (engine == FRAMEREADER_AUTO || engine == FRAMEREADER_URING) {
+		if (uring_setup(&r->uring, r->nslots) == 0) {
+			engine = FRAMEREADER_URING;
+		} else if (engine == FRAMEREADER_URING) {
+			close(fd);
+			delete r;
+			return NULL;
+		} else {
+			engine = FRAMEREADER_THREADS;
+		}
+	}
+	if (engine == FRAMEREADER_SYNC) {
+		r->nslots = 1;
+	}
+	r->engine = engine;
+
+	size_t buf_size = frame_size + (direct ? 2 * FRAMEREADER_ALIGN : 0);
+	r->slot = (struct framereader_slot_s *)calloc(r->nslots, sizeof(*r->slot));
+	for (int i = 0; r->slot && i < r->nslots; i++) {
+		/* Pool buffers are page aligned, as O_DIRECT wants */
+		r->slot[i].buf = (uint8_t *)arena_buffer_alloc(buf_size);
+		if (r->slot[i].buf == NULL) {
+			framereader_close(r);
+			return NULL;
+		}
+	}
+	if (r->slot == NULL) {
+		framereader_close(r);
+		return NULL;
+	}
+
+	if (engine == FRAMEREADER_THREADS) {
+		int threads = depth < FRAMEREADER_THREADS_MAX ? depth : FRAMEREADER_THREADS_MAX;
+		for (int i = 0; i < threads; i++) {
+			r->workers.push_back(std::thread(framereader_worker, r));
+		}
+	}
+
+	return r;
+}
+
+void framereader_close(struct framereader_s *r)
+{
+	if (r == NULL) {
+		return;
+	}
+
+	if (r->slot) {
+		framereader_drain(r);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(r->lock);
+		r->terminate = 1;
+	}
+	r->cond.notify_all();
+	for (size_t i = 0; i < r->workers.size(); i++) {
+		r->workers[i].join();
+	}
+
+	if (r->engine == FRAMEREADER_URING) {
+		uring_free(&r->uring);
+	}
+	for (int i = 0; r->slot && i < r->nslots; i++) {
+		arena_buffer_free(r->slot[i].buf);
+	}
+	free(r->slot);
+	close(r->fd);
+	delete r;
+}
+
+void framereader_plan(struct framereader_s *r, const int64_t *frames, int count)
+{
+	framereader_drain(r);
+	r->plan = frames;
+	r->plan_count = frames ? count : 0;
+	r->plan_pos = 0;
+}
+
+/* The frame to queue after last, the next one in the file or in the plan */
+static int64_t framereader_next(struct framereader_s *r, int64_t last)
+{
+	if (r->plan == NULL) {
+		return last + 1;
+	}
+	while (r->plan_pos < r->plan_count && r->plan[r->plan_pos] <= last) {
+		r->plan_pos++;
+	}
+	return r->plan_pos < r->plan_count ? r->plan[r->plan_pos] : -1;
+}
+
+unsigned char *framereader_read(struct framereader_s *r, int64_t nr)
+{
+	if (r->held) {
+		r->slot[r->head].state = SLOT_FREE;
+		r->head = (r->head + 1) % r->nslots;
+		r->count--;
+		r->held = 0;
+	}
+
+	if (r->count > 0 && nr != r->slot[r->head].nr) {
+		framereader_drain(r);
+	}
+	if (r->count == 0 && r->plan) {
+		/* Restarting, pick the plan up again after nr */
+		int lo = 0, hi = r->plan_count;
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (r->plan[mid] <= nr) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		r->plan_pos = lo;
+	}
+
+	if (nr < 0) {
+		return NULL;
+	}
+	if (nr >= r->frames) {
+		/* The file may have grown since it was opened */
+		struct stat s;
+		if (fstat(r->fd, &s) == 0) {
+			r->frames = s.st_size / r->frame_size;
+		}
+		if (nr >= r->frames) {
+			return NULL;
+		}
+	}
+
+	/* Top the queue up, then wait for the oldest */
+	while (r->count < r->nslots) {
+		int64_t next = r->count ? framereader_next(r, r->tail_nr) : nr;
+		if (next < 0 || next >= r->frames) {
+			break;
+		}
+		slot_start(r, (r->head + r->count) % r->nslots, next);
+		r->tail_nr = next;
+		r->count++;
+	}
+	if (r->engine == FRAMEREADER_URING && r->uring.unsubmitted) {
+		uring_enter(&r->uring, r->uring.unsubmitted, 0);
+	}
+
+	struct framereader_slot_s *s = &r->slot[r->head];
+	slot_wait(r, r->head);
+	r->held = 1;
+
+	if (s->result < 0 || (size_t)s->result < s->skew + r->frame_size) {
+		return NULL;
+	}
+
+	return s->buf + s->skew;
+}
+
+const char *framereader_engine_name(const struct framereader_s *r)
+{
+	switch (r->engine) {
+	case FRAMEREADER_URING:
+		return "io_uring";
+	case FRAMEREADER_THREADS:
+		return "threads";
+	default:
+		return "sync";
+	}
+}
+
+int framereader_direct(const struct framereader_s *r)
+{
+	return r->direct;
+}
+
+int framereader_engine_lookup(const char *name)
+{
+	if (strcmp(name, "auto") == 0) {
+		return FRAMEREADER_AUTO;
+	}
+	if (strcmp(name, "sync") == 0) {
+		return FRAMEREADER_SYNC;
+	}
+	if (strcmp(name, "threads") == 0) {
+		return FRAMEREADER_THREADS;
+	}
+	if (strcmp(name, "io_uring") == 0 || strcmp(name, "uring") == 0) {
+		return FRAMEREADER_URING;
+	}
+	return -1;
+}
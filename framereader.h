@@ -0,0 +1,63 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef FRAMEREADER_H
+#define FRAMEREADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Read ahead for raw frame files. The reader keeps up to depth frame reads in
+ * flight behind the frame the caller is working on, so the next frames are
+ * arriving from storage while the current one is measured. A 4K 4:2:0 frame is
+ * 12MB, a synchronous read per frame leaves the cpu idle for most of it.
+ *
+ * Engines, picked at open:
+ *   io_uring  reads submitted to the kernel ring, no extra threads. Used when the
+ *             kernel allows it, raw syscalls, no liburing needed.
+ *   threads   a few I/O threads doing pread, where io_uring isn't available.
+ *   sync      one pread per frame on the caller's thread, always at depth 0.
+ *
+ * With direct the file is opened O_DIRECT and read into page aligned buffers in
+ * block aligned spans, the frame doesn't pass through (or evict) the page cache.
+ * Filesystems that refuse O_DIRECT fall back to buffered reads.
+ *
+ * Frames are requested by number. Consecutive numbers, or the next entries of a
+ * plan, are served from the read ahead, any other number drops the queue and
+ * restarts there.
+ */
+
+#define FRAMEREADER_DEPTH_DEFAULT 4
+#define FRAMEREADER_THREADS_MAX 4
+#define FRAMEREADER_ALIGN 4096
+
+enum framereader_engine_e {
+	FRAMEREADER_AUTO = 0,       /* io_uring, else threads, sync at depth 0 */
+	FRAMEREADER_SYNC,
+	FRAMEREADER_THREADS,
+	FRAMEREADER_URING,
+};
+
+struct framereader_s;
+
+/* NULL if fn can't be opened, or the forced engine isn't available. */
+struct framereader_s *framereader_open(const char *fn, size_t frame_size, int depth, int engine, int direct);
+void framereader_close(struct framereader_s *r);
+
+/* Frame nr of the file, NULL past the end or on a read error. The buffer belongs
+ * to the reader and stays valid until the next call.
+ */
+unsigned char *framereader_read(struct framereader_s *r, int64_t nr);
+
+/* Read ahead through frames, ascending, instead of consecutive frames. The array
+ * must stay valid until the plan is replaced, NULL returns to consecutive frames.
+ */
+void framereader_plan(struct framereader_s *r, const int64_t *frames, int count);
+
+/* Engine in use, "io_uring", "threads" or "sync" */
+const char *framereader_engine_name(const struct framereader_s *r);
+int framereader_direct(const struct framereader_s *r);
+
+/* Engine by name, for the command line, -1 when unknown */
+int framereader_engine_lookup(const char *name);
+
+#endif /* FRAMEREADER_H */
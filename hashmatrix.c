@@ -0,0 +1,181 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "hashmatrix.h"
+#include "kernels.h"
+
+/* Pixel for a distance, 0 bright down to 64 (per hash word) black */
+static inline uint8_t hashmatrix_pixel(uint8_t d, int words)
+{
+	d /= words;
+	return d >= 64 ? 0 : 255 - (d * 4);
+}
+
+int hashmatrix_compute(struct hashmatrix_s *m, const uint64_t *a, int na, const uint64_t *b, int nb, int band, FILE *pgm)
+{
+	return hashmatrix_compute_words(m, &a, &b, 1, na, nb, band, pgm);
+}
+
+int hashmatrix_compute_words(struct hashmatrix_s *m, const uint64_t *const *a, const uint64_t *const *b, int words,
+	int na, int nb, int band, FILE *pgm)
+{
+	memset(m, 0, sizeof(*m));
+	m->na = na;
+	m->nb = nb;
+	m->near = HASHMATRIX_NEAR * words;
+	if (na <= 0 || nb <= 0 || words < 1 || words > HASHMATRIX_WORDS_MAX) {
+		return 0;
+	}
+
+	m->lo = -(na - 1);
+	m->hi = nb - 1;
+	if (band > 0) {
+		m->lo = m->lo < -band ? -band : m->lo;
+		m->hi = m->hi > band ? band : m->hi;
+	}
+	if (m->lo > m->hi) {
+		return 0;
+	}
+
+	int offsets = m->hi - m->lo + 1;
+	int width = band > 0 ? offsets : nb;
+	m->hist = (uint64_t *)calloc(offsets, sizeof(uint64_t));
+	int *run = (int *)calloc(offsets, sizeof(int));
+	int *last = (int *)calloc(offsets, sizeof(int));
+	uint8_t *dist = (uint8_t *)malloc(width);
+	uint8_t *part = words > 1 ? (uint8_t *)malloc(width) : NULL;
+	uint8_t *row = pgm ? (uint8_t *)malloc(width) : NULL;
+	if (m->hist == NULL || run == NULL || last == NULL || dist == NULL || (words > 1 && part == NULL) ||
+		(pgm && row == NULL)) {
+		free(run);
+		free(last);
+		free(dist);
+		free(part);
+		free(row);
+		hashmatrix_free(m);
+		return -1;
+	}
+
+	int ret = 0;
+	if (pgm && fprintf(pgm, "P5\n%d %d\n255\n", width, na) < 0) {
+		ret = -1;
+	}
+
+	const struct kernels_s *k = kernels_get();
+	int best_off = 0;
+
+	for (int i = 0; i < na; i++) {
+		/* Columns j = i + lo .. i + hi that exist in b */
+		int j0 = i + m->lo < 0 ? 0 : i + m->lo;
+		int j1 = i + m->hi >= nb ? nb - 1 : i + m->hi;
+		int n = j1 - j0 + 1;
+
+		if (n > 0) {
+			/* Words beyond the first add their distances, saturating, 4 x 64 only just overflows */
+			k->hamming_row_u64(a[0][i], b[0] + j0, dist, n);
+			for (int w = 1; w < words; w++) {
+				k->hamming_row_u64(a[w][i], b[w] + j0, part, n);
+				for (int x = 0; x < n; x++) {
+					int d = dist[x] + part[x];
+					dist[x] = d > 255 ? 255 : d;
+				}
+			}
+			m->cells += n;
+		}
+
+		/* Near pairs are rare off the aligned diagonals, skip 8 distances at a time
+		 * unless a byte is <= near. A diagonal's run continues when its last near
+		 * pair was on the row above, last[] holds that row + 1.
+		 */
+		int first = j0 - i - m->lo;
+		for (int x = 0; x < n; x += 8) {
+			if (x + 8 <= n) {
+				uint64_t w;
+				memcpy(&w, dist + x, sizeof(w));
+				/* Any byte under near + 1, exact for near < 128 whatever the other bytes hold */
+				if (((w - (0x0101010101010101ULL * (m->near + 1))) & ~w & 0x8080808080808080ULL) == 0) {
+					continue;
+				}
+			}
+			for (int y = x; y < x + 8 && y < n; y++) {
+				if (dist[y] > m->near) {
+					continue;
+				}
+				int o = first + y;
+				m->hist[o]++;
+				int len = run[o] = last[o] == i ? run[o] + 1 : 1;
+				last[o] = i + 1;
+				if (len > m->run_len || (len == m->run_len && o + m->lo < best_off)) {
+					m->run_len = len;
+					m->run_a = i - len + 1;
+					m->run_b = j0 + y - len + 1;
+					best_off = o + m->lo;
+				}
+			}
+		}
+
+		if (pgm && ret == 0) {
+			memset(row, 0, width);
+			int c0 = band > 0 ? first : j0;
+			for (int x = 0; x < n; x++) {
+				row[c0 + x] = hashmatrix_pixel(dist[x], words);
+			}
+			if (fwrite(row, 1, width, pgm) != (size_t)width) {
+				ret = -1;
+			}
+		}
+	}
+
+	free(run);
+	free(last);
+	free(dist);
+	free(part);
+	free(row);
+
+	return ret;
+}
+
+void hashmatrix_free(struct hashmatrix_s *m)
+{
+	free(m->hist);
+	m->hist = NULL;
+}
+
+void hashmatrix_print_histogram(const struct hashmatrix_s *m, FILE *fh, int top)
+{
+	if (m->hist == NULL) {
+		return;
+	}
+
+	int offsets = m->hi - m->lo + 1;
+	uint64_t total = 0;
+	for (int o = 0; o < offsets; o++) {
+		total += m->hist[o];
+	}
+	fprintf(fh, "# offset histogram: %" PRIu64 " near identical pairs (hamming <= %d) over offsets %+d .. %+d\n",
+		total, m->near, m->lo, m->hi);
+
+	/* Repeated selection, top is small */
+	uint8_t *taken = (uint8_t *)calloc(offsets, 1);
+	if (taken == NULL) {
+		return;
+	}
+	for (int t = 0; t < top; t++) {
+		int best = -1;
+		for (int o = 0; o < offsets; o++) {
+			if (!taken[o] && m->hist[o] && (best < 0 || m->hist[o] > m->hist[best])) {
+				best = o;
+			}
+		}
+		if (best < 0) {
+			break;
+		}
+		taken[best] = 1;
+		fprintf(fh, "#   offset %+6d: %8" PRIu64 " pairs, %5.1f%%\n", best + m->lo, m->hist[best],
+			(100.0 * m->hist[best]) / total);
+	}
+	free(taken);
+}
@@ -0,0 +1,57 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef HASHMATRIX_H
+#define HASHMATRIX_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Hamming distances between two DCT hash lists, for -D alignment.
+ *
+ * Row i of the matrix is file1 hash a[i] against a block of file2 hashes, one
+ * batched popcount pass (VPOPCNTQ on AVX-512, nibble tables on AVX2). With a
+ * band only the offsets -band .. +band (j - i) are computed, else the full
+ * na x nb matrix. A single pass over the rows yields:
+ *
+ *   - a histogram of near identical pairs by offset, the peak is where the two
+ *     captures line up, secondary peaks show cuts, loops and repeated content
+ *   - the longest run of near identical pairs along one diagonal, the aligned
+ *     stretch -D reports
+ *   - optionally the distance matrix itself as a PGM image, near pairs bright,
+ *     in (i, j) or, with a band, (i, offset) coordinates
+ */
+
+#define HASHMATRIX_NEAR 2           /* Hamming distance per hash word that counts as the same frame */
+#define HASHMATRIX_WORDS_MAX 4
+#define HASHMATRIX_TOP_DEFAULT 8    /* Histogram peaks printed */
+
+struct hashmatrix_s
+{
+	int na, nb;
+	int lo, hi;                     /* Offsets j - i covered */
+	uint64_t *hist;                 /* hi - lo + 1 near pair counts, by offset */
+	uint64_t cells;                 /* Distances computed */
+	int near;                       /* HASHMATRIX_NEAR per word */
+
+	/* Longest diagonal run, the first (lowest offset, then earliest) of equal runs */
+	int run_len;
+	int run_a, run_b;
+};
+
+/* band 0 computes the full matrix. pgm, when not NULL, receives the matrix.
+ * Returns 0, or -1 when out of memory or the image can't be written.
+ */
+int hashmatrix_compute(struct hashmatrix_s *m, const uint64_t *a, int na, const uint64_t *b, int nb, int band, FILE *pgm);
+
+/* Wider hashes stored planar, a[w][i] is word w of hash i, see fingerprint.h. The
+ * distance is the sum over the words.
+ */
+int hashmatrix_compute_words(struct hashmatrix_s *m, const uint64_t *const *a, const uint64_t *const *b, int words,
+	int na, int nb, int band, FILE *pgm);
+
+void hashmatrix_free(struct hashmatrix_s *m);
+
+/* "# offset" lines for the top peaks of the histogram, highest count first */
+void hashmatrix_print_histogram(const struct hashmatrix_s *m, FILE *fh, int top);
+
+#endif /* HASHMATRIX_H */
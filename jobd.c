@@ -0,0 +1,195 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "jobd.h"
+
+static struct {
+	int tool;
+	const char *name;
+} tools[] = {
+	{ JOBD_PICDIFF, "picdiff" },
+	{ JOBD_PIC2X2, "pic2x2" },
+	{ JOBD_PICVMAF, "picvmaf" },
+};
+
+const char *jobd_tool_name(int tool)
+{
+	for (size_t i = 0; i < (sizeof(tools) / sizeof(tools[0])); i++) {
+		if (tools[i].tool == tool) {
+			return tools[i].name;
+		}
+	}
+	return "unknown";
+}
+
+int jobd_tool_lookup(const char *name)
+{
+	for (size_t i = 0; i < (sizeof(tools) / sizeof(tools[0])); i++) {
+		if (strcmp(tools[i].name, name) == 0) {
+			return tools[i].tool;
+		}
+	}
+	return -1;
+}
+
+const char *jobd_socket_path(void)
+{
+	static char path[PATH_MAX];
+
+	const char *env = getenv(JOBD_SOCKET_ENV);
+	if (env && env[0]) {
+		return env;
+	}
+
+	const char *runtime = getenv("XDG_RUNTIME_DIR");
+	if (runtime && runtime[0]) {
+		snprintf(path, sizeof(path), "%s/%s", runtime, JOBD_SOCKET_NAME);
+		return path;
+	}
+
+	/* /tmp is shared, the directory has to be ours and closed to everyone else */
+	char dir[PATH_MAX];
+	snprintf(dir, sizeof(dir), JOBD_SOCKET_DIR, (unsigned int)geteuid());
+	if (mkdir(dir, 0700) < 0 && errno != EEXIST) {
+		return NULL;
+	}
+	struct stat s;
+	if (lstat(dir, &s) < 0 || !S_ISDIR(s.st_mode) || s.st_uid != geteuid() || (s.st_mode & 077)) {
+		return NULL;
+	}
+	snprintf(path, sizeof(path), "%s/%s", dir, JOBD_SOCKET_NAME);
+
+	return path;
+}
+
+static int jobd_address(const char *path, struct sockaddr_un *addr)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr->sun_path)) {
+		return -1;
+	}
+	strcpy(addr->sun_path, path);
+
+	return 0; /* Success */
+}
+
+int jobd_listen(const char *path)
+{
+	struct sockaddr_un addr;
+	if (jobd_address(path, &addr) < 0) {
+		return -1;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+
+	/* A stale socket from a previous run would fail the bind, but never remove someone else's file */
+	struct stat s;
+	if (lstat(path, &s) == 0) {
+		if (!S_ISSOCK(s.st_mode) || s.st_uid != geteuid()) {
+			close(fd);
+			errno = EEXIST;
+			return -1;
+		}
+		unlink(path);
+	}
+
+	/* Owner only from the start, no window where another user could connect */
+	mode_t mask = umask(077);
+	int ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+	umask(mask);
+	if (ret < 0 || listen(fd, 128) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int jobd_connect(const char *path)
+{
+	struct sockaddr_un addr;
+	if (jobd_address(path, &addr) < 0) {
+		return -1;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int jobd_peer_check(int fd)
+{
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0 || len != sizeof(cred)) {
+		return -1;
+	}
+
+	return cred.uid == geteuid() ? 0 : -1;
+}
+
+int jobd_read(int fd, void *buf, size_t len)
+{
+	uint8_t *p = (uint8_t *)buf;
+	while (len > 0) {
+		ssize_t r = read(fd, p, len);
+		if (r < 0 && errno == EINTR) {
+			continue;
+		}
+		if (r <= 0) {
+			return -1;
+		}
+		p += r;
+		len -= r;
+	}
+
+	return 0; /* Success */
+}
+
+int jobd_write(int fd, const void *buf, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	while (len > 0) {
+		ssize_t r = send(fd, p, len, MSG_NOSIGNAL);
+		if (r < 0 && errno == EINTR) {
+			continue;
+		}
+		if (r <= 0) {
+			return -1;
+		}
+		p += r;
+		len -= r;
+	}
+
+	return 0; /* Success */
+}
+
+void jobd_path_resolve(const char *dir, const char *fn, char *dst, size_t len)
+{
+	if (fn[0] == '/' || dir[0] == 0) {
+		snprintf(dst, len, "%s", fn);
+	} else {
+		snprintf(dst, len, "%s/%s", dir, fn);
+	}
+}
@@ -0,0 +1,87 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef JOBD_H
+#define JOBD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Wire protocol between vtjob (client) and vtjobd (the warm render server), over
+ * a local unix stream socket. One connection carries one job: the client writes
+ * a request, the server answers with a reply and closes. Both are fixed size
+ * structs in host byte order, client and server always share a host.
+ *
+ * File names are passed as typed, the server resolves relative names against cwd.
+ *
+ * The server reads and writes files with its own privileges, so only its own user
+ * may talk to it: the socket lives in a private directory, is created owner only
+ * and peers with another uid are turned away.
+ */
+
+#define JOBD_SOCKET_NAME "vmaftools.sock"
+#define JOBD_SOCKET_DIR "/tmp/vmaftools-%u"    /* Per uid, 0700, when there's no $XDG_RUNTIME_DIR */
+#define JOBD_SOCKET_DEFAULT "$XDG_RUNTIME_DIR/" JOBD_SOCKET_NAME ", else " JOBD_SOCKET_DIR "/" JOBD_SOCKET_NAME
+#define JOBD_SOCKET_ENV "VMAFTOOLS_SOCKET"
+#define JOBD_MAGIC 0x4a425456   /* "VTBJ" */
+#define JOBD_VERSION 2
+#define JOBD_PATH_MAX 1024
+#define JOBD_INPUTS_MAX 4
+
+enum jobd_tool_e {
+	JOBD_PICDIFF = 1,
+	JOBD_PIC2X2,
+	JOBD_PICVMAF,
+};
+
+struct jobd_request_s
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t tool;                  /* enum jobd_tool_e */
+	int32_t normalize;              /* picdiff -n */
+	int32_t render_title;           /* -t */
+	int32_t cursor;                 /* picvmaf -c */
+	int32_t verbose;
+	int32_t luma;                   /* picdiff -Y, raw YUV 4:2:0 inputs */
+	int32_t width;                  /* picdiff -W */
+	int32_t height;                 /* picdiff -H */
+	int32_t frame;                  /* picdiff -f */
+	char cwd[JOBD_PATH_MAX];
+	char fn[JOBD_INPUTS_MAX][JOBD_PATH_MAX]; /* -1 .. -4, picvmaf -i is fn[0] */
+	char outfn[JOBD_PATH_MAX];
+};
+
+struct jobd_reply_s
+{
+	uint32_t magic;
+	int32_t status;                 /* 0 success, -1 failed */
+	char message[512];
+	char output[256];               /* What the tool prints on stdout, picdiff -Y mse, or empty */
+};
+
+const char *jobd_tool_name(int tool);
+int jobd_tool_lookup(const char *name);     /* -1 if unknown */
+
+/* The socket to use, $VMAFTOOLS_SOCKET or the default. The default directory under
+ * /tmp is created when missing, NULL when it exists but isn't a private directory
+ * of ours.
+ */
+const char *jobd_socket_path(void);
+
+/* A leftover socket at path is replaced only when it's ours, anything else there
+ * fails with EEXIST.
+ */
+int jobd_listen(const char *path);
+int jobd_connect(const char *path);
+
+/* 0 when the connected peer runs as our uid, -1 otherwise */
+int jobd_peer_check(int fd);
+
+/* Read or write exactly len bytes, retrying short transfers. 0 on success, -1 on error or EOF. */
+int jobd_read(int fd, void *buf, size_t len);
+int jobd_write(int fd, const void *buf, size_t len);
+
+/* Join dir and fn into dst, unless fn is already absolute */
+void jobd_path_resolve(const char *dir, const char *fn, char *dst, size_t len);
+
+#endif /* JOBD_H */
@@ -0,0 +1,415 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <mutex>
+
+#include "kernels.h"
+#include "arena.h"
+
+uint64_t kernels_sse_u8_c(const uint8_t *a, const uint8_t *b, int n)
+{
+	uint64_t sse = 0;
+	for (int i = 0; i < n; i++) {
+		int d = a[i] - b[i];
+		sse += d * d;
+	}
+	return sse;
+}
+
+uint64_t kernels_sad_u8_c(const uint8_t *a, const uint8_t *b, int n)
+{
+	uint64_t sad = 0;
+	for (int i = 0; i < n; i++) {
+		sad += abs(a[i] - b[i]);
+	}
+	return sad;
+}
+
+void kernels_laplacian_row_c(const uint8_t *up, const uint8_t *cur, const uint8_t *dn, int w,
+	int64_t *sum, uint64_t *sumsq)
+{
+	int64_t s = 0;
+	uint64_t sq = 0;
+	for (int x = 1; x < w - 1; x++) {
+		int l = up[x] + dn[x] + cur[x - 1] + cur[x + 1] - (4 * cur[x]);
+		s += l;
+		sq += l * l;
+	}
+	*sum += s;
+	*sumsq += sq;
+}
+
+void kernels_area_rows8_c(const uint8_t *src, int stride, int width, int rows, const struct kernels_area_tab_s *tab,
+	int count, float *acc)
+{
+	for (int k = 0; k < count; k++) {
+		const uint8_t *p = src + tab[k].si;
+		float *d = acc + (tab[k].di * 8);
+		for (int r = 0; r < rows; r++) {
+			d[r] += (float)p[(size_t)r * stride] * tab[k].alpha;
+		}
+	}
+}
+
+void kernels_hamming_u64_c(const uint64_t *a, const uint64_t *b, uint8_t *dist, int n)
+{
+	for (int i = 0; i < n; i++) {
+		uint64_t v = a[i] ^ b[i];
+		/* Portable popcount, this path must run on any cpu */
+		v = v - ((v >> 1) & 0x5555555555555555ULL);
+		v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+		v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		dist[i] = (v * 0x0101010101010101ULL) >> 56;
+	}
+}
+
+void kernels_hamming_row_u64_c(uint64_t a, const uint64_t *b, uint8_t *dist, int n)
+{
+	for (int i = 0; i < n; i++) {
+		uint64_t v = a ^ b[i];
+		v = v - ((v >> 1) & 0x5555555555555555ULL);
+		v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+		v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		dist[i] = (v * 0x0101010101010101ULL) >> 56;
+	}
+}
+
+void kernels_absdiff_u8_c(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n)
+{
+	for (int i = 0; i < n; i++) {
+		dst[i] = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+	}
+}
+
+void kernels_absdiff_minmax_u8_c(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, uint8_t *min, uint8_t *max)
+{
+	uint8_t lo = 255, hi = 0;
+	for (int i = 0; i < n; i++) {
+		uint8_t d = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+		dst[i] = d;
+		if (d < lo) {
+			lo = d;
+		}
+		if (d > hi) {
+			hi = d;
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+void kernels_minmax_u8_c(const uint8_t *src, int n, uint8_t *min, uint8_t *max)
+{
+	uint8_t lo = 255, hi = 0;
+	for (int i = 0; i < n; i++) {
+		if (src[i] < lo) {
+			lo = src[i];
+		}
+		if (src[i] > hi) {
+			hi = src[i];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+void kernels_downsample2_row_c(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int dw)
+{
+	for (int i = 0; i < dw; i++) {
+		dst[i] = (r0[2 * i] + r0[(2 * i) + 1] + r1[2 * i] + r1[(2 * i) + 1] + 2) >> 2;
+	}
+}
+
+void kernels_init_scalar(struct kernels_s *k)
+{
+	k->isa = KERNELS_SCALAR;
+	k->name = kernels_isa_name(KERNELS_SCALAR);
+	k->sse_u8 = kernels_sse_u8_c;
+	k->sad_u8 = kernels_sad_u8_c;
+	k->laplacian_row = kernels_laplacian_row_c;
+	k->area_rows8 = kernels_area_rows8_c;
+	k->hamming_u64 = kernels_hamming_u64_c;
+	k->hamming_row_u64 = kernels_hamming_row_u64_c;
+	k->absdiff_u8 = kernels_absdiff_u8_c;
+	k->minmax_u8 = kernels_minmax_u8_c;
+	k->absdiff_minmax_u8 = kernels_absdiff_minmax_u8_c;
+	k->downsample2_row = kernels_downsample2_row_c;
+}
+
+const char *kernels_isa_name(enum kernels_isa_e isa)
+{
+	switch (isa) {
+	case KERNELS_SCALAR: return "scalar";
+	case KERNELS_SSE42:  return "sse42";
+	case KERNELS_AVX2:   return "avx2";
+	case KERNELS_AVX512: return "avx512";
+	}
+	return "unknown";
+}
+
+enum kernels_isa_e kernels_detect(void)
+{
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) {
+		return KERNELS_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+		return KERNELS_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+		return KERNELS_SSE42;
+	}
+	return KERNELS_SCALAR;
+}
+
+static struct kernels_s g_kernels;
+static std::once_flag g_kernels_once;
+
+/* Build the table for isa, each level layers over the one below it */
+static void kernels_build(struct kernels_s *k, enum kernels_isa_e isa)
+{
+	kernels_init_scalar(k);
+	if (isa >= KERNELS_SSE42) {
+		kernels_init_sse42(k);
+	}
+	if (isa >= KERNELS_AVX2) {
+		kernels_init_avx2(k);
+	}
+	if (isa >= KERNELS_AVX512) {
+		kernels_init_avx512(k);
+	}
+	k->isa = isa;
+	k->name = kernels_isa_name(isa);
+}
+
+static void kernels_select(void)
+{
+	enum kernels_isa_e isa = kernels_detect();
+
+	const char *env = getenv("VMAF_TOOLS_ISA");
+	if (env && *env) {
+		int found = 0;
+		for (int i = KERNELS_SCALAR; i <= KERNELS_AVX512; i++) {
+			if (strcmp(env, kernels_isa_name((enum kernels_isa_e)i)) == 0) {
+				found = 1;
+				if (i <= isa) {
+					isa = (enum kernels_isa_e)i;
+				} else {
+					fprintf(stderr, "VMAF_TOOLS_ISA=%s not supported by this cpu, using %s\n",
+						env, kernels_isa_name(isa));
+				}
+			}
+		}
+		if (!found) {
+			fprintf(stderr, "VMAF_TOOLS_ISA=%s unknown, using %s\n", env, kernels_isa_name(isa));
+		}
+	}
+
+	kernels_build(&g_kernels, isa);
+}
+
+const struct kernels_s *kernels_get(void)
+{
+	std::call_once(g_kernels_once, kernels_select);
+	return &g_kernels;
+}
+
+int kernels_force(const char *name)
+{
+	/* Make sure the default selection can't later overwrite the forced one */
+	kernels_get();
+
+	for (int i = KERNELS_SCALAR; i <= KERNELS_AVX512; i++) {
+		if (strcmp(name, kernels_isa_name((enum kernels_isa_e)i)) == 0) {
+			if (i > kernels_detect()) {
+				return -1;
+			}
+			kernels_build(&g_kernels, (enum kernels_isa_e)i);
+			return 0; /* Success */
+		}
+	}
+
+	return -1;
+}
+
+double kernels_laplacian_variance(const uint8_t *src, int stride, int width, int height)
+{
+	const struct kernels_s *k = kernels_get();
+
+	if (width < 2 || height < 2) {
+		return 0.0;
+	}
+
+	int64_t sum = 0;
+	uint64_t sumsq = 0;
+
+	for (int y = 0; y < height; y++) {
+		/* Reflect 101 borders, row -1 is row 1, row h is row h - 2 */
+		const uint8_t *cur = src + ((size_t)y * stride);
+		const uint8_t *up = src + ((size_t)(y == 0 ? 1 : y - 1) * stride);
+		const uint8_t *dn = src + ((size_t)(y == height - 1 ? height - 2 : y + 1) * stride);
+
+		k->laplacian_row(up, cur, dn, width, &sum, &sumsq);
+
+		/* The two edge columns, column -1 is column 1 and column w is w - 2 */
+		int l = up[0] + dn[0] + (2 * cur[1]) - (4 * cur[0]);
+		sum += l;
+		sumsq += l * l;
+
+		int e = width - 1;
+		l = up[e] + dn[e] + (2 * cur[e - 1]) - (4 * cur[e]);
+		sum += l;
+		sumsq += l * l;
+	}
+
+	double count = (double)width * height;
+	double mean = sum / count;
+
+	return (sumsq / count) - (mean * mean);
+}
+
+/* The weights, as OpenCV's computeResizeAreaTab() */
+static int area_tab(int ssize, int dsize, double scale, struct kernels_area_tab_s *tab)
+{
+	int k = 0;
+
+	for (int dx = 0; dx < dsize; dx++) {
+		double fsx1 = dx * scale;
+		double fsx2 = fsx1 + scale;
+		double cell = scale < ssize - fsx1 ? scale : ssize - fsx1;
+
+		int sx1 = (int)ceil(fsx1);
+		int sx2 = (int)floor(fsx2);
+		sx2 = sx2 < ssize - 1 ? sx2 : ssize - 1;
+		sx1 = sx1 < sx2 ? sx1 : sx2;
+
+		if (sx1 - fsx1 > 1e-3) {
+			tab[k].di = dx;
+			tab[k].si = sx1 - 1;
+			tab[k++].alpha = (float)((sx1 - fsx1) / cell);
+		}
+		for (int sx = sx1; sx < sx2; sx++) {
+			tab[k].di = dx;
+			tab[k].si = sx;
+			tab[k++].alpha = (float)(1.0 / cell);
+		}
+		if (fsx2 - sx2 > 1e-3) {
+			double w = fsx2 - sx2 < 1.0 ? fsx2 - sx2 : 1.0;
+			tab[k].di = dx;
+			tab[k].si = sx2;
+			tab[k++].alpha = (float)((w < cell ? w : cell) / cell);
+		}
+	}
+
+	return k;
+}
+
+static float area_round(float v)
+{
+	/* saturate_cast<uchar>(float), round half to even then clamp */
+	float r = rintf(v);
+	return r < 0.0f ? 0.0f : r > 255.0f ? 255.0f : r;
+}
+
+/* Integer factors, OpenCV's resizeAreaFast: an integer box sum, 2x2 rounds half up
+ * (its SIMD path), anything else is scaled by the float reciprocal.
+ */
+static void downsample_area_fast(const uint8_t *src, int stride, float *dst, int dw, int dh, int fx, int fy)
+{
+	float scale = 1.0f / (fx * fy);
+
+	for (int oy = 0; oy < dh; oy++) {
+		const uint8_t *s = src + ((size_t)oy * fy * stride);
+		for (int ox = 0; ox < dw; ox++) {
+			int sum = 0;
+			for (int y = 0; y < fy; y++) {
+				for (int x = 0; x < fx; x++) {
+					sum += s[((size_t)y * stride) + (ox * fx) + x];
+				}
+			}
+			if (fx == 2 && fy == 2) {
+				dst[(oy * dw) + ox] = (float)((sum + 2) >> 2);
+			} else {
+				dst[(oy * dw) + ox] = area_round(sum * scale);
+			}
+		}
+	}
+}
+
+int kernels_downsample_area(const uint8_t *src, int stride, int width, int height, float *dst, int dw, int dh)
+{
+	/* Downsample only */
+	if (width < dw || height < dh) {
+		return -1;
+	}
+
+	/* cv::resize(INTER_AREA) bit for bit, the DCT hashes have always been taken on
+	 * its thumbnail: the same scale factors, weight tables, float accumulation
+	 * order and rounding.
+	 */
+	double sx = 1.0 / ((double)dw / width);
+	double sy = 1.0 / ((double)dh / height);
+	int fx = (int)rint(sx);
+	int fy = (int)rint(sy);
+	if (fabs(sx - fx) < DBL_EPSILON && fabs(sy - fy) < DBL_EPSILON) {
+		downsample_area_fast(src, stride, dst, dw, dh, fx, fy);
+		return 0; /* Success */
+	}
+
+	const struct kernels_s *k = kernels_get();
+	struct arena_s *arena = arena_thread();
+	size_t mark = arena_mark(arena);
+	int blocks = (height + 7) / 8;
+	struct kernels_area_tab_s *xtab = (struct kernels_area_tab_s *)arena_alloc(arena, (size_t)width * 2 * sizeof(*xtab));
+	struct kernels_area_tab_s *ytab = (struct kernels_area_tab_s *)arena_alloc(arena, (size_t)height * 2 * sizeof(*ytab));
+	float *rows = (float *)arena_alloc(arena, (size_t)blocks * dw * 8 * sizeof(float));
+	float *sum = (float *)arena_alloc(arena, (size_t)dw * sizeof(float));
+	if (xtab == NULL || ytab == NULL || rows == NULL || sum == NULL) {
+		arena_release(arena, mark);
+		return -1;
+	}
+	int xn = area_tab(width, dw, sx, xtab);
+	int yn = area_tab(height, dh, sy, ytab);
+
+	/* Horizontal pass, each source row's weighted sums once, 8 rows a block, output
+	 * x of row y at rows[y / 8][x][y % 8]. OpenCV redoes a row shared by two
+	 * outputs, the result is the same.
+	 */
+	memset(rows, 0, (size_t)blocks * dw * 8 * sizeof(float));
+	for (int b = 0; b < blocks; b++) {
+		int n = height - (b * 8) < 8 ? height - (b * 8) : 8;
+		k->area_rows8(src + ((size_t)b * 8 * stride), stride, width, n, xtab, xn, rows + ((size_t)b * dw * 8));
+	}
+
+	/* Vertical pass, in table order, an output row is written when the next starts */
+	int prev = ytab[0].di;
+	memset(sum, 0, (size_t)dw * sizeof(float));
+	for (int j = 0; j < yn; j++) {
+		const float *r = rows + ((size_t)(ytab[j].si / 8) * dw * 8) + (ytab[j].si % 8);
+		float beta = ytab[j].alpha;
+
+		if (ytab[j].di != prev) {
+			for (int ox = 0; ox < dw; ox++) {
+				dst[(prev * dw) + ox] = area_round(sum[ox]);
+				sum[ox] = beta * r[ox * 8];
+			}
+			prev = ytab[j].di;
+		} else {
+			for (int ox = 0; ox < dw; ox++) {
+				sum[ox] += beta * r[ox * 8];
+			}
+		}
+	}
+	for (int ox = 0; ox < dw; ox++) {
+		dst[(prev * dw) + ox] = area_round(sum[ox]);
+	}
+
+	arena_release(arena, mark);
+
+	return 0; /* Success */
+}
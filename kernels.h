@@ -0,0 +1,117 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+
+/* Hot pixel kernels, built once per ISA (scalar, SSE4.2, AVX2, AVX-512BW) and
+ * chosen at startup by cpuid. Every variant produces bit identical results, so
+ * forcing a path (VMAF_TOOLS_ISA=scalar|sse42|avx2|avx512 in the environment, or
+ * the tools' -x option) is safe for testing and benchmarking.
+ */
+
+/* An INTER_AREA weight, source pixel si adds alpha of itself to output di */
+struct kernels_area_tab_s
+{
+	int di;
+	int si;
+	float alpha;
+};
+
+enum kernels_isa_e {
+	KERNELS_SCALAR = 0,
+	KERNELS_SSE42,
+	KERNELS_AVX2,
+	KERNELS_AVX512,
+};
+
+struct kernels_s
+{
+	enum kernels_isa_e isa;
+	const char *name;
+
+	/* Sum of squared / absolute differences over n bytes */
+	uint64_t (*sse_u8)(const uint8_t *a, const uint8_t *b, int n);
+	uint64_t (*sad_u8)(const uint8_t *a, const uint8_t *b, int n);
+
+	/* 3x3 (ksize 1) Laplacian of cur, columns 1 .. w - 2, given the rows above
+	 * and below. Adds the sum and sum of squares of the responses.
+	 */
+	void (*laplacian_row)(const uint8_t *up, const uint8_t *cur, const uint8_t *dn, int w,
+		int64_t *sum, uint64_t *sumsq);
+
+	/* Horizontal half of the hash area downsample, for rows (up to 8) source rows
+	 * at once: acc[di * 8 + r] += src[r][si] * alpha for each table entry in order,
+	 * si never decreasing. A separate multiply and add per entry, as cv::resize
+	 * does them, so every path matches it bit for bit.
+	 */
+	void (*area_rows8)(const uint8_t *src, int stride, int width, int rows, const struct kernels_area_tab_s *tab,
+		int count, float *acc);
+
+	/* dist[i] = popcount(a[i] ^ b[i]) */
+	void (*hamming_u64)(const uint64_t *a, const uint64_t *b, uint8_t *dist, int n);
+
+	/* dist[i] = popcount(a ^ b[i]), one hash against a block, a row of a distance matrix */
+	void (*hamming_row_u64)(uint64_t a, const uint64_t *b, uint8_t *dist, int n);
+
+	/* dst[i] = |a[i] - b[i]| */
+	void (*absdiff_u8)(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n);
+
+	/* Minimum and maximum of n bytes, n > 0 */
+	void (*minmax_u8)(const uint8_t *src, int n, uint8_t *min, uint8_t *max);
+
+	/* absdiff_u8 that also returns the minimum and maximum difference, one pass */
+	void (*absdiff_minmax_u8)(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, uint8_t *min, uint8_t *max);
+
+	/* 2x2 box decimation of two source rows, dst[i] = rounded mean of r0/r1[2i, 2i + 1] */
+	void (*downsample2_row)(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int dw);
+};
+
+/* The kernels for this cpu, selected on first use. Thread safe. */
+const struct kernels_s *kernels_get(void);
+
+/* Force a specific path by name, before or after first use.
+ * Returns -1 if the name is unknown or the cpu can't run it.
+ */
+int kernels_force(const char *name);
+
+/* Highest ISA the cpu supports */
+enum kernels_isa_e kernels_detect(void);
+
+const char *kernels_isa_name(enum kernels_isa_e isa);
+
+/* Composite helpers built on the table */
+
+/* Variance of the ksize 1 Laplacian, with reflect 101 borders, identical to
+ * cv::Laplacian() + cv::meanStdDev() on an 8bit single channel plane.
+ */
+double kernels_laplacian_variance(const uint8_t *src, int stride, int width, int height);
+
+/* cv::resize(INTER_AREA) downsample of an 8bit plane to dw x dh, bit for bit, 8bit
+ * values returned as floats ready for the hash DCT. -1 when dw x dh is larger in
+ * either direction or out of scratch memory.
+ */
+int kernels_downsample_area(const uint8_t *src, int stride, int width, int height, float *dst, int dw, int dh);
+
+/* Per ISA table initializers, each only overrides what it implements */
+void kernels_init_scalar(struct kernels_s *k);
+void kernels_init_sse42(struct kernels_s *k);
+void kernels_init_avx2(struct kernels_s *k);
+void kernels_init_avx512(struct kernels_s *k);
+
+/* Scalar versions, also used by the SIMD variants for tails */
+uint64_t kernels_sse_u8_c(const uint8_t *a, const uint8_t *b, int n);
+uint64_t kernels_sad_u8_c(const uint8_t *a, const uint8_t *b, int n);
+void kernels_laplacian_row_c(const uint8_t *up, const uint8_t *cur, const uint8_t *dn, int w,
+	int64_t *sum, uint64_t *sumsq);
+void kernels_area_rows8_c(const uint8_t *src, int stride, int width, int rows, const struct kernels_area_tab_s *tab,
+	int count, float *acc);
+void kernels_hamming_u64_c(const uint64_t *a, const uint64_t *b, uint8_t *dist, int n);
+void kernels_hamming_row_u64_c(uint64_t a, const uint64_t *b, uint8_t *dist, int n);
+void kernels_absdiff_u8_c(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n);
+void kernels_minmax_u8_c(const uint8_t *src, int n, uint8_t *min, uint8_t *max);
+void kernels_absdiff_minmax_u8_c(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, uint8_t *min, uint8_t *max);
+void kernels_downsample2_row_c(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int dw);
+
+#endif /* KERNELS_H */
@@ -0,0 +1,334 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+/* Built with -mavx2 -mpopcnt, only installed when cpuid reports both. */
+
+#include <immintrin.h>
+
+#include "kernels.h"
+
+static inline uint64_t hsum_epi64_avx2(__m256i v)
+{
+	__m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	return (uint64_t)_mm_cvtsi128_si64(s) + (uint64_t)_mm_extract_epi64(s, 1);
+}
+
+static uint64_t sse_u8_avx2(const uint8_t *a, const uint8_t *b, int n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc64 = zero;
+	int i = 0;
+
+	while (i + 16 <= n) {
+		/* A 32bit lane gains at most 2 * 65025 per pass, flush every 4096 passes */
+		int end = i + (16 * 4096);
+		if (end > n) {
+			end = n;
+		}
+
+		__m256i acc = zero;
+		for (; i + 16 <= end; i += 16) {
+			__m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(a + i)));
+			__m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + i)));
+			__m256i d = _mm256_sub_epi16(va, vb);
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+		}
+		acc64 = _mm256_add_epi64(acc64, _mm256_unpacklo_epi32(acc, zero));
+		acc64 = _mm256_add_epi64(acc64, _mm256_unpackhi_epi32(acc, zero));
+	}
+
+	return hsum_epi64_avx2(acc64) + kernels_sse_u8_c(a + i, b + i, n - i);
+}
+
+static uint64_t sad_u8_avx2(const uint8_t *a, const uint8_t *b, int n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	int i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+	}
+
+	return hsum_epi64_avx2(acc) + kernels_sad_u8_c(a + i, b + i, n - i);
+}
+
+static void laplacian_row_avx2(const uint8_t *up, const uint8_t *cur, const uint8_t *dn, int w,
+	int64_t *sum, uint64_t *sumsq)
+{
+	const __m256i ones = _mm256_set1_epi16(1);
+	int64_t s = 0;
+	uint64_t sq = 0;
+	int x = 1;
+
+	/* 16 responses per pass, the right neighbour load reaches x + 16 */
+	while (x + 16 <= w - 1) {
+		__m256i vs = _mm256_setzero_si256();
+		__m256i vsq = _mm256_setzero_si256();
+
+		/* A lane gains at most 2 * 1020^2 per pass, 512 passes stay inside int32 */
+		for (int pass = 0; pass < 512 && x + 16 <= w - 1; pass++, x += 16) {
+			__m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(up + x)));
+			__m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(dn + x)));
+			__m256i l = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cur + x - 1)));
+			__m256i r = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cur + x + 1)));
+			__m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(cur + x)));
+
+			__m256i v = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(u, d), _mm256_add_epi16(l, r)),
+				_mm256_slli_epi16(c, 2));
+			vs = _mm256_add_epi32(vs, _mm256_madd_epi16(v, ones));
+			vsq = _mm256_add_epi32(vsq, _mm256_madd_epi16(v, v));
+		}
+
+		int32_t ls[8], lsq[8];
+		_mm256_storeu_si256((__m256i *)ls, vs);
+		_mm256_storeu_si256((__m256i *)lsq, vsq);
+		for (int i = 0; i < 8; i++) {
+			s += ls[i];
+			sq += (uint32_t)lsq[i];
+		}
+	}
+
+	*sum += s;
+	*sumsq += sq;
+
+	if (x < w - 1) {
+		kernels_laplacian_row_c(up + x - 1, cur + x - 1, dn + x - 1, w - x + 1, sum, sumsq);
+	}
+}
+
+/* Bytes 0 .. 15 of 8 rows, transposed to 16 columns of 8 bytes */
+static inline void transpose8x16(const uint8_t *src, int stride, uint8_t *dst)
+{
+	__m128i r[8];
+	for (int i = 0; i < 8; i++) {
+		r[i] = _mm_loadu_si128((const __m128i *)(src + ((size_t)i * stride)));
+	}
+
+	__m128i a0 = _mm_unpacklo_epi8(r[0], r[1]), a1 = _mm_unpackhi_epi8(r[0], r[1]);
+	__m128i a2 = _mm_unpacklo_epi8(r[2], r[3]), a3 = _mm_unpackhi_epi8(r[2], r[3]);
+	__m128i a4 = _mm_unpacklo_epi8(r[4], r[5]), a5 = _mm_unpackhi_epi8(r[4], r[5]);
+	__m128i a6 = _mm_unpacklo_epi8(r[6], r[7]), a7 = _mm_unpackhi_epi8(r[6], r[7]);
+
+	__m128i b0 = _mm_unpacklo_epi16(a0, a2), b1 = _mm_unpackhi_epi16(a0, a2);
+	__m128i b2 = _mm_unpacklo_epi16(a1, a3), b3 = _mm_unpackhi_epi16(a1, a3);
+	__m128i b4 = _mm_unpacklo_epi16(a4, a6), b5 = _mm_unpackhi_epi16(a4, a6);
+	__m128i b6 = _mm_unpacklo_epi16(a5, a7), b7 = _mm_unpackhi_epi16(a5, a7);
+
+	_mm_storeu_si128((__m128i *)(dst + 0), _mm_unpacklo_epi32(b0, b4));
+	_mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi32(b0, b4));
+	_mm_storeu_si128((__m128i *)(dst + 32), _mm_unpacklo_epi32(b1, b5));
+	_mm_storeu_si128((__m128i *)(dst + 48), _mm_unpackhi_epi32(b1, b5));
+	_mm_storeu_si128((__m128i *)(dst + 64), _mm_unpacklo_epi32(b2, b6));
+	_mm_storeu_si128((__m128i *)(dst + 80), _mm_unpackhi_epi32(b2, b6));
+	_mm_storeu_si128((__m128i *)(dst + 96), _mm_unpacklo_epi32(b3, b7));
+	_mm_storeu_si128((__m128i *)(dst + 112), _mm_unpackhi_epi32(b3, b7));
+}
+
+/* The 8 rows of a column are the 8 lanes, 16 columns are transposed at a time as
+ * the table walks along the row. One output's accumulator stays in a register
+ * for its entries.
+ */
+static void area_rows8_avx2(const uint8_t *src, int stride, int width, int rows, const struct kernels_area_tab_s *tab,
+	int count, float *acc)
+{
+	if (rows < 8 || width < 16) {
+		kernels_area_rows8_c(src, stride, width, rows, tab, count, acc);
+		return;
+	}
+
+	uint8_t cols[16 * 8];
+	int x0 = -16;
+	int k = 0;
+
+	while (k < count) {
+		int di = tab[k].di;
+		__m256 sum = _mm256_loadu_ps(acc + (di * 8));
+
+		for (; k < count && tab[k].di == di; k++) {
+			int si = tab[k].si;
+			if (si >= x0 + 16) {
+				x0 = si + 16 <= width ? si : width - 16;
+				transpose8x16(src + x0, stride, cols);
+			}
+			__m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(cols + ((si - x0) * 8)))));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(v, _mm256_set1_ps(tab[k].alpha)));
+		}
+
+		_mm256_storeu_ps(acc + (di * 8), sum);
+	}
+}
+
+/* Nibble table popcount (Mula), four hashes per pass */
+static void hamming_u64_avx2(const uint64_t *a, const uint64_t *b, uint8_t *dist, int n)
+{
+	const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8(0x0f);
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)),
+			_mm256_loadu_si256((const __m256i *)(b + i)));
+		__m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+		__m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+		__m256i cnt = _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+
+		dist[i + 0] = _mm256_extract_epi64(cnt, 0);
+		dist[i + 1] = _mm256_extract_epi64(cnt, 1);
+		dist[i + 2] = _mm256_extract_epi64(cnt, 2);
+		dist[i + 3] = _mm256_extract_epi64(cnt, 3);
+	}
+
+	for (; i < n; i++) {
+		dist[i] = _mm_popcnt_u64(a[i] ^ b[i]);
+	}
+}
+
+/* Mula again, a broadcast against 16 hashes per pass, the four sad results packed to bytes */
+static void hamming_row_u64_avx2(uint64_t a, const uint64_t *b, uint8_t *dist, int n)
+{
+	const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low = _mm256_set1_epi8(0x0f);
+	const __m256i va = _mm256_set1_epi64x((long long)a);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m128i order = _mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m256i cnt[4];
+		for (int q = 0; q < 4; q++) {
+			__m256i v = _mm256_xor_si256(va, _mm256_loadu_si256((const __m256i *)(b + i + (4 * q))));
+			__m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+			__m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+			cnt[q] = _mm256_sad_epu8(_mm256_add_epi8(lo, hi), zero);
+		}
+
+		/* Each count sits in the low word of a qword, pack 16 of them down in order */
+		__m256i w01 = _mm256_packus_epi32(cnt[0], cnt[1]);
+		__m256i w23 = _mm256_packus_epi32(cnt[2], cnt[3]);
+		__m256i w = _mm256_packus_epi32(w01, w23);
+		__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, zero), 0x08);
+
+		/* Now hashes 0, 1, 4, 5, 8, 9, 12, 13, then 2, 3, 6, 7, 10, 11, 14, 15 */
+		__m128i v = _mm_shuffle_epi8(_mm256_castsi256_si128(bytes), order);
+		_mm_storeu_si128((__m128i *)(dist + i), v);
+	}
+
+	for (; i < n; i++) {
+		dist[i] = _mm_popcnt_u64(a ^ b[i]);
+	}
+}
+
+static void absdiff_u8_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n)
+{
+	int i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va)));
+	}
+
+	kernels_absdiff_u8_c(a + i, b + i, dst + i, n - i);
+}
+
+static void minmax_u8_avx2(const uint8_t *src, int n, uint8_t *min, uint8_t *max)
+{
+	__m256i vmin = _mm256_set1_epi8((char)255);
+	__m256i vmax = _mm256_setzero_si256();
+	int i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		vmin = _mm256_min_epu8(vmin, v);
+		vmax = _mm256_max_epu8(vmax, v);
+	}
+
+	uint8_t lmin[32], lmax[32];
+	_mm256_storeu_si256((__m256i *)lmin, vmin);
+	_mm256_storeu_si256((__m256i *)lmax, vmax);
+
+	uint8_t lo, hi;
+	kernels_minmax_u8_c(src + i, n - i, &lo, &hi);
+	for (int j = 0; j < 32; j++) {
+		if (lmin[j] < lo) {
+			lo = lmin[j];
+		}
+		if (lmax[j] > hi) {
+			hi = lmax[j];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+static void absdiff_minmax_u8_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, uint8_t *min, uint8_t *max)
+{
+	__m256i vmin = _mm256_set1_epi8((char)255);
+	__m256i vmax = _mm256_setzero_si256();
+	int i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+		__m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+		_mm256_storeu_si256((__m256i *)(dst + i), d);
+		vmin = _mm256_min_epu8(vmin, d);
+		vmax = _mm256_max_epu8(vmax, d);
+	}
+
+	uint8_t lmin[32], lmax[32];
+	_mm256_storeu_si256((__m256i *)(lmin), vmin);
+	_mm256_storeu_si256((__m256i *)(lmax), vmax);
+
+	uint8_t lo, hi;
+	kernels_absdiff_minmax_u8_c(a + i, b + i, dst + i, n - i, &lo, &hi);
+	for (int j = 0; j < 32; j++) {
+		if (lmin[j] < lo) {
+			lo = lmin[j];
+		}
+		if (lmax[j] > hi) {
+			hi = lmax[j];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+static void downsample2_row_avx2(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int dw)
+{
+	const __m256i ones = _mm256_set1_epi8(1);
+	const __m256i two = _mm256_set1_epi16(2);
+	int i = 0;
+
+	for (; i + 32 <= dw; i += 32) {
+		__m256i lo = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r0 + (2 * i))), ones),
+			_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r1 + (2 * i))), ones));
+		__m256i hi = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r0 + (2 * i) + 32)), ones),
+			_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r1 + (2 * i) + 32)), ones));
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+
+		/* packus works per 128 bit lane, put the quarters back in order */
+		__m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+
+	kernels_downsample2_row_c(r0 + (2 * i), r1 + (2 * i), dst + i, dw - i);
+}
+
+void kernels_init_avx2(struct kernels_s *k)
+{
+	k->sse_u8 = sse_u8_avx2;
+	k->sad_u8 = sad_u8_avx2;
+	k->laplacian_row = laplacian_row_avx2;
+	k->area_rows8 = area_rows8_avx2;
+	k->hamming_u64 = hamming_u64_avx2;
+	k->hamming_row_u64 = hamming_row_u64_avx2;
+	k->absdiff_u8 = absdiff_u8_avx2;
+	k->minmax_u8 = minmax_u8_avx2;
+	k->absdiff_minmax_u8 = absdiff_minmax_u8_avx2;
+	k->downsample2_row = downsample2_row_avx2;
+}
@@ -0,0 +1,245 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+/* Built with -mavx512f -mavx512bw -mavx512vl, only installed when cpuid
+ * reports AVX-512BW and VL. VPOPCNTQ is a separate extension, its kernel
+ * carries its own target attribute and is only installed when present.
+ */
+
+#include <immintrin.h>
+
+#include "kernels.h"
+
+static uint64_t sse_u8_avx512(const uint8_t *a, const uint8_t *b, int n)
+{
+	const __m512i zero = _mm512_setzero_si512();
+	__m512i acc64 = zero;
+	int i = 0;
+
+	while (i + 32 <= n) {
+		/* A 32bit lane gains at most 2 * 65025 per pass, flush every 4096 passes */
+		int end = i + (32 * 4096);
+		if (end > n) {
+			end = n;
+		}
+
+		__m512i acc = zero;
+		for (; i + 32 <= end; i += 32) {
+			__m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(a + i)));
+			__m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(b + i)));
+			__m512i d = _mm512_sub_epi16(va, vb);
+			acc = _mm512_add_epi32(acc, _mm512_madd_epi16(d, d));
+		}
+		acc64 = _mm512_add_epi64(acc64, _mm512_unpacklo_epi32(acc, zero));
+		acc64 = _mm512_add_epi64(acc64, _mm512_unpackhi_epi32(acc, zero));
+	}
+
+	return (uint64_t)_mm512_reduce_add_epi64(acc64) + kernels_sse_u8_c(a + i, b + i, n - i);
+}
+
+static uint64_t sad_u8_avx512(const uint8_t *a, const uint8_t *b, int n)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int i = 0;
+
+	for (; i + 64 <= n; i += 64) {
+		__m512i va = _mm512_loadu_si512((const void *)(a + i));
+		__m512i vb = _mm512_loadu_si512((const void *)(b + i));
+		acc = _mm512_add_epi64(acc, _mm512_sad_epu8(va, vb));
+	}
+
+	return (uint64_t)_mm512_reduce_add_epi64(acc) + kernels_sad_u8_c(a + i, b + i, n - i);
+}
+
+static void laplacian_row_avx512(const uint8_t *up, const uint8_t *cur, const uint8_t *dn, int w,
+	int64_t *sum, uint64_t *sumsq)
+{
+	const __m512i ones = _mm512_set1_epi16(1);
+	int64_t s = 0;
+	uint64_t sq = 0;
+	int x = 1;
+
+	/* 32 responses per pass, the right neighbour load reaches x + 32 */
+	while (x + 32 <= w - 1) {
+		__m512i vs = _mm512_setzero_si512();
+		__m512i vsq = _mm512_setzero_si512();
+
+		/* A lane gains at most 2 * 1020^2 per pass, 512 passes stay inside int32 */
+		for (int pass = 0; pass < 512 && x + 32 <= w - 1; pass++, x += 32) {
+			__m512i u = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(up + x)));
+			__m512i d = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(dn + x)));
+			__m512i l = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(cur + x - 1)));
+			__m512i r = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(cur + x + 1)));
+			__m512i c = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(cur + x)));
+
+			__m512i v = _mm512_sub_epi16(_mm512_add_epi16(_mm512_add_epi16(u, d), _mm512_add_epi16(l, r)),
+				_mm512_slli_epi16(c, 2));
+			vs = _mm512_add_epi32(vs, _mm512_madd_epi16(v, ones));
+			vsq = _mm512_add_epi32(vsq, _mm512_madd_epi16(v, v));
+		}
+
+		int32_t ls[16], lsq[16];
+		_mm512_storeu_si512((void *)ls, vs);
+		_mm512_storeu_si512((void *)lsq, vsq);
+		for (int i = 0; i < 16; i++) {
+			s += ls[i];
+			sq += (uint32_t)lsq[i];
+		}
+	}
+
+	*sum += s;
+	*sumsq += sq;
+
+	if (x < w - 1) {
+		kernels_laplacian_row_c(up + x - 1, cur + x - 1, dn + x - 1, w - x + 1, sum, sumsq);
+	}
+}
+
+__attribute__((target("avx512vpopcntdq")))
+static void hamming_u64_avx512(const uint64_t *a, const uint64_t *b, uint8_t *dist, int n)
+{
+	int i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m512i v = _mm512_xor_si512(_mm512_loadu_si512((const void *)(a + i)), _mm512_loadu_si512((const void *)(b + i)));
+		_mm_storel_epi64((__m128i *)(dist + i), _mm512_cvtepi64_epi8(_mm512_popcnt_epi64(v)));
+	}
+
+	for (; i < n; i++) {
+		dist[i] = _mm_popcnt_u64(a[i] ^ b[i]);
+	}
+}
+
+__attribute__((target("avx512vpopcntdq")))
+static void hamming_row_u64_avx512(uint64_t a, const uint64_t *b, uint8_t *dist, int n)
+{
+	const __m512i va = _mm512_set1_epi64((long long)a);
+	int i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m512i c0 = _mm512_popcnt_epi64(_mm512_xor_si512(va, _mm512_loadu_si512((const void *)(b + i))));
+		__m512i c1 = _mm512_popcnt_epi64(_mm512_xor_si512(va, _mm512_loadu_si512((const void *)(b + i + 8))));
+		__m512i c2 = _mm512_popcnt_epi64(_mm512_xor_si512(va, _mm512_loadu_si512((const void *)(b + i + 16))));
+		__m512i c3 = _mm512_popcnt_epi64(_mm512_xor_si512(va, _mm512_loadu_si512((const void *)(b + i + 24))));
+		_mm_storel_epi64((__m128i *)(dist + i), _mm512_cvtepi64_epi8(c0));
+		_mm_storel_epi64((__m128i *)(dist + i + 8), _mm512_cvtepi64_epi8(c1));
+		_mm_storel_epi64((__m128i *)(dist + i + 16), _mm512_cvtepi64_epi8(c2));
+		_mm_storel_epi64((__m128i *)(dist + i + 24), _mm512_cvtepi64_epi8(c3));
+	}
+	for (; i + 8 <= n; i += 8) {
+		__m512i c = _mm512_popcnt_epi64(_mm512_xor_si512(va, _mm512_loadu_si512((const void *)(b + i))));
+		_mm_storel_epi64((__m128i *)(dist + i), _mm512_cvtepi64_epi8(c));
+	}
+
+	for (; i < n; i++) {
+		dist[i] = _mm_popcnt_u64(a ^ b[i]);
+	}
+}
+
+static void absdiff_u8_avx512(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n)
+{
+	int i = 0;
+
+	for (; i + 64 <= n; i += 64) {
+		__m512i va = _mm512_loadu_si512((const void *)(a + i));
+		__m512i vb = _mm512_loadu_si512((const void *)(b + i));
+		_mm512_storeu_si512((void *)(dst + i), _mm512_or_si512(_mm512_subs_epu8(va, vb), _mm512_subs_epu8(vb, va)));
+	}
+
+	kernels_absdiff_u8_c(a + i, b + i, dst + i, n - i);
+}
+
+static void minmax_u8_avx512(const uint8_t *src, int n, uint8_t *min, uint8_t *max)
+{
+	__m512i vmin = _mm512_set1_epi8((char)255);
+	__m512i vmax = _mm512_setzero_si512();
+	int i = 0;
+
+	for (; i + 64 <= n; i += 64) {
+		__m512i v = _mm512_loadu_si512((const void *)(src + i));
+		vmin = _mm512_min_epu8(vmin, v);
+		vmax = _mm512_max_epu8(vmax, v);
+	}
+
+	uint8_t lmin[64], lmax[64];
+	_mm512_storeu_si512((void *)lmin, vmin);
+	_mm512_storeu_si512((void *)lmax, vmax);
+
+	uint8_t lo, hi;
+	kernels_minmax_u8_c(src + i, n - i, &lo, &hi);
+	for (int j = 0; j < 64; j++) {
+		if (lmin[j] < lo) {
+			lo = lmin[j];
+		}
+		if (lmax[j] > hi) {
+			hi = lmax[j];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+static void absdiff_minmax_u8_avx512(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, uint8_t *min, uint8_t *max)
+{
+	__m512i vmin = _mm512_set1_epi8((char)255);
+	__m512i vmax = _mm512_setzero_si512();
+	int i = 0;
+
+	for (; i + 64 <= n; i += 64) {
+		__m512i va = _mm512_loadu_si512((const void *)(a + i));
+		__m512i vb = _mm512_loadu_si512((const void *)(b + i));
+		__m512i d = _mm512_or_si512(_mm512_subs_epu8(va, vb), _mm512_subs_epu8(vb, va));
+		_mm512_storeu_si512((void *)(dst + i), d);
+		vmin = _mm512_min_epu8(vmin, d);
+		vmax = _mm512_max_epu8(vmax, d);
+	}
+
+	uint8_t lmin[64], lmax[64];
+	_mm512_storeu_si512((void *)(lmin), vmin);
+	_mm512_storeu_si512((void *)(lmax), vmax);
+
+	uint8_t lo, hi;
+	kernels_absdiff_minmax_u8_c(a + i, b + i, dst + i, n - i, &lo, &hi);
+	for (int j = 0; j < 64; j++) {
+		if (lmin[j] < lo) {
+			lo = lmin[j];
+		}
+		if (lmax[j] > hi) {
+			hi = lmax[j];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+/* The sums are at most 255 after the shift, vpmovwb narrows without a lane fixup */
+static void downsample2_row_avx512(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int dw)
+{
+	const __m512i ones = _mm512_set1_epi8(1);
+	const __m512i two = _mm512_set1_epi16(2);
+	int i = 0;
+
+	for (; i + 32 <= dw; i += 32) {
+		__m512i s = _mm512_add_epi16(_mm512_maddubs_epi16(_mm512_loadu_si512((const void *)(r0 + (2 * i))), ones),
+			_mm512_maddubs_epi16(_mm512_loadu_si512((const void *)(r1 + (2 * i))), ones));
+		s = _mm512_srli_epi16(_mm512_add_epi16(s, two), 2);
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm512_cvtepi16_epi8(s));
+	}
+
+	kernels_downsample2_row_c(r0 + (2 * i), r1 + (2 * i), dst + i, dw - i);
+}
+
+void kernels_init_avx512(struct kernels_s *k)
+{
+	k->sse_u8 = sse_u8_avx512;
+	k->sad_u8 = sad_u8_avx512;
+	k->laplacian_row = laplacian_row_avx512;
+	k->absdiff_u8 = absdiff_u8_avx512;
+	k->minmax_u8 = minmax_u8_avx512;
+	k->absdiff_minmax_u8 = absdiff_minmax_u8_avx512;
+	k->downsample2_row = downsample2_row_avx512;
+
+	if (__builtin_cpu_supports("avx512vpopcntdq")) {
+		k->hamming_u64 = hamming_u64_avx512;
+		k->hamming_row_u64 = hamming_row_u64_avx512;
+	}
+}
@@ -0,0 +1,289 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+/* Built with -msse4.2 -mpopcnt, only installed when cpuid reports both. */
+
+#include <string.h>
+#include <nmmintrin.h>
+#include <smmintrin.h>
+
+#include "kernels.h"
+
+static uint64_t sse_u8_sse42(const uint8_t *a, const uint8_t *b, int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc64 = zero;
+	int i = 0;
+
+	while (i + 16 <= n) {
+		/* Each pass adds at most 4 * 65025 to a 32bit lane, flush to 64bit
+		 * lanes well before they can overflow.
+		 */
+		int end = i + (16 * 4096);
+		if (end > n) {
+			end = n;
+		}
+
+		__m128i acc = zero;
+		for (; i + 16 <= end; i += 16) {
+			__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+			__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+			__m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+			__m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, lo));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, hi));
+		}
+		acc64 = _mm_add_epi64(acc64, _mm_unpacklo_epi32(acc, zero));
+		acc64 = _mm_add_epi64(acc64, _mm_unpackhi_epi32(acc, zero));
+	}
+
+	uint64_t sse = (uint64_t)_mm_cvtsi128_si64(acc64) + (uint64_t)_mm_extract_epi64(acc64, 1);
+
+	return sse + kernels_sse_u8_c(a + i, b + i, n - i);
+}
+
+static uint64_t sad_u8_sse42(const uint8_t *a, const uint8_t *b, int n)
+{
+	__m128i acc = _mm_setzero_si128();
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+
+	uint64_t sad = (uint64_t)_mm_cvtsi128_si64(acc) + (uint64_t)_mm_extract_epi64(acc, 1);
+
+	return sad + kernels_sad_u8_c(a + i, b + i, n - i);
+}
+
+static void laplacian_row_sse42(const uint8_t *up, const uint8_t *cur, const uint8_t *dn, int w,
+	int64_t *sum, uint64_t *sumsq)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	int64_t s = 0;
+	uint64_t sq = 0;
+	int x = 1;
+
+	/* 8 responses per pass, the right neighbour load reaches x + 8 */
+	while (x + 8 <= w - 1) {
+		__m128i vs = _mm_setzero_si128();
+		__m128i vsq = _mm_setzero_si128();
+
+		/* A lane gains at most 2 * 1020^2 per pass, 512 passes stay inside int32 */
+		for (int pass = 0; pass < 512 && x + 8 <= w - 1; pass++, x += 8) {
+			__m128i u = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(up + x)));
+			__m128i d = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(dn + x)));
+			__m128i l = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(cur + x - 1)));
+			__m128i r = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(cur + x + 1)));
+			__m128i c = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(cur + x)));
+
+			__m128i v = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(u, d), _mm_add_epi16(l, r)), _mm_slli_epi16(c, 2));
+			vs = _mm_add_epi32(vs, _mm_madd_epi16(v, ones));
+			vsq = _mm_add_epi32(vsq, _mm_madd_epi16(v, v));
+		}
+
+		int32_t ls[4], lsq[4];
+		_mm_storeu_si128((__m128i *)ls, vs);
+		_mm_storeu_si128((__m128i *)lsq, vsq);
+		for (int i = 0; i < 4; i++) {
+			s += ls[i];
+			sq += (uint32_t)lsq[i];
+		}
+	}
+
+	*sum += s;
+	*sumsq += sq;
+
+	/* Remaining columns, the scalar kernel starts at its own x = 1 */
+	if (x < w - 1) {
+		kernels_laplacian_row_c(up + x - 1, cur + x - 1, dn + x - 1, w - x + 1, sum, sumsq);
+	}
+}
+
+/* Bytes 0 .. 15 of 8 rows, transposed to 16 columns of 8 bytes */
+static inline void transpose8x16(const uint8_t *src, int stride, uint8_t *dst)
+{
+	__m128i r[8];
+	for (int i = 0; i < 8; i++) {
+		r[i] = _mm_loadu_si128((const __m128i *)(src + ((size_t)i * stride)));
+	}
+
+	__m128i a0 = _mm_unpacklo_epi8(r[0], r[1]), a1 = _mm_unpackhi_epi8(r[0], r[1]);
+	__m128i a2 = _mm_unpacklo_epi8(r[2], r[3]), a3 = _mm_unpackhi_epi8(r[2], r[3]);
+	__m128i a4 = _mm_unpacklo_epi8(r[4], r[5]), a5 = _mm_unpackhi_epi8(r[4], r[5]);
+	__m128i a6 = _mm_unpacklo_epi8(r[6], r[7]), a7 = _mm_unpackhi_epi8(r[6], r[7]);
+
+	__m128i b0 = _mm_unpacklo_epi16(a0, a2), b1 = _mm_unpackhi_epi16(a0, a2);
+	__m128i b2 = _mm_unpacklo_epi16(a1, a3), b3 = _mm_unpackhi_epi16(a1, a3);
+	__m128i b4 = _mm_unpacklo_epi16(a4, a6), b5 = _mm_unpackhi_epi16(a4, a6);
+	__m128i b6 = _mm_unpacklo_epi16(a5, a7), b7 = _mm_unpackhi_epi16(a5, a7);
+
+	_mm_storeu_si128((__m128i *)(dst + 0), _mm_unpacklo_epi32(b0, b4));
+	_mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi32(b0, b4));
+	_mm_storeu_si128((__m128i *)(dst + 32), _mm_unpacklo_epi32(b1, b5));
+	_mm_storeu_si128((__m128i *)(dst + 48), _mm_unpackhi_epi32(b1, b5));
+	_mm_storeu_si128((__m128i *)(dst + 64), _mm_unpacklo_epi32(b2, b6));
+	_mm_storeu_si128((__m128i *)(dst + 80), _mm_unpackhi_epi32(b2, b6));
+	_mm_storeu_si128((__m128i *)(dst + 96), _mm_unpacklo_epi32(b3, b7));
+	_mm_storeu_si128((__m128i *)(dst + 112), _mm_unpackhi_epi32(b3, b7));
+}
+
+/* As the AVX2 version, the 8 lanes split over two registers */
+static void area_rows8_sse42(const uint8_t *src, int stride, int width, int rows, const struct kernels_area_tab_s *tab,
+	int count, float *acc)
+{
+	if (rows < 8 || width < 16) {
+		kernels_area_rows8_c(src, stride, width, rows, tab, count, acc);
+		return;
+	}
+
+	uint8_t cols[16 * 8];
+	int x0 = -16;
+	int k = 0;
+
+	while (k < count) {
+		int di = tab[k].di;
+		__m128 lo = _mm_loadu_ps(acc + (di * 8));
+		__m128 hi = _mm_loadu_ps(acc + (di * 8) + 4);
+
+		for (; k < count && tab[k].di == di; k++) {
+			int si = tab[k].si;
+			if (si >= x0 + 16) {
+				x0 = si + 16 <= width ? si : width - 16;
+				transpose8x16(src + x0, stride, cols);
+			}
+			__m128i b = _mm_loadl_epi64((const __m128i *)(cols + ((si - x0) * 8)));
+			__m128 alpha = _mm_set1_ps(tab[k].alpha);
+			lo = _mm_add_ps(lo, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(b)), alpha));
+			hi = _mm_add_ps(hi, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(b, 4))), alpha));
+		}
+
+		_mm_storeu_ps(acc + (di * 8), lo);
+		_mm_storeu_ps(acc + (di * 8) + 4, hi);
+	}
+}
+
+static void hamming_u64_sse42(const uint64_t *a, const uint64_t *b, uint8_t *dist, int n)
+{
+	for (int i = 0; i < n; i++) {
+		dist[i] = _mm_popcnt_u64(a[i] ^ b[i]);
+	}
+}
+
+static void hamming_row_u64_sse42(uint64_t a, const uint64_t *b, uint8_t *dist, int n)
+{
+	for (int i = 0; i < n; i++) {
+		dist[i] = _mm_popcnt_u64(a ^ b[i]);
+	}
+}
+
+static void absdiff_u8_sse42(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n)
+{
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)));
+	}
+
+	kernels_absdiff_u8_c(a + i, b + i, dst + i, n - i);
+}
+
+static void minmax_u8_sse42(const uint8_t *src, int n, uint8_t *min, uint8_t *max)
+{
+	__m128i vmin = _mm_set1_epi8((char)255);
+	__m128i vmax = _mm_setzero_si128();
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		vmin = _mm_min_epu8(vmin, v);
+		vmax = _mm_max_epu8(vmax, v);
+	}
+
+	uint8_t lmin[16], lmax[16];
+	_mm_storeu_si128((__m128i *)lmin, vmin);
+	_mm_storeu_si128((__m128i *)lmax, vmax);
+
+	uint8_t lo, hi;
+	kernels_minmax_u8_c(src + i, n - i, &lo, &hi);
+	for (int j = 0; j < 16; j++) {
+		if (lmin[j] < lo) {
+			lo = lmin[j];
+		}
+		if (lmax[j] > hi) {
+			hi = lmax[j];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+static void absdiff_minmax_u8_sse42(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, uint8_t *min, uint8_t *max)
+{
+	__m128i vmin = _mm_set1_epi8((char)255);
+	__m128i vmax = _mm_setzero_si128();
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+		vmin = _mm_min_epu8(vmin, d);
+		vmax = _mm_max_epu8(vmax, d);
+	}
+
+	uint8_t lmin[16], lmax[16];
+	_mm_storeu_si128((__m128i *)(lmin), vmin);
+	_mm_storeu_si128((__m128i *)(lmax), vmax);
+
+	uint8_t lo, hi;
+	kernels_absdiff_minmax_u8_c(a + i, b + i, dst + i, n - i, &lo, &hi);
+	for (int j = 0; j < 16; j++) {
+		if (lmin[j] < lo) {
+			lo = lmin[j];
+		}
+		if (lmax[j] > hi) {
+			hi = lmax[j];
+		}
+	}
+	*min = lo;
+	*max = hi;
+}
+
+/* Horizontal pairs summed by maddubs against ones, 16 outputs per pass */
+static void downsample2_row_sse42(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int dw)
+{
+	const __m128i ones = _mm_set1_epi8(1);
+	const __m128i two = _mm_set1_epi16(2);
+	int i = 0;
+
+	for (; i + 16 <= dw; i += 16) {
+		__m128i lo = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r0 + (2 * i))), ones),
+			_mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r1 + (2 * i))), ones));
+		__m128i hi = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r0 + (2 * i) + 16)), ones),
+			_mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r1 + (2 * i) + 16)), ones));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	kernels_downsample2_row_c(r0 + (2 * i), r1 + (2 * i), dst + i, dw - i);
+}
+
+void kernels_init_sse42(struct kernels_s *k)
+{
+	k->sse_u8 = sse_u8_sse42;
+	k->sad_u8 = sad_u8_sse42;
+	k->laplacian_row = laplacian_row_sse42;
+	k->area_rows8 = area_rows8_sse42;
+	k->hamming_u64 = hamming_u64_sse42;
+	k->hamming_row_u64 = hamming_row_u64_sse42;
+	k->absdiff_u8 = absdiff_u8_sse42;
+	k->minmax_u8 = minmax_u8_sse42;
+	k->absdiff_minmax_u8 = absdiff_minmax_u8_sse42;
+	k->downsample2_row = downsample2_row_sse42;
+}
@@ -0,0 +1,113 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "manifest.h"
+
+const char *manifest_mode_name(int mode)
+{
+	switch (mode) {
+	case MANIFEST_EVERY:
+		return "every";
+	case MANIFEST_SAMPLE:
+		return "sample";
+	default:
+		return "mse";
+	}
+}
+
+static int manifest_field(struct manifest_pair_s *p, const char *tok)
+{
+	if (strncmp(tok, "size=", 5) == 0) {
+		return sscanf(tok + 5, "%dx%d", &p->width, &p->height) == 2 && p->width > 0 && p->height > 0 ? 0 : -1;
+	}
+	if (strncmp(tok, "report=", 7) == 0) {
+		if (strlen(tok + 7) == 0 || strlen(tok + 7) >= sizeof(p->reportfn)) {
+			return -1;
+		}
+		strcpy(p->reportfn, tok + 7);
+		return 0;
+	}
+	if (strcmp(tok, "mode=mse") == 0) {
+		p->mode = MANIFEST_MSE;
+		return 0;
+	}
+	if (sscanf(tok, "mode=every:%d", &p->n) == 1 && p->n > 0) {
+		p->mode = MANIFEST_EVERY;
+		return 0;
+	}
+	if (sscanf(tok, "mode=sample:%d", &p->n) == 1 && p->n > 0) {
+		p->mode = MANIFEST_SAMPLE;
+		return 0;
+	}
+	return -1;
+}
+
+int manifest_load(const char *fn, struct manifest_pair_s **pairs, int *count)
+{
+	FILE *fh = fopen(fn, "rb");
+	if (fh == NULL) {
+		return -1;
+	}
+
+	int c = 0, allocated = 0, nr = 0;
+	struct manifest_pair_s *list = NULL;
+
+	char line[4096];
+	while (fgets(&line[0], sizeof(line), fh)) {
+		nr++;
+
+		char *save = NULL;
+		char *tok = strtok_r(line, " \t\r\n", &save);
+		if (tok == NULL || tok[0] == '#') {
+			continue;
+		}
+
+		if (c == allocated) {
+			allocated = allocated ? allocated * 2 : 64;
+			struct manifest_pair_s *n = (struct manifest_pair_s *)realloc(list, allocated * sizeof(*list));
+			if (n == NULL) {
+				free(list);
+				fclose(fh);
+				return -1;
+			}
+			list = n;
+		}
+
+		struct manifest_pair_s *p = &list[c];
+		memset(p, 0, sizeof(*p));
+		p->line = nr;
+
+		int fields = 0, bad = 0;
+		for (; tok && !bad; tok = strtok_r(NULL, " \t\r\n", &save)) {
+			if (fields < 2) {
+				if (strlen(tok) >= sizeof(p->fn[0])) {
+					bad = 1;
+				} else {
+					strcpy(p->fn[fields++], tok);
+				}
+			} else if (manifest_field(p, tok) < 0) {
+				bad = 1;
+			}
+		}
+		if (bad || fields < 2) {
+			free(list);
+			fclose(fh);
+			return -(nr + 1);
+		}
+
+		if (p->reportfn[0] == 0) {
+			snprintf(p->reportfn, sizeof(p->reportfn), "batch_%03d.txt", c);
+		}
+		c++;
+	}
+
+	fclose(fh);
+
+	*pairs = list;
+	*count = c;
+
+	return 0; /* Success */
+}
@@ -0,0 +1,43 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+/* Batch manifest for yuvmse -J, one comparison per line:
+ *
+ *   reference.yuv distorted.yuv [size=WxH] [mode=mse|every:N|sample:N] [report=file.txt]
+ *
+ * Fields are separated by white space, so paths can't contain any. Blank lines
+ * and lines starting with '#' are skipped. Without size= the geometry is detected
+ * from the file sizes, or the command line -W/-H apply. Without report= the
+ * report goes to batch_NNN.txt, NNN the pair's line order in the manifest.
+ */
+
+#define MANIFEST_PATH_MAX 1024
+
+enum manifest_mode_e {
+	MANIFEST_MSE = 0,           /* Every frame */
+	MANIFEST_EVERY,             /* Every Nth frame */
+	MANIFEST_SAMPLE,            /* N stratified random frames */
+};
+
+struct manifest_pair_s
+{
+	char fn[2][MANIFEST_PATH_MAX];
+	char reportfn[MANIFEST_PATH_MAX];
+	int width;                  /* 0 when not given */
+	int height;
+	int mode;
+	int n;                      /* every:N, sample:N */
+	int line;                   /* In the manifest, for messages */
+};
+
+/* On success *pairs is a malloc'd array of *count pairs, owned by the caller.
+ * Returns 0 on success, -1 if the file can't be read, or -(line + 1) for the
+ * first malformed line.
+ */
+int manifest_load(const char *fn, struct manifest_pair_s **pairs, int *count);
+
+const char *manifest_mode_name(int mode);
+
+#endif /* MANIFEST_H */
@@ -0,0 +1,437 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "metrics.h"
+#include "vmafcsv.h"
+
+static const char *series_names[METRICS_SERIES] = { "VMAF", "PSNR Y", "MSE Y", "Sharpness" };
+static const char *series_short[METRICS_SERIES] = { "vmaf", "psnr", "mse", "sharpness" };
+
+const char *metrics_series_name(int series)
+{
+	if (series < 0 || series >= METRICS_SERIES) {
+		return "unknown";
+	}
+	return series_names[series];
+}
+
+int metrics_series_lookup(const char *name)
+{
+	for (int i = 0; i < METRICS_SERIES; i++) {
+		if (strcmp(name, series_short[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Column c, frame_nr first, then the series, then the hashes */
+#define METRICS_COLUMNS (1 + METRICS_SERIES + METRICS_HASHES)
+
+static size_t column_width(int c)
+{
+	return c <= METRICS_SERIES ? sizeof(uint32_t) : sizeof(uint64_t);
+}
+
+/* The 4 byte columns come first, an even capacity keeps the hashes 8 byte aligned */
+static off_t column_offset(uint32_t capacity, int c)
+{
+	off_t offset = sizeof(struct metrics_file_header_s);
+	for (int i = 0; i < c; i++) {
+		offset += (off_t)column_width(i) * capacity;
+	}
+	return offset;
+}
+
+static uint32_t round_capacity(int64_t frames)
+{
+	return frames > 0 ? (uint32_t)((frames + 1) & ~1) : 0;
+}
+
+static int write_at(int fd, const void *buf, size_t len, off_t offset)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	while (len) {
+		ssize_t n = pwrite(fd, p, len, offset);
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		len -= n;
+		offset += n;
+	}
+
+	return 0; /* Success */
+}
+
+static int read_at(int fd, void *buf, size_t len, off_t offset)
+{
+	uint8_t *p = (uint8_t *)buf;
+	while (len) {
+		ssize_t n = pread(fd, p, len, offset);
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		len -= n;
+		offset += n;
+	}
+
+	return 0; /* Success */
+}
+
+/* memmove within the file, back to front when moving towards the end */
+static int move_at(int fd, off_t dst, off_t src, size_t len)
+{
+	uint8_t buf[65536];
+
+	while (len) {
+		size_t n = len < sizeof(buf) ? len : sizeof(buf);
+		off_t from = dst > src ? src + (off_t)(len - n) : src;
+		off_t to = dst > src ? dst + (off_t)(len - n) : dst;
+		if (read_at(fd, buf, n, from) < 0 || write_at(fd, buf, n, to) < 0) {
+			return -1;
+		}
+		if (dst < src) {
+			src += n;
+			dst += n;
+		}
+		len -= n;
+	}
+
+	return 0; /* Success */
+}
+
+static int write_header(struct metrics_writer_s *w)
+{
+	struct metrics_file_header_s hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, METRICS_MAGIC, sizeof(hdr.magic));
+	hdr.version = METRICS_VERSION;
+	hdr.series = METRICS_SERIES;
+	hdr.hashes = METRICS_HASHES;
+	hdr.capacity = w->capacity;
+	hdr.frames = w->frames;
+
+	return write_at(w->fd, &hdr, sizeof(hdr), 0);
+}
+
+/* Moves the written part of each column to its place for capacity */
+static int resize(struct metrics_writer_s *w, uint32_t capacity)
+{
+	if (capacity > w->capacity) {
+		if (ftruncate(w->fd, column_offset(capacity, METRICS_COLUMNS)) < 0) {
+			return -1;
+		}
+		/* Columns only move towards the end, the last one first */
+		for (int c = METRICS_COLUMNS - 1; c > 0; c--) {
+			if (move_at(w->fd, column_offset(capacity, c), column_offset(w->capacity, c),
+				column_width(c) * w->frames) < 0) {
+				return -1;
+			}
+		}
+	} else {
+		for (int c = 1; c < METRICS_COLUMNS; c++) {
+			if (move_at(w->fd, column_offset(capacity, c), column_offset(w->capacity, c),
+				column_width(c) * w->frames) < 0) {
+				return -1;
+			}
+		}
+		if (ftruncate(w->fd, column_offset(capacity, METRICS_COLUMNS)) < 0) {
+			return -1;
+		}
+	}
+	w->capacity = capacity;
+
+	return write_header(w);
+}
+
+int metrics_writer_open(struct metrics_writer_s *w, const char *fn, int capacity, int resume)
+{
+	memset(w, 0, sizeof(*w));
+
+	if (resume >= 0) {
+		w->fd = open(fn, O_RDWR);
+		if (w->fd < 0) {
+			return -1;
+		}
+		struct metrics_file_header_s hdr;
+		if (read_at(w->fd, &hdr, sizeof(hdr), 0) < 0 || memcmp(hdr.magic, METRICS_MAGIC, sizeof(hdr.magic)) != 0 ||
+			hdr.version != METRICS_VERSION || hdr.series != METRICS_SERIES || hdr.hashes != METRICS_HASHES ||
+			(uint32_t)resume > hdr.frames) {
+			close(w->fd);
+			return -1;
+		}
+		/* Frames past the checkpoint are written again */
+		w->capacity = hdr.capacity;
+		w->frames = resume;
+	} else {
+		w->fd = open(fn, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (w->fd < 0) {
+			return -1;
+		}
+		w->capacity = round_capacity(capacity > 0 ? capacity : 4096);
+		if (ftruncate(w->fd, column_offset(w->capacity, METRICS_COLUMNS)) < 0) {
+			close(w->fd);
+			return -1;
+		}
+	}
+
+	if (write_header(w) < 0) {
+		close(w->fd);
+		return -1;
+	}
+
+	return 0; /* Success */
+}
+
+int metrics_writer_append(struct metrics_writer_s *w, const struct metrics_frame_s *frame)
+{
+	if (w->frames == w->capacity && resize(w, round_capacity((int64_t)w->capacity * 2)) < 0) {
+		return -1;
+	}
+
+	const void *cell[METRICS_COLUMNS];
+	cell[0] = &frame->frame_nr;
+	for (int i = 0; i < METRICS_SERIES; i++) {
+		cell[1 + i] = &frame->value[i];
+	}
+	for (int i = 0; i < METRICS_HASHES; i++) {
+		cell[1 + METRICS_SERIES + i] = &frame->hash[i];
+	}
+
+	for (int c = 0; c < METRICS_COLUMNS; c++) {
+		size_t width = column_width(c);
+		if (write_at(w->fd, cell[c], width, column_offset(w->capacity, c) + ((off_t)width * w->frames)) < 0) {
+			return -1;
+		}
+	}
+
+	/* Only now is the frame visible to readers */
+	w->frames++;
+	return write_at(w->fd, &w->frames, sizeof(w->frames), offsetof(struct metrics_file_header_s, frames));
+}
+
+int metrics_writer_close(struct metrics_writer_s *w)
+{
+	int ret = resize(w, round_capacity(w->frames));
+	if (close(w->fd) < 0) {
+		ret = -1;
+	}
+	memset(w, 0, sizeof(*w));
+
+	return ret;
+}
+
+int metrics_map(const char *fn, struct metrics_map_s *map)
+{
+	memset(map, 0, sizeof(*map));
+
+	int fd = open(fn, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct stat s;
+	if (fstat(fd, &s) < 0 || (size_t)s.st_size < sizeof(struct metrics_file_header_s)) {
+		close(fd);
+		return -1;
+	}
+
+	void *addr = mmap(NULL, s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		return -1;
+	}
+
+	const struct metrics_file_header_s *hdr = (const struct metrics_file_header_s *)addr;
+	if (memcmp(hdr->magic, METRICS_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != METRICS_VERSION ||
+		hdr->series != METRICS_SERIES || hdr->hashes != METRICS_HASHES || hdr->frames > hdr->capacity ||
+		column_offset(hdr->capacity, METRICS_COLUMNS) > s.st_size) {
+		munmap(addr, s.st_size);
+		return -1;
+	}
+
+	const uint8_t *base = (const uint8_t *)addr;
+	map->addr = addr;
+	map->length = s.st_size;
+	map->count = hdr->frames;
+	map->frame_nr = (const uint32_t *)(base + column_offset(hdr->capacity, 0));
+	for (int i = 0; i < METRICS_SERIES; i++) {
+		map->value[i] = (const float *)(base + column_offset(hdr->capacity, 1 + i));
+	}
+	for (int i = 0; i < METRICS_HASHES; i++) {
+		map->hash[i] = (const uint64_t *)(base + column_offset(hdr->capacity, 1 + METRICS_SERIES + i));
+	}
+
+	return 0; /* Success */
+}
+
+void metrics_unmap(struct metrics_map_s *map)
+{
+	if (map->addr) {
+		munmap(map->addr, map->length);
+	}
+	memset(map, 0, sizeof(*map));
+}
+
+int metrics_find(const struct metrics_map_s *map, uint32_t frame_nr)
+{
+	if (map->count == 0 || frame_nr < map->frame_nr[0]) {
+		return -1;
+	}
+
+	uint32_t idx = frame_nr - map->frame_nr[0];
+	if (idx < (uint32_t)map->count && map->frame_nr[idx] == frame_nr) {
+		return idx;
+	}
+
+	int lo = 0, hi = map->count - 1;
+	while (lo <= hi) {
+		int mid = lo + ((hi - lo) / 2);
+		if (map->frame_nr[mid] == frame_nr) {
+			return mid;
+		}
+		if (map->frame_nr[mid] < frame_nr) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return -1;
+}
+
+/* Value of "key": between p and end, NULL if the key isn't there */
+static const char *json_value(const char *p, const char *end, const char *key)
+{
+	const char *k = (const char *)memmem(p, end - p, key, strlen(key));
+	if (k == NULL) {
+		return NULL;
+	}
+	k += strlen(key);
+	while (k < end && (*k == ' ' || *k == '\t' || *k == '\r' || *k == '\n' || *k == ':')) {
+		k++;
+	}
+	return k;
+}
+
+/* The closing brace of the object p is inside, skipping strings, or the end of the buffer */
+static const char *json_object_end(const char *p)
+{
+	int depth = 0;
+	for (; *p; p++) {
+		if (*p == '"') {
+			for (p++; *p && *p != '"'; p++) {
+				if (*p == '\\' && p[1]) {
+					p++;
+				}
+			}
+			if (*p == 0) {
+				break;
+			}
+		} else if (*p == '{') {
+			depth++;
+		} else if (*p == '}' && depth-- == 0) {
+			break;
+		}
+	}
+	return p;
+}
+
+static int vmaf_load_json(const char *buf, float **scores, int *count)
+{
+	float *s = NULL;
+	int c = 0, allocated = 0;
+
+	const char *p = strstr(buf, "\"frameNum\"");
+	while (p) {
+		/* Keys are only looked up within this frame's object, never in a later frame or the pooled metrics */
+		const char *end = json_object_end(p);
+		const char *v = json_value(p, end, "\"frameNum\"");
+		int nr = atoi(v);
+
+		/* libvmaf 2.x nests the score as metrics.vmaf, 1.x had VMAF_score on the frame */
+		const char *score = json_value(v, end, "\"vmaf\"");
+		if (score == NULL) {
+			score = json_value(v, end, "\"VMAF_score\"");
+		}
+
+		if (score && nr >= 0) {
+			if (nr >= allocated) {
+				int n = allocated ? allocated * 2 : 4096;
+				while (n <= nr) {
+					n *= 2;
+				}
+				float *ns = (float *)realloc(s, n * sizeof(float));
+				if (ns == NULL) {
+					free(s);
+					return -1;
+				}
+				for (int i = allocated; i < n; i++) {
+					ns[i] = NAN;
+				}
+				s = ns;
+				allocated = n;
+			}
+			s[nr] = strtof(score, NULL);
+			c = nr + 1 > c ? nr + 1 : c;
+		}
+
+		p = strstr(end, "\"frameNum\"");
+	}
+
+	*scores = s;
+	*count = c;
+
+	return 0; /* Success */
+}
+
+int metrics_load_vmaf(const char *fn, float **scores, int *count)
+{
+	FILE *fh = fopen(fn, "rb");
+	if (fh == NULL) {
+		return -1;
+	}
+
+	fseeko(fh, 0, SEEK_END);
+	off_t len = ftello(fh);
+	rewind(fh);
+
+	char *buf = (char *)malloc(len + 1);
+	if (buf == NULL || fread(buf, 1, len, fh) != (size_t)len) {
+		free(buf);
+		fclose(fh);
+		return -1;
+	}
+	buf[len] = 0;
+	fclose(fh);
+
+	const char *p = buf;
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+		p++;
+	}
+
+	int ret;
+	if (*p == '{') {
+		ret = vmaf_load_json(buf, scores, count);
+	} else {
+		float *aggregates;
+		ret = vmafcsv_load(fn, scores, &aggregates, count);
+		if (ret == 0) {
+			free(aggregates);
+		}
+	}
+	free(buf);
+
+	return ret;
+}
@@ -0,0 +1,112 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Columnar per frame metrics file, written by yuvmse -m and mmap'd by picvmaf, so
+ * a chart render or a lookup never re-parses text. Each column is a fixed width
+ * array, the file is sized for capacity frames up front (sparse until written):
+ *
+ *   struct metrics_file_header_s
+ *   frame_nr        uint32_t[capacity]
+ *   value[series]   float[capacity], one column per series, METRICS_SERIES of them
+ *   hash[2]         uint64_t[capacity], the DCT hashes of file 1 and file 2
+ *
+ * All little endian. A column is contiguous, a chart takes a series straight from
+ * the map and frame n's score is one load. Frames are appended in place, the
+ * header's frame count is bumped after the frame's cells are written, so a reader
+ * mapping a file that's still being written sees only complete frames. A writer
+ * that outgrows the capacity moves the columns apart, capacity changes in the
+ * header and such a reader has to map the file again.
+ *
+ * A metric without a measurement for a frame (VMAF when no libvmaf output was
+ * merged) is NaN.
+ */
+
+#define METRICS_MAGIC "VTMETRIC"
+#define METRICS_VERSION 2
+#define METRICS_HASHES 2
+
+enum {
+	METRICS_VMAF = 0,
+	METRICS_PSNR_Y,
+	METRICS_MSE_Y,
+	METRICS_SHARPNESS,      /* Of the distorted frame, file 2 */
+	METRICS_SERIES
+};
+
+struct metrics_file_header_s
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t series;        /* METRICS_SERIES */
+	uint32_t hashes;        /* METRICS_HASHES */
+	uint32_t capacity;      /* Frames each column has room for */
+	uint32_t frames;        /* Frames written */
+	uint32_t reserved[9];
+};
+
+/* One frame, as appended */
+struct metrics_frame_s
+{
+	uint32_t frame_nr;
+	float value[METRICS_SERIES];
+	uint64_t hash[METRICS_HASHES];
+};
+
+struct metrics_writer_s
+{
+	int fd;
+	uint32_t capacity;
+	uint32_t frames;
+};
+
+struct metrics_map_s
+{
+	int count;
+	const uint32_t *frame_nr;
+	const float *value[METRICS_SERIES];
+	const uint64_t *hash[METRICS_HASHES];
+
+	void *addr;
+	size_t length;
+};
+
+/* Name of a series, "VMAF", "PSNR Y", "MSE Y", "Sharpness", and the lookup for
+ * the short names picvmaf -s takes (vmaf, psnr, mse, sharpness), -1 if unknown.
+ */
+const char *metrics_series_name(int series);
+int metrics_series_lookup(const char *name);
+
+/* Create fn with room for capacity frames, or with resume >= 0 open the existing
+ * file and continue after its first resume frames. Returns 0, or -1 when the file
+ * can't be created or isn't a metrics file.
+ */
+int  metrics_writer_open(struct metrics_writer_s *w, const char *fn, int capacity, int resume);
+int  metrics_writer_append(struct metrics_writer_s *w, const struct metrics_frame_s *frame);
+
+/* Trims the columns to the frames written */
+int  metrics_writer_close(struct metrics_writer_s *w);
+
+/* Map a metrics file read only. Returns 0 on success, -1 when it can't be read
+ * or isn't a metrics file.
+ */
+int  metrics_map(const char *fn, struct metrics_map_s *map);
+void metrics_unmap(struct metrics_map_s *map);
+
+/* Index of frame_nr in the map, -1 if it isn't there. Frames are stored in
+ * increasing order, nearly always one after the other, so that's a direct
+ * index, a binary search otherwise (a -R frame map skipping frames).
+ */
+int  metrics_find(const struct metrics_map_s *map, uint32_t frame_nr);
+
+/* Per frame VMAF scores from libvmaf's JSON log (frames[].metrics.vmaf, or the
+ * older frames[].VMAF_score) or the picvmaf csv, indexed by frame number. Frames
+ * without a score are NaN. *scores is malloc'd, owned by the caller.
+ */
+int  metrics_load_vmaf(const char *fn, float **scores, int *count);
+
+#endif /* METRICS_H */
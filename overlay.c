@@ -0,0 +1,257 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "overlay.h"
+
+using namespace cv;
+
+#define OVERLAY_FACE FONT_HERSHEY_DUPLEX
+#define OVERLAY_SCALE 1.0
+#define OVERLAY_THICKNESS 2
+
+#define GLYPH_FIRST 32
+#define GLYPH_COUNT 95
+
+struct overlay_glyph_s
+{
+	int x;                  /* Column of the mask in the atlas */
+	int width;
+	int height;
+	int left;               /* Mask top left relative to the pen, top is negative (above the baseline) */
+	int top;
+	int advance;
+};
+
+struct overlay_strip_s
+{
+	char *text;
+	uint64_t last_used;
+	Mat mask;
+	int left;
+	int top;
+	int advance;
+};
+
+struct overlay_s
+{
+	Mat atlas;              /* CV_8UC1 coverage, glyphs side by side */
+	struct overlay_glyph_s glyph[GLYPH_COUNT];
+
+	struct overlay_strip_s strip[OVERLAY_STRIPS];
+	uint64_t clock;
+};
+
+static const struct overlay_glyph_s *glyph_lookup(const struct overlay_s *ov, char c)
+{
+	unsigned char u = (unsigned char)c;
+	if (u < GLYPH_FIRST || u >= GLYPH_FIRST + GLYPH_COUNT) {
+		u = '?';
+	}
+	return &ov->glyph[u - GLYPH_FIRST];
+}
+
+struct overlay_s *overlay_alloc(void)
+{
+	struct overlay_s *ov = new (std::nothrow) overlay_s();
+	if (ov == NULL) {
+		return NULL;
+	}
+
+	try {
+		/* Rasterise every glyph on its own with putText, at a pen position with room all
+		 * round, then keep the inked box. The advance is what a second copy of the glyph
+		 * adds to the string width.
+		 */
+		int base;
+		Size cap = getTextSize("Ag", OVERLAY_FACE, OVERLAY_SCALE, OVERLAY_THICKNESS, &base);
+		int pad = cap.height + OVERLAY_THICKNESS;
+		Mat canvas[GLYPH_COUNT];
+		Rect box[GLYPH_COUNT];
+		int atlas_width = 0, atlas_height = 1;
+
+		for (int i = 0; i < GLYPH_COUNT; i++) {
+			char one[2] = { (char)(GLYPH_FIRST + i), 0 };
+			char two[3] = { one[0], one[0], 0 };
+			int w1 = getTextSize(one, OVERLAY_FACE, OVERLAY_SCALE, OVERLAY_THICKNESS, &base).width;
+			int w2 = getTextSize(two, OVERLAY_FACE, OVERLAY_SCALE, OVERLAY_THICKNESS, &base).width;
+
+			canvas[i] = Mat::zeros(pad * 3, w1 + (pad * 2), CV_8UC1);
+			putText(canvas[i], one, Point(pad, pad * 2), OVERLAY_FACE, OVERLAY_SCALE, Scalar(255), OVERLAY_THICKNESS);
+			box[i] = boundingRect(canvas[i]);
+
+			struct overlay_glyph_s *g = &ov->glyph[i];
+			g->x = atlas_width;
+			g->width = box[i].width;
+			g->height = box[i].height;
+			g->left = box[i].x - pad;
+			g->top = box[i].y - (pad * 2);
+			g->advance = w2 - w1;
+
+			atlas_width += box[i].width;
+			atlas_height = box[i].height > atlas_height ? box[i].height : atlas_height;
+		}
+
+		ov->atlas = Mat::zeros(atlas_height, atlas_width > 0 ? atlas_width : 1, CV_8UC1);
+		for (int i = 0; i < GLYPH_COUNT; i++) {
+			if (box[i].width == 0) {
+				continue; /* Space */
+			}
+			Mat dst = ov->atlas(Rect(ov->glyph[i].x, 0, box[i].width, box[i].height));
+			canvas[i](box[i]).copyTo(dst);
+		}
+	} catch (const cv::Exception &e) {
+		delete ov;
+		return NULL;
+	}
+
+	return ov;
+}
+
+void overlay_free(struct overlay_s *ov)
+{
+	if (ov == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < OVERLAY_STRIPS; i++) {
+		free(ov->strip[i].text);
+	}
+	delete ov;
+}
+
+/* Blend a w x h coverage mask into dst at (x, y), clipped. Full coverage is a store,
+ * which is every pixel of the LINE_8 Hershey raster, partial coverage blends.
+ */
+static void blit(uint8_t *dst, int stride, int width, int height, int channels,
+	const uint8_t *mask, int mstride, int w, int h, int x, int y, const uint8_t colour[3])
+{
+	int x0 = x < 0 ? -x : 0;
+	int y0 = y < 0 ? -y : 0;
+	int x1 = x + w > width ? width - x : w;
+	int y1 = y + h > height ? height - y : h;
+
+	for (int my = y0; my < y1; my++) {
+		const uint8_t *m = mask + ((size_t)my * mstride);
+		uint8_t *d = dst + ((size_t)(y + my) * stride);
+
+		for (int mx = x0; mx < x1; mx++) {
+			int a = m[mx];
+			if (a == 0) {
+				continue;
+			}
+			uint8_t *p = d + ((x + mx) * channels);
+			for (int c = 0; c < channels; c++) {
+				if (a == 255) {
+					p[c] = colour[c];
+				} else {
+					p[c] = p[c] + ((((int)colour[c] - p[c]) * a) + (colour[c] >= p[c] ? 127 : -127)) / 255;
+				}
+			}
+		}
+	}
+}
+
+/* Compose text's glyphs into a single mask, coverage where glyphs touch is the max */
+static int strip_build(struct overlay_s *ov, struct overlay_strip_s *s, const char *text)
+{
+	int left = 0, right = 0, top = 0, bottom = 0, pen = 0;
+
+	for (const char *t = text; *t; t++) {
+		const struct overlay_glyph_s *g = glyph_lookup(ov, *t);
+		if (g->width) {
+			left = (pen + g->left) < left ? (pen + g->left) : left;
+			right = (pen + g->left + g->width) > right ? (pen + g->left + g->width) : right;
+			top = g->top < top ? g->top : top;
+			bottom = (g->top + g->height) > bottom ? (g->top + g->height) : bottom;
+		}
+		pen += g->advance;
+	}
+
+	s->mask = Mat::zeros(bottom - top > 0 ? bottom - top : 1, right - left > 0 ? right - left : 1, CV_8UC1);
+	s->left = left;
+	s->top = top;
+	s->advance = pen;
+
+	pen = 0;
+	for (const char *t = text; *t; t++) {
+		const struct overlay_glyph_s *g = glyph_lookup(ov, *t);
+		for (int y = 0; y < g->height; y++) {
+			const uint8_t *src = ov->atlas.ptr<uint8_t>(y) + g->x;
+			uint8_t *dst = s->mask.ptr<uint8_t>(g->top - top + y) + (pen + g->left - left);
+			for (int x = 0; x < g->width; x++) {
+				dst[x] = src[x] > dst[x] ? src[x] : dst[x];
+			}
+		}
+		pen += g->advance;
+	}
+
+	s->text = strdup(text);
+	if (s->text == NULL) {
+		s->mask.release();
+		return -1;
+	}
+
+	return 0; /* Success */
+}
+
+static struct overlay_strip_s *strip_lookup(struct overlay_s *ov, const char *text)
+{
+	struct overlay_strip_s *victim = &ov->strip[0];
+
+	ov->clock++;
+	for (int i = 0; i < OVERLAY_STRIPS; i++) {
+		struct overlay_strip_s *s = &ov->strip[i];
+		if (s->text && strcmp(s->text, text) == 0) {
+			s->last_used = ov->clock;
+			return s;
+		}
+		if (victim->text && (s->text == NULL || s->last_used < victim->last_used)) {
+			victim = s;
+		}
+	}
+
+	free(victim->text);
+	victim->text = NULL;
+	victim->mask.release();
+	try {
+		if (strip_build(ov, victim, text) < 0) {
+			return NULL;
+		}
+	} catch (const cv::Exception &e) {
+		return NULL;
+	}
+	victim->last_used = ov->clock;
+
+	return victim;
+}
+
+int overlay_text(struct overlay_s *ov, uint8_t *dst, int stride, int width, int height, int channels,
+	const char *text, int x, int y, const uint8_t colour[3], int cache)
+{
+	if (cache) {
+		struct overlay_strip_s *s = strip_lookup(ov, text);
+		if (s) {
+			blit(dst, stride, width, height, channels, s->mask.data, (int)s->mask.step, s->mask.cols, s->mask.rows,
+				x + s->left, y + s->top, colour);
+			return x + s->advance;
+		}
+		/* Out of memory, draw it glyph by glyph */
+	}
+
+	for (const char *t = text; *t; t++) {
+		const struct overlay_glyph_s *g = glyph_lookup(ov, *t);
+		if (g->width) {
+			blit(dst, stride, width, height, channels, ov->atlas.data + g->x, (int)ov->atlas.step, g->width, g->height,
+				x + g->left, y + g->top, colour);
+		}
+		x += g->advance;
+	}
+
+	return x;
+}
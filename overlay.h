@@ -0,0 +1,34 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <stdint.h>
+
+/* Text overlay for the rendered pictures. putText strokes every Hershey glyph as
+ * thick polylines on every call, while frame after frame the labels barely change.
+ * Here each printable glyph is rasterised once, as a coverage mask, into an atlas
+ * and text is alpha blitted from it. Strings drawn with cache set, file names and
+ * captions, are kept whole as a strip so the next frame costs one blit.
+ *
+ * The face is the one the tools have always used, FONT_HERSHEY_DUPLEX, scale 1.0,
+ * thickness 2. Pen advances are whole pixels at that scale, so text lands exactly
+ * where putText puts it.
+ */
+
+#define OVERLAY_STRIPS 32       /* Cached strings per overlay, least recently used goes */
+
+struct overlay_s;
+
+struct overlay_s *overlay_alloc(void);
+void overlay_free(struct overlay_s *ov);
+
+/* Draw text with its baseline starting at (x, y), as putText(org = (x, y)) would, into a
+ * width x height image of 1 (gray, colour[0]) or 3 (BGR) channels, clipped to the image.
+ * Characters outside 32..126 draw as '?'. Returns the pen x after the text, so dynamic
+ * text can follow a cached prefix.
+ */
+int overlay_text(struct overlay_s *ov, uint8_t *dst, int stride, int width, int height, int channels,
+	const char *text, int x, int y, const uint8_t colour[3], int cache);
+
+#endif /* OVERLAY_H */
@@ -2,47 +2,186 @@
 
 #include <stdio.h>
 #include <getopt.h>
+#include <limits.h>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/opencv.hpp>
 
+#include "vmaftools.h"
+
 using namespace cv;
 
 #define RENDER_TITLE_DEFAULT 1
 
 struct tool_context_s {
-#define MAX_INPUTS 4
-	char *fn[MAX_INPUTS];
-	Mat mat[MAX_INPUTS];
-	int max_cols;
-	int max_rows;
+#define MAX_INPUTS 64
+	char *fn[MAX_INPUTS];   /* NULL or "-" composites a black tile */
+	int inputs;             /* Highest tile in use + 1 */
+	int cols;               /* Grid, def 2x2 */
+	int rows;
+	int tile_width;         /* Scale every tile to this size, 0 = largest input, unscaled */
+	int tile_height;
+	int scale;              /* -s given */
+
+	int first;              /* Sequence mode, inputs and output are printf patterns */
+	int frames;
 
 	char *outfn;
 	int verbose;
 	int render_title;
+
+	/* One output buffer, cleared once and reused for every frame. Tiles that match
+	 * their cell decode straight into it, others land in a per tile buffer first.
+	 */
+	Mat output;
+	Mat decoded[MAX_INPUTS];
+	int inplace_miss[MAX_INPUTS];
+	uint8_t *filebuf;
+	size_t filebuf_size;
+	char name[MAX_INPUTS][PATH_MAX];
 };
 
-int matLoad(struct tool_context_s *ctx, int nr)
+int fileRead(struct tool_context_s *ctx, const char *fn, size_t *size)
 {
-	ctx->mat[nr] = imread(ctx->fn[nr], IMREAD_COLOR);
-	if (ctx->mat[nr].rows == 0) {
-		printf("Error reading file %s, aborting.\n", ctx->fn[nr]);
+	FILE *fh = fopen(fn, "rb");
+	if (fh == NULL) {
 		return -1;
 	}
 
-	if (ctx->render_title) {
-		putText(ctx->mat[nr], ctx->fn[nr], Point(10, 40), FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(255, 255, 255), 2);
+	fseeko(fh, 0, SEEK_END);
+	off_t len = ftello(fh);
+	rewind(fh);
+
+	if (len <= 0) {
+		fclose(fh);
+		return -1;
+	}
+	if ((size_t)len > ctx->filebuf_size) {
+		free(ctx->filebuf);
+		ctx->filebuf = (uint8_t *)malloc(len);
+		ctx->filebuf_size = ctx->filebuf ? len : 0;
+		if (ctx->filebuf == NULL) {
+			fclose(fh);
+			return -1;
+		}
 	}
 
-	if (ctx->verbose) {
-		printf("%s resolution is %dx%d\n", ctx->fn[nr], ctx->mat[nr].cols, ctx->mat[nr].rows);
+	size_t r = fread(ctx->filebuf, 1, len, fh);
+	fclose(fh);
+	if (r != (size_t)len) {
+		return -1;
+	}
+
+	*size = len;
+	return 0; /* Success */
+}
+
+/* Decode a tile. With a cell, try decoding straight into it, which only sticks when
+ * the picture is exactly the cell's size, otherwise OpenCV hands back a new buffer.
+ */
+int tileLoad(struct tool_context_s *ctx, int nr, Mat *cell, Mat &tile)
+{
+	size_t size;
+	if (fileRead(ctx, ctx->name[nr], &size) < 0) {
+		printf("Error reading file %s, aborting.\n", ctx->name[nr]);
+		return -1;
+	}
+
+	Mat buf = Mat(1, size, CV_8UC1, ctx->filebuf);
+	tile = (cell && !ctx->inplace_miss[nr]) ? *cell : ctx->decoded[nr];
+	imdecode(buf, IMREAD_COLOR, &tile);
+	if (tile.rows == 0) {
+		printf("Error decoding file %s, aborting.\n", ctx->name[nr]);
+		return -1;
+	}
+
+	if (cell && tile.data != cell->data) {
+		/* Wrong size for its cell, stop trying and keep the buffer for the next frame */
+		ctx->inplace_miss[nr] = 1;
+		ctx->decoded[nr] = tile;
+	}
+
+	if (ctx->verbose > 1) {
+		printf("%s resolution is %dx%d%s\n", ctx->name[nr], tile.cols, tile.rows,
+			cell && tile.data == cell->data ? ", decoded in place" : "");
+	}
+
+	return 0; /* Success */
+}
+
+int composeFrame(struct tool_context_s *ctx, vmaftools_context_t *vt, int frame)
+{
+	int cells = ctx->cols * ctx->rows;
+	Mat tile[MAX_INPUTS];
+	struct vmaftools_image_s img[MAX_INPUTS];
+	const struct vmaftools_image_s *tiles[MAX_INPUTS];
+	const char *titles[MAX_INPUTS];
+
+	for (int i = 0; i < cells; i++) {
+		tiles[i] = NULL;
+		titles[i] = NULL;
+		if (i >= ctx->inputs || ctx->fn[i] == NULL || strcmp(ctx->fn[i], "-") == 0) {
+			continue;
+		}
+
+		if (ctx->frames) {
+			snprintf(ctx->name[i], sizeof(ctx->name[i]), ctx->fn[i], frame);
+		} else {
+			snprintf(ctx->name[i], sizeof(ctx->name[i]), "%s", ctx->fn[i]);
+		}
+
+		Mat cell;
+		if (!ctx->output.empty()) {
+			int cw = ctx->output.cols / ctx->cols;
+			int ch = ctx->output.rows / ctx->rows;
+			cell = ctx->output(Rect((i % ctx->cols) * cw, (i / ctx->cols) * ch, cw, ch));
+		}
+		if (tileLoad(ctx, i, ctx->output.empty() ? NULL : &cell, tile[i]) < 0) {
+			return -1;
+		}
+
+		img[i] = { tile[i].data, (int)tile[i].step, tile[i].cols, tile[i].rows };
+		tiles[i] = &img[i];
+		titles[i] = ctx->render_title ? ctx->name[i] : NULL;
+	}
+
+	if (ctx->output.empty()) {
+		/* No -s, cells are the largest input, sized from the first frame */
+		for (int i = 0; i < cells; i++) {
+			if (tiles[i] == NULL) {
+				continue;
+			}
+			ctx->tile_width = tile[i].cols > ctx->tile_width ? tile[i].cols : ctx->tile_width;
+			ctx->tile_height = tile[i].rows > ctx->tile_height ? tile[i].rows : ctx->tile_height;
+		}
+		if (ctx->tile_width == 0) {
+			fprintf(stderr, "No input images, aborting\n");
+			return -1;
+		}
+		ctx->output = Mat(ctx->tile_height * ctx->rows, ctx->tile_width * ctx->cols, CV_8UC3, Scalar(0, 0, 0));
+
+		if (ctx->verbose) {
+			printf("Output resolution is %dx%d\n", ctx->output.cols, ctx->output.rows);
+		}
 	}
 
-	if (ctx->mat[nr].rows > ctx->max_rows) {
-		ctx->max_rows = ctx->mat[nr].rows;
+	struct vmaftools_image_s o = { ctx->output.data, (int)ctx->output.step, ctx->output.cols, ctx->output.rows };
+	if (vmaftools_render_mosaic(vt, tiles, titles, ctx->cols, ctx->rows, ctx->scale, &o) < 0) {
+		fprintf(stderr, "Failed to composite, %s\n", vmaftools_error(vt));
+		return -1;
 	}
-	if (ctx->mat[nr].cols > ctx->max_cols) {
-		ctx->max_cols = ctx->mat[nr].cols;
+
+	/* Save */
+	char outfn[PATH_MAX];
+	if (ctx->frames) {
+		snprintf(outfn, sizeof(outfn), ctx->outfn, frame);
+	} else {
+		snprintf(outfn, sizeof(outfn), "%s", ctx->outfn);
+	}
+	cv::imwrite(outfn, ctx->output, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
+
+	if (ctx->verbose) {
+		printf("Created %s\n", outfn);
 	}
 
 	return 0; /* Success */
@@ -50,13 +189,18 @@ int matLoad(struct tool_context_s *ctx, int nr)
 
 void usage()
 {
-	printf("A tool to create a 2x2 multiview grid from four seperate pictures.\n");
+	printf("A tool to create a multiview grid (2x2 by default) from seperate pictures.\n");
 	printf("If a specific image is not required, skip it, black will be composited.\n");
 	printf("Usage:\n");
 	printf("  -1 topleft.png\n");
 	printf("  -2 topright.png\n");
 	printf("  -3 bottomleft.png\n");
 	printf("  -4 bottomright.png\n");
+	printf("  -i image.png add the next tile, row major, '-' for a black tile (up to %d)\n", MAX_INPUTS);
+	printf("  -g CxR grid of C columns and R rows [def: 2x2]\n");
+	printf("  -s WxH scale every tile to W x H [def: largest input, unscaled]\n");
+	printf("  -N frames, sequence mode, inputs and output are printf patterns such as REF%%06d.png\n");
+	printf("    -F first frame number [def: 0]\n");
 	printf("  -v raise verbosity\n");
 	printf("  -t render filenames into images [def: %d]\n", RENDER_TITLE_DEFAULT);
 	printf("  -o output.png\n");
@@ -67,10 +211,12 @@ int main(int argc, char *argv[])
 	struct tool_context_s tool_ctx, *ctx = &tool_ctx;
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->render_title = RENDER_TITLE_DEFAULT;
+	ctx->cols = 2;
+	ctx->rows = 2;
 
 	int ch, idx;
 
-	while ((ch = getopt(argc, argv, "?h1:2:3:4:o:t:v")) != -1) {
+	while ((ch = getopt(argc, argv, "?h1:2:3:4:F:g:i:N:o:s:t:v")) != -1) {
 		switch (ch) {
 		case '1':
 		case '2':
@@ -78,14 +224,41 @@ int main(int argc, char *argv[])
 		case '4':
 			idx = ch - '0' - 1;
 			ctx->fn[idx] = strdup(optarg);
-			if (matLoad(ctx, idx) < 0) {
-				fprintf(stderr, "Failed to load image\n");
-				return -1;
+			if (idx + 1 > ctx->inputs) {
+				ctx->inputs = idx + 1;
 			}
 			break;
+		case 'F':
+			ctx->first = atoi(optarg);
+			break;
+		case 'g':
+			if (sscanf(optarg, "%dx%d", &ctx->cols, &ctx->rows) != 2 || ctx->cols <= 0 || ctx->rows <= 0 ||
+				ctx->cols * ctx->rows > MAX_INPUTS) {
+				fprintf(stderr, "Invalid grid %s, aborting\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'i':
+			if (ctx->inputs == MAX_INPUTS) {
+				fprintf(stderr, "Too many inputs, aborting\n");
+				exit(1);
+			}
+			ctx->fn[ctx->inputs++] = strdup(optarg);
+			break;
+		case 'N':
+			ctx->frames = atoi(optarg);
+			break;
 		case 'o':
 			ctx->outfn = strdup(optarg);
 			break;
+		case 's':
+			if (sscanf(optarg, "%dx%d", &ctx->tile_width, &ctx->tile_height) != 2 ||
+				ctx->tile_width <= 0 || ctx->tile_height <= 0) {
+				fprintf(stderr, "Invalid tile size %s, aborting\n", optarg);
+				exit(1);
+			}
+			ctx->scale = 1;
+			break;
 		case 't':
 			ctx->render_title = atoi(optarg);
 			break;
@@ -104,27 +277,34 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
-	/* Create a 2x2 output mat, we'll composite into this */
-	Mat mOutput = Mat(ctx->max_rows * 2, ctx->max_cols * 2, CV_8UC3);
-
-	if (ctx->verbose) {
-		printf("Output resolution is %dx%d\n", mOutput.cols, mOutput.rows);
+	if (ctx->outfn == NULL) {
+		fprintf(stderr, "No output file, -o is required\n");
+		exit(1);
+	}
+	if (ctx->inputs > ctx->cols * ctx->rows) {
+		fprintf(stderr, "%d inputs don't fit a %dx%d grid, aborting\n", ctx->inputs, ctx->cols, ctx->rows);
+		exit(1);
 	}
 
-	for (int i = 0; i < MAX_INPUTS; i++) {
-		if (ctx->fn[i] == NULL) {
-			continue;
+	/* With a tile size the output is known up front, every frame scales into it */
+	if (ctx->scale) {
+		ctx->output = Mat(ctx->tile_height * ctx->rows, ctx->tile_width * ctx->cols, CV_8UC3, Scalar(0, 0, 0));
+		if (ctx->verbose) {
+			printf("Output resolution is %dx%d\n", ctx->output.cols, ctx->output.rows);
 		}
+	}
 
-		Rect src = Rect(0, 0, ctx->mat[i].cols, ctx->mat[i].rows);
-		Rect dst = Rect((i % 2) * ctx->max_cols, (i / 2) * ctx->max_rows, ctx->max_cols, ctx->max_rows);
+	vmaftools_context_t *vt = vmaftools_context_alloc();
 
-		ctx->mat[i](src).copyTo(mOutput(dst));
+	int frames = ctx->frames > 0 ? ctx->frames : 1;
+	for (int i = 0; i < frames; i++) {
+		if (composeFrame(ctx, vt, ctx->first + i) < 0) {
+			exit(1);
+		}
 	}
 
-	/* Save */
-	cv::imwrite(ctx->outfn, mOutput, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
+	vmaftools_context_free(vt);
+	free(ctx->filebuf);
 
 	return 0;
 }
-
@@ -2,10 +2,14 @@
 
 #include <stdio.h>
 #include <getopt.h>
+#include <math.h>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/opencv.hpp>
 
+#include "kernels.h"
+#include "vmaftools.h"
+
 using namespace cv;
 
 #define RENDER_TITLE_DEFAULT 1
@@ -21,6 +25,13 @@ struct tool_context_s {
 	char *outfn;
 	int verbose;
 	int render_title;
+
+	/* Luma domain diff of raw YUV 4:2:0 files, no BGR expansion */
+	int luma;
+	int width;
+	int height;
+	int frame;
+	uint8_t *plane[MAX_INPUTS];
 };
 
 int matLoad(struct tool_context_s *ctx, int nr)
@@ -47,6 +58,32 @@ int matLoad(struct tool_context_s *ctx, int nr)
 	return 0; /* Success */
 }
 
+int lumaLoad(struct tool_context_s *ctx, int nr)
+{
+	size_t frame_size = ((size_t)ctx->width * ctx->height * 3) / 2; /* YUV420 */
+
+	FILE *fh = fopen(ctx->fn[nr], "rb");
+	if (fh == NULL) {
+		printf("Error reading file %s, aborting.\n", ctx->fn[nr]);
+		return -1;
+	}
+
+	ctx->plane[nr] = (uint8_t *)malloc((size_t)ctx->width * ctx->height);
+	if (fseeko(fh, (off_t)ctx->frame * frame_size, SEEK_SET) < 0 ||
+		fread(ctx->plane[nr], 1, (size_t)ctx->width * ctx->height, fh) != (size_t)ctx->width * ctx->height) {
+		printf("Error reading frame %d from %s, aborting.\n", ctx->frame, ctx->fn[nr]);
+		fclose(fh);
+		return -1;
+	}
+	fclose(fh);
+
+	if (ctx->verbose) {
+		printf("%s frame %d luma %dx%d\n", ctx->fn[nr], ctx->frame, ctx->width, ctx->height);
+	}
+
+	return 0; /* Success */
+}
+
 void usage()
 {
         printf("A tool to create compare absolute differences between two images, creating an output difference image.\n");
@@ -54,7 +91,12 @@ void usage()
         printf("  -1 image1.png\n");
         printf("  -2 image2.png\n");
         printf("  -n normalize output diff to gray (default black)\n");
+        printf("  -Y diff the luma planes of two raw YUV 4:2:0 files instead, reports the same Y MSE as yuvmse\n");
+        printf("    -W width (pixels def: 1920)\n");
+        printf("    -H height (pixels def: 1080)\n");
+        printf("    -f frame number to compare [def: 0]\n");
         printf("  -v raise verbosity\n");
+        printf("  -x isa force the kernel path, scalar, sse42, avx2 or avx512 [def: best for this cpu]\n");
 	printf("  -t render filenames into images [def: %d]\n", RENDER_TITLE_DEFAULT);
         printf("  -o output.png\n");
 }
@@ -64,19 +106,29 @@ int main(int argc, char *argv[])
 	struct tool_context_s tool_ctx, *ctx = &tool_ctx;
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->render_title = RENDER_TITLE_DEFAULT;
+	ctx->width = 1920;
+	ctx->height = 1080;
 
 	int ch, idx;
 
-	while ((ch = getopt(argc, argv, "?h1:2:3:4:no:t:v")) != -1) {
+	while ((ch = getopt(argc, argv, "?h1:2:3:4:f:no:t:vx:H:W:Y")) != -1) {
 		switch (ch) {
 		case '1':
 		case '2':
 			idx = ch - '0' - 1;
 			ctx->fn[idx] = strdup(optarg);
-			if (matLoad(ctx, idx) < 0) {
-				fprintf(stderr, "Failed to load image\n");
-				return -1;
-			}
+			break;
+		case 'f':
+			ctx->frame = atoi(optarg);
+			break;
+		case 'H':
+			ctx->height = atoi(optarg);
+			break;
+		case 'W':
+			ctx->width = atoi(optarg);
+			break;
+		case 'Y':
+			ctx->luma = 1;
 			break;
 		case 'n':
 			ctx->normalize = 1;
@@ -90,6 +142,12 @@ int main(int argc, char *argv[])
 		case 'v':
 			ctx->verbose++;
 			break;
+		case 'x':
+			if (kernels_force(optarg) < 0) {
+				fprintf(stderr, "kernel path %s unknown or not supported by this cpu, aborting\n", optarg);
+				exit(1);
+			}
+			break;
 		default:
 		case '?':
 		case 'h':
@@ -102,33 +160,66 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
-	/* Create a utput mat, we'll composite into this */
-	Mat mOutput = Mat(ctx->max_rows, ctx->max_cols, CV_8UC3);
-
-	if (ctx->verbose) {
-		printf("Output resolution is %dx%d\n", mOutput.cols, mOutput.rows);
+	/* Inputs load once every option is known, -Y changes how they're read */
+	for (int i = 0; i < MAX_INPUTS; i++) {
+		if (ctx->fn[i] == NULL) {
+			fprintf(stderr, "Two inputs are required, -1 and -2\n");
+			exit(1);
+		}
+		if ((ctx->luma ? lumaLoad(ctx, i) : matLoad(ctx, i)) < 0) {
+			fprintf(stderr, "Failed to load image\n");
+			return -1;
+		}
 	}
 
-	absdiff(ctx->mat[0], ctx->mat[1], mOutput);
+	vmaftools_context_t *vt = vmaftools_context_alloc();
+	const char *title = ctx->render_title ? ctx->outfn : NULL;
+	Mat mOutput;
+
+	if (ctx->luma) {
+		/* One 8bit output buffer, the diff lands in it and is normalized in place */
+		mOutput = Mat(ctx->height, ctx->width, CV_8UC1);
+
+		struct vmaftools_plane_s a = { ctx->plane[0], ctx->width, ctx->width, ctx->height };
+		struct vmaftools_plane_s b = { ctx->plane[1], ctx->width, ctx->width, ctx->height };
+
+		double mse;
+		if (vmaftools_render_diff_luma(vt, &a, &b, ctx->normalize, title, mOutput.data, mOutput.step, &mse) < 0) {
+			fprintf(stderr, "Failed to render difference, %s\n", vmaftools_error(vt));
+			exit(1);
+		}
+		printf("# frame %08d Y mse %9.3f psnr %9.3f\n", ctx->frame, mse,
+			mse == 0 ? INFINITY : 10.0 * log10((255.0 * 255.0) / mse));
+	} else {
+		if (ctx->mat[0].size() != ctx->mat[1].size()) {
+			fprintf(stderr, "Images are different sizes, aborting\n");
+			exit(1);
+		}
+
+		/* One output buffer, the diff lands in it and is normalized in place */
+		mOutput = Mat(ctx->mat[0].rows, ctx->mat[0].cols, CV_8UC3);
 
-	Mat diff_normalized = Mat(ctx->max_rows, ctx->max_cols, CV_8UC3);
-	normalize(mOutput, diff_normalized, 150, 255, cv::NORM_MINMAX);
+		struct vmaftools_image_s a = { ctx->mat[0].data, (int)ctx->mat[0].step, ctx->mat[0].cols, ctx->mat[0].rows };
+		struct vmaftools_image_s b = { ctx->mat[1].data, (int)ctx->mat[1].step, ctx->mat[1].cols, ctx->mat[1].rows };
+		struct vmaftools_image_s o = { mOutput.data, (int)mOutput.step, mOutput.cols, mOutput.rows };
 
-	if (ctx->render_title) {
-		if (ctx->normalize) {
-			putText(diff_normalized, ctx->outfn, Point(10, 40), FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(255, 255, 255), 2);
-		} else {
-			putText(mOutput, ctx->outfn, Point(10, 40), FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(255, 255, 255), 2);
+		if (vmaftools_render_diff(vt, &a, &b, ctx->normalize, title, &o) < 0) {
+			fprintf(stderr, "Failed to render difference, %s\n", vmaftools_error(vt));
+			exit(1);
 		}
 	}
+	vmaftools_context_free(vt);
 
-	/* Save */
-	if (ctx->normalize) {
-		cv::imwrite(ctx->outfn, diff_normalized, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
-	} else {
-		cv::imwrite(ctx->outfn, mOutput, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
+	if (ctx->verbose) {
+		printf("Output resolution is %dx%d, kernels %s\n", mOutput.cols, mOutput.rows, vmaftools_kernels());
 	}
 
+	/* Save */
+	cv::imwrite(ctx->outfn, mOutput, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
+
+	free(ctx->plane[0]);
+	free(ctx->plane[1]);
+
 	return 0;
 }
 
@@ -2,19 +2,21 @@
 
 #include <stdio.h>
 #include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <inttypes.h>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/opencv.hpp>
 
+#include "vmaftools.h"
+#include "vmafcsv.h"
+#include "metrics.h"
+
 using namespace cv;
 
 #define RENDER_TITLE_DEFAULT 1
 
-struct vmaf_measurement_s {
-	float fVMAF_score;
-	float fVMAF_score_agg;
-};
-
 struct tool_context_s {
 	char *ifn;
 	char *ofn;
@@ -24,9 +26,145 @@ struct tool_context_s {
 
 	float min_score;
 	int framecount;
-	struct vmaf_measurement_s *measurements;
+
+	int frames;             /* Sequence mode, cursor frames -c .. -c + frames - 1, -o is a pattern */
+	char *series;           /* Metrics file series, "vmaf,psnr,mse,sharpness" */
+	int lookup;             /* -f, print this frame's metrics instead of charting, -1 for none */
+};
+
+static const struct {
+	float min;
+	float max;
+	uint8_t colour[3];      /* BGR */
+} series_style[METRICS_SERIES] = {
+	{   0, 100, {   0, 200,   0 } },    /* VMAF, fixed axis */
+	{   0,   0, { 250, 160,  60 } },    /* PSNR Y, scaled to its range */
+	{   0,   0, {   0, 140, 255 } },    /* MSE Y */
+	{   0,   0, { 220, 100, 220 } },    /* Sharpness */
 };
 
+static void output_name(struct tool_context_s *ctx, char *fn, size_t len, int cursor)
+{
+	if (ctx->frames) {
+		snprintf(fn, len, ctx->ofn, cursor);
+	} else {
+		snprintf(fn, len, "%s", ctx->ofn);
+	}
+}
+
+/* One frame of a metrics file, found by frame number without reading the rest */
+static int print_frame(struct tool_context_s *ctx, struct metrics_map_s *map)
+{
+	int idx = metrics_find(map, ctx->lookup);
+	if (idx < 0) {
+		fprintf(stderr, "Frame %d isn't in %s\n", ctx->lookup, ctx->ifn);
+		return -1;
+	}
+
+	printf("frame %d", ctx->lookup);
+	for (int i = 0; i < METRICS_SERIES; i++) {
+		printf(", %s %.3f", metrics_series_name(i), map->value[i][idx]);
+	}
+	printf(", hash %016" PRIx64 " %016" PRIx64 "\n", map->hash[0][idx], map->hash[1][idx]);
+
+	return 0; /* Success */
+}
+
+/* A yuvmse -m metrics file, mmap'd. The chart geometry is built once, every cursor
+ * frame after that is a copy, a line and the captions. Series are columns in the
+ * file, the chart reads them in place.
+ */
+static int render_metrics(struct tool_context_s *ctx, vmaftools_context_t *vt, struct metrics_map_s *map)
+{
+	struct vmaftools_series_s series[METRICS_SERIES];
+	int nseries = 0;
+
+	int selected[METRICS_SERIES] = { 0 };
+	if (ctx->series) {
+		char *list = strdup(ctx->series), *save = NULL;
+		for (char *t = strtok_r(list, ",", &save); t; t = strtok_r(NULL, ",", &save)) {
+			int idx = metrics_series_lookup(t);
+			if (idx < 0) {
+				fprintf(stderr, "Unknown series %s, use vmaf, psnr, mse or sharpness\n", t);
+				exit(1);
+			}
+			selected[idx] = 1;
+		}
+		free(list);
+	}
+
+	for (int i = 0; i < METRICS_SERIES; i++) {
+		if (ctx->series && !selected[i]) {
+			continue;
+		}
+		if (ctx->series == NULL) {
+			/* By default every series with a measurement, VMAF is NaN without yuvmse -V */
+			int found = 0;
+			for (int f = 0; f < map->count && !found; f++) {
+				found = isfinite(map->value[i][f]);
+			}
+			if (!found) {
+				continue;
+			}
+		}
+
+		struct vmaftools_series_s *s = &series[nseries++];
+		s->name = metrics_series_name(i);
+		s->values = map->value[i];
+		s->stride = sizeof(float);
+		s->min = series_style[i].min;
+		s->max = series_style[i].max;
+		memcpy(s->colour, series_style[i].colour, sizeof(s->colour));
+	}
+
+	Mat mOutputResized = Mat(1080, 1920, CV_8UC3);
+	struct vmaftools_image_s o = { mOutputResized.data, (int)mOutputResized.step, mOutputResized.cols, mOutputResized.rows };
+
+	vmaftools_chart_t *chart = vmaftools_chart_alloc(vt, series, nseries, map->count, o.width, o.height);
+	if (chart == NULL) {
+		fprintf(stderr, "Failed to build chart, %s\n", vmaftools_error(vt));
+		return -1;
+	}
+
+	/* -c is a frame number, the chart is indexed by position in the file */
+	int first = metrics_find(map, ctx->cursor_column);
+	if (first < 0) {
+		fprintf(stderr, "Frame %d isn't in %s\n", ctx->cursor_column, ctx->ifn);
+		vmaftools_chart_free(chart);
+		return -1;
+	}
+
+	/* Files are named by the frame number rendered into them, a -R map may skip some */
+	int frames = ctx->frames ? ctx->frames : 1;
+	for (int i = 0; i < frames; i++) {
+		if (first + i >= map->count) {
+			fprintf(stderr, "Failed to render chart, %s ends after %d frames\n", ctx->ifn, map->count);
+			vmaftools_chart_free(chart);
+			return -1;
+		}
+
+		char fn[PATH_MAX];
+		output_name(ctx, fn, sizeof(fn), map->frame_nr[first + i]);
+
+		if (vmaftools_render_chart_series(vt, chart, first + i, ctx->render_title ? fn : NULL, &o) < 0) {
+			fprintf(stderr, "Failed to render chart, %s\n", vmaftools_error(vt));
+			vmaftools_chart_free(chart);
+			return -1;
+		}
+
+		/* Save */
+		cv::imwrite(fn, mOutputResized, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
+
+		if (ctx->verbose) {
+			printf("Created %s\n", fn);
+		}
+	}
+
+	vmaftools_chart_free(chart);
+
+	return 0; /* Success */
+}
+
 void usage()
 {
         printf("A tool to create a vmaf chart with a cursor position on a specific measurement.\n");
@@ -35,7 +173,12 @@ void usage()
 			"\tcat vmaf.json | jq -r '.frames[] | \"\(.frameNum),\(.VMAF_score)\"' | sed \"s!\\$!,$AGGREGATE!g\"\n");
         printf("Usage:\n");
         printf("  -i vmaf.csv\n");
+        printf("Or a binary metrics file from yuvmse -m, charting VMAF, Y PSNR, Y MSE and sharpness\n"
+			"each on its own axis.\n");
         printf("  -c framenumber to draw cursor at (0..max vmaf frame number)\n");
+        printf("  -N frames, sequence mode, cursor at -c onwards and -o is a printf pattern such as VMAF%%06d.png\n");
+        printf("  -s vmaf,psnr,mse,sharpness series to chart from a metrics file [def: all measured]\n");
+        printf("  -f framenumber print that frame's metrics from a metrics file, no chart, no -o\n");
         printf("  -o output.png\n");
         printf("  -v raise verbosity\n");
 	printf("  -t render filenames into images [def: %d]\n", RENDER_TITLE_DEFAULT);
@@ -47,20 +190,30 @@ int main(int argc, char *argv[])
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->render_title = RENDER_TITLE_DEFAULT;
 	ctx->min_score = 110;
+	ctx->lookup = -1;
 
 	int ch, idx;
 
-	while ((ch = getopt(argc, argv, "?hc:i:o:t:v")) != -1) {
+	while ((ch = getopt(argc, argv, "?hc:f:i:N:o:s:t:v")) != -1) {
 		switch (ch) {
 		case 'c':
 			ctx->cursor_column = atoi(optarg);
 			break;
+		case 'f':
+			ctx->lookup = atoi(optarg);
+			break;
 		case 'i':
 			ctx->ifn = strdup(optarg);
 			break;
+		case 'N':
+			ctx->frames = atoi(optarg);
+			break;
 		case 'o':
 			ctx->ofn = strdup(optarg);
 			break;
+		case 's':
+			ctx->series = strdup(optarg);
+			break;
 		case 't':
 			ctx->render_title = atoi(optarg);
 			break;
@@ -78,104 +231,90 @@ int main(int argc, char *argv[])
 		usage();
 		exit(1);
 	}
+	if (ctx->ifn == NULL || (ctx->ofn == NULL && ctx->lookup < 0)) {
+		fprintf(stderr, "-i and -o are required\n");
+		exit(1);
+	}
 
+	struct metrics_map_s map;
+	if (metrics_map(ctx->ifn, &map) == 0) {
+		if (ctx->verbose) {
+			printf("Found %d frames.\n", map.count);
+		}
 
-	/* Read entire vmaf file, we need a to know the total number of frames */
-	char line[128];
-	FILE *fh = fopen(ctx->ifn, "rb");
-	while (!feof(fh)) {
-		line[0] = 0;
-		fgets(&line[0], sizeof(line), fh);
-		if (feof(fh))
-			break;
-
-		if (line[0] == ' ' || line[0] == ';' || line[0] == '#') {
-			continue;
+		if (ctx->lookup >= 0) {
+			int ret = print_frame(ctx, &map);
+			metrics_unmap(&map);
+			return ret < 0 ? 1 : 0;
 		}
 
-		line[ strlen(line) - 1 ] = 0;
+		vmaftools_context_t *vt = vmaftools_context_alloc();
+		int ret = render_metrics(ctx, vt, &map);
+		vmaftools_context_free(vt);
+		metrics_unmap(&map);
+
+		return ret < 0 ? 1 : 0;
+	}
 
-		ctx->framecount++;
+	float *scores, *aggregates;
+	if (vmafcsv_load(ctx->ifn, &scores, &aggregates, &ctx->framecount) < 0) {
+		fprintf(stderr, "Unable to read %s, aborting\n", ctx->ifn);
+		exit(1);
 	}
 
 	if (ctx->verbose ) {
 		printf("Found %d frames.\n", ctx->framecount);
 	}
 
-	/* Alloc some storage and read the measurements */
-	ctx->measurements = (struct vmaf_measurement_s *)calloc(ctx->framecount, sizeof(struct vmaf_measurement_s));
-	rewind(fh);
-
-	int c = 0;
-	while (!feof(fh)) {
-		line[0] = 0;
-		fgets(&line[0], sizeof(line), fh);
-		if (feof(fh))
-			break;
-
-		if (line[0] == ' ' || line[0] == ';' || line[0] == '#') {
-			continue;
-		}
-
-		line[ strlen(line) - 1 ] = 0;
-
-		if (ctx->verbose ) {
-			printf("[%s]\n", line);
-		}
-
-		int f;
-		float x, y;
-		if (sscanf(&line[0], "%d,%f,%f", &f, &x, &y) != 3) {
-			break;
+	if (ctx->lookup >= 0) {
+		/* The csv is indexed by frame number */
+		if (ctx->lookup >= ctx->framecount) {
+			fprintf(stderr, "Frame %d isn't in %s\n", ctx->lookup, ctx->ifn);
+			exit(1);
 		}
+		printf("frame %d, VMAF %.3f\n", ctx->lookup, scores[ctx->lookup]);
+		free(scores);
+		free(aggregates);
+		return 0;
+	}
 
-		//printf("element write %d\n", c);
-		ctx->measurements[c].fVMAF_score = x;
-		ctx->measurements[c].fVMAF_score_agg = y;
-
-		if (x <= ctx->min_score) {
-			ctx->min_score = x;
+	for (int i = 0; i < ctx->framecount; i++) {
+		if (scores[i] <= ctx->min_score) {
+			ctx->min_score = scores[i];
 		}
-		c++;
 	}
 
 	if (ctx->verbose) {
 		printf("min_score %f\n", ctx->min_score);
 	}
 
-	/* Create a mat where vertical represents vmaf score, right is the number of frame measurements */
-	Mat mOutput = Mat(100, ctx->framecount, CV_8UC3);
-	for (int i = 0; i < ctx->framecount; i++) {
-		//printf("element: i, %f, %f\n", i, ctx->measurements[i].fVMAF_score, ctx->measurements[i].fVMAF_score_agg);
-		cv::line(mOutput, Point(i, mOutput.rows), Point(i, 100 - ctx->measurements[i].fVMAF_score), Scalar(0, 128, 0), 1, LINE_8);
-	}
+	Mat mOutputResized = Mat(1080, 1920, CV_8UC3);
+	struct vmaftools_image_s o = { mOutputResized.data, (int)mOutputResized.step, mOutputResized.cols, mOutputResized.rows };
 
-	/* Draw the cursor column */
-	cv::line(mOutput, Point(ctx->cursor_column, mOutput.rows), Point(ctx->cursor_column, 0), Scalar(0, 0, 250), 2, LINE_8);
+	vmaftools_context_t *vt = vmaftools_context_alloc();
 
-	Mat mOutputResized;
-	cv::resize(mOutput, mOutputResized, Size(1920, 1080), INTER_LINEAR);
+	int frames = ctx->frames ? ctx->frames : 1;
+	for (int i = 0; i < frames; i++) {
+		char fn[PATH_MAX];
+		output_name(ctx, fn, sizeof(fn), ctx->cursor_column + i);
 
-	if (ctx->render_title) {
-		putText(mOutputResized, ctx->ofn, Point(40, 800), FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(255, 255, 255), 2);
+		if (vmaftools_render_chart(vt, scores, aggregates, ctx->framecount, ctx->cursor_column + i, ctx->render_title ? fn : NULL, &o) < 0) {
+			fprintf(stderr, "Failed to render chart, %s\n", vmaftools_error(vt));
+			exit(1);
+		}
 
-		char score[64];
-		sprintf(score, "VMAF_score: %5.2f%%", ctx->measurements[ctx->cursor_column].fVMAF_score);
-		putText(mOutputResized, score, Point(40, 840), FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(250, 250, 150), 2);
+		/* Save */
+		cv::imwrite(fn, mOutputResized, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
 
-		char agg[64];
-		sprintf(agg, "VMAF_average: %5.2f%%", ctx->measurements[ctx->cursor_column].fVMAF_score_agg);
-		putText(mOutputResized, agg, Point(40, 880), FONT_HERSHEY_DUPLEX, 1.0, CV_RGB(250, 250, 150), 2);
+		if (ctx->verbose) {
+			printf("Created %s\n", fn);
+		}
 	}
 
-	/* Save */
-	cv::imwrite(ctx->ofn, mOutputResized, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
-
-	if (ctx->verbose) {
-		printf("Created %s\n", ctx->ofn);
-	}
+	vmaftools_context_free(vt);
+	free(scores);
+	free(aggregates);
 
-	free(ctx->measurements);
 	return 0;
 }
 
@@ -0,0 +1,88 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include "pyramid.h"
+#include "kernels.h"
+
+int pyramid_factor_level(int factor)
+{
+	switch (factor) {
+	case 1:
+		return 0;
+	case 2:
+		return 1;
+	case 4:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+int pyramid_level_valid(int width, int height, int level)
+{
+	/* The chroma planes are half size, they have to decimate evenly too */
+	int m = 2 << level;
+	return level >= 0 && level <= PYRAMID_LEVELS_MAX && width > 0 && height > 0 &&
+		(width % m) == 0 && (height % m) == 0;
+}
+
+size_t pyramid_level_size(int width, int height, int level)
+{
+	size_t w = width >> level;
+	size_t h = height >> level;
+	return (w * h * 3) / 2;
+}
+
+/* One plane, a strip of 2^levels source rows at a time */
+static void pyramid_plane(const struct kernels_s *k, const uint8_t *src, int width, int height, int levels,
+	uint8_t **dst)
+{
+	int rows = 1 << levels;
+
+	for (int y = 0; y < (height >> levels); y++) {
+		const uint8_t *s = src + ((size_t)y * rows * width);
+		int sw = width;
+
+		for (int l = 0; l < levels; l++) {
+			int dw = sw / 2;
+			int n = rows >> (l + 1);
+			uint8_t *d = dst[l] + ((size_t)y * n * dw);
+
+			for (int i = 0; i < n; i++) {
+				k->downsample2_row(s + ((size_t)2 * i * sw), s + ((size_t)((2 * i) + 1) * sw), d + ((size_t)i * dw), dw);
+			}
+
+			s = d;
+			sw = dw;
+		}
+	}
+}
+
+int pyramid_build(const uint8_t *frame, int width, int height, int levels, uint8_t **dst)
+{
+	if (levels == 0) {
+		return 0;
+	}
+	if (!pyramid_level_valid(width, height, levels)) {
+		return -1;
+	}
+
+	const struct kernels_s *k = kernels_get();
+	const uint8_t *src = frame;
+	uint8_t *plane[PYRAMID_LEVELS_MAX];
+
+	/* Y, then U and V at half size, each laid out as in the 4:2:0 frame */
+	for (int p = 0; p < 3; p++) {
+		int pw = p ? width / 2 : width;
+		int ph = p ? height / 2 : height;
+
+		for (int l = 0; l < levels; l++) {
+			size_t luma = (size_t)(width >> (l + 1)) * (height >> (l + 1));
+			plane[l] = dst[l] + (p == 0 ? 0 : luma + ((p - 1) * (luma / 4)));
+		}
+		pyramid_plane(k, src, pw, ph, levels, plane);
+
+		src += (size_t)pw * ph;
+	}
+
+	return 0; /* Success */
+}
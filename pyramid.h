@@ -0,0 +1,35 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Reduced resolution copies of a YUV 4:2:0 frame, for preview runs on 4K/8K.
+ * Each level is a 2x2 box decimation of the one above it, so level 1 is half and
+ * level 2 a quarter of the width and height, and a complete 4:2:0 frame in its
+ * own right. The metrics run on a level unchanged, at 1/4 or 1/16 of the pixels.
+ *
+ * All levels are built in one sweep over the frame. The source is consumed in
+ * strips of 2^levels rows and each level's rows are made while the rows they
+ * come from are still in cache, so the full size frame is read from memory once.
+ */
+
+#define PYRAMID_LEVELS_MAX 2        /* 4x */
+
+/* Level for a downsample factor of 1, 2 or 4, -1 otherwise */
+int pyramid_factor_level(int factor);
+
+/* Non zero when a width x height 4:2:0 frame decimates evenly to level */
+int pyramid_level_valid(int width, int height, int level);
+
+/* Bytes of one 4:2:0 frame at level */
+size_t pyramid_level_size(int width, int height, int level);
+
+/* Build levels 1 .. levels of frame. dst[i] receives level i + 1, sized by
+ * pyramid_level_size(). Returns 0, or -1 if the geometry doesn't decimate.
+ */
+int pyramid_build(const uint8_t *frame, int width, int height, int levels, uint8_t **dst);
+
+#endif /* PYRAMID_H */
@@ -0,0 +1,92 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <string.h>
+
+#include "segment.h"
+
+const char *segment_type_name(enum segment_type_e type)
+{
+	switch (type) {
+	case SEGMENT_SHOT:   return "shot";
+	case SEGMENT_BLACK:  return "black";
+	case SEGMENT_FREEZE: return "freeze";
+	}
+	return "unknown";
+}
+
+void segmenter_init(struct segmenter_s *s, int cut_threshold)
+{
+	memset(s, 0, sizeof(*s));
+	s->cut_threshold = cut_threshold;
+}
+
+int segmenter_push(struct segmenter_s *s, int nr, uint64_t hash, double luma_mean, double prev_mse,
+	struct segment_s *done)
+{
+	enum segment_type_e type = SEGMENT_SHOT;
+	int hd = 64;
+
+	if (s->frames > 0) {
+		hd = __builtin_popcountll(hash ^ s->prev_hash);
+	}
+
+	if (luma_mean < SEGMENT_BLACK_LUMA) {
+		type = SEGMENT_BLACK;
+	} else
+	if (s->frames > 0 && hd == 0 && prev_mse >= 0.0 && prev_mse < SEGMENT_FREEZE_MSE) {
+		type = SEGMENT_FREEZE;
+	}
+
+	s->prev_hash = hash;
+
+	if (s->frames++ == 0) {
+		s->cur.nr = 0;
+		s->cur.start = nr;
+		s->cur.end = nr;
+		s->cur.type = type;
+		s->cur.cut = 0;
+		return 0;
+	}
+
+	int cut = (type == SEGMENT_SHOT && hd >= s->cut_threshold);
+
+	if (type == s->cur.type && !cut) {
+		s->cur.end = nr;
+		return 0;
+	}
+
+	/* Close the running segment, this frame opens the next one */
+	*done = s->cur;
+
+	s->cur.nr = ++s->segments;
+	s->cur.start = nr;
+	s->cur.end = nr;
+	s->cur.type = type;
+	s->cur.cut = cut;
+
+	return 1;
+}
+
+int segmenter_flush(struct segmenter_s *s, struct segment_s *done)
+{
+	if (s->frames == 0) {
+		return 0;
+	}
+
+	*done = s->cur;
+	s->frames = 0;
+
+	return 1;
+}
+
+void segment_print_header(FILE *fh)
+{
+	fprintf(fh, "%8s %9s %9s %7s %7s %4s\n", "#    Seg", "Start", "End", "Frames", "Type", "Cut");
+}
+
+void segment_print(FILE *fh, const struct segment_s *seg)
+{
+	fprintf(fh, "%08d, %08d, %08d, %6d, %6s, %3d\n",
+		seg->nr, seg->start, seg->end, seg->end - seg->start + 1,
+		segment_type_name(seg->type), seg->cut);
+}
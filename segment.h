@@ -0,0 +1,64 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Streaming shot segmentation from consecutive frame DCT hashes.
+ * A cut is declared when the hamming distance between neighbouring frame
+ * hashes jumps above a threshold, black frames are detected from the mean
+ * luma (the DC term of the hash DCT) and freeze frames are repeated frames
+ * with an identical hash and (near) zero pixel difference.
+ */
+
+#define SEGMENT_CUT_THRESHOLD_DEFAULT 20  /* Hamming distance, of 64 bits */
+#define SEGMENT_BLACK_LUMA 24.0           /* Limited range black is 16 */
+#define SEGMENT_FREEZE_MSE 0.5            /* Luma mse vs previous frame */
+
+enum segment_type_e {
+	SEGMENT_SHOT = 0,
+	SEGMENT_BLACK,
+	SEGMENT_FREEZE,
+};
+
+struct segment_s
+{
+	int nr;         /* Segment number, from zero */
+	int start;      /* First frame */
+	int end;        /* Last frame, inclusive */
+	enum segment_type_e type;
+	int cut;        /* 1 = segment began at a scene cut */
+};
+
+struct segmenter_s
+{
+	int cut_threshold;
+
+	int frames;
+	uint64_t prev_hash;
+	struct segment_s cur;
+	int segments;
+};
+
+const char *segment_type_name(enum segment_type_e type);
+
+void segmenter_init(struct segmenter_s *s, int cut_threshold);
+
+/* Push the next frame (frames must arrive in order, nr counting from the
+ * first frame pushed). prev_mse is the luma mse against the previous frame,
+ * or a negative value when unknown.
+ * Returns 1 and fills 'done' when a segment closed, the current frame
+ * then belongs to the new segment. Returns 0 otherwise.
+ */
+int segmenter_push(struct segmenter_s *s, int nr, uint64_t hash, double luma_mean, double prev_mse,
+	struct segment_s *done);
+
+/* Close the final segment at end of stream, returns 1 if 'done' was filled. */
+int segmenter_flush(struct segmenter_s *s, struct segment_s *done);
+
+void segment_print_header(FILE *fh);
+void segment_print(FILE *fh, const struct segment_s *seg);
+
+#endif /* SEGMENT_H */
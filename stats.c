@@ -0,0 +1,328 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "stats.h"
+
+void stats_running_reset(struct stats_running_s *r)
+{
+	memset(r, 0, sizeof(*r));
+	r->min = INFINITY;
+	r->max = -INFINITY;
+}
+
+void stats_running_add(struct stats_running_s *r, double value)
+{
+	r->count++;
+
+	/* Welford, numerically stable over millions of frames */
+	double delta = value - r->mean;
+	r->mean += delta / r->count;
+	r->m2 += delta * (value - r->mean);
+
+	if (value < r->min) {
+		r->min = value;
+	}
+	if (value > r->max) {
+		r->max = value;
+	}
+
+	if (value > 0.0) {
+		r->sum_reciprocal += 1.0 / value;
+		r->count_reciprocal++;
+	}
+}
+
+double stats_running_variance(const struct stats_running_s *r)
+{
+	if (r->count < 2) {
+		return 0.0;
+	}
+	return r->m2 / (r->count - 1);
+}
+
+double stats_running_stddev(const struct stats_running_s *r)
+{
+	return sqrt(stats_running_variance(r));
+}
+
+double stats_running_harmonic_mean(const struct stats_running_s *r)
+{
+	if (r->count_reciprocal == 0) {
+		return 0.0;
+	}
+	return r->count_reciprocal / r->sum_reciprocal;
+}
+
+/* Two sided 95% Student t critical values, df 1..30 */
+static const double t95[30] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+static double stats_t95(uint64_t df)
+{
+	if (df == 0) {
+		return INFINITY;
+	}
+	if (df <= 30) {
+		return t95[df - 1];
+	}
+	/* Within 0.002 of the table from 30 up, 1.96 in the limit */
+	return 1.96 + (2.4 / df);
+}
+
+/* Sampling without replacement from a finite population, the variance of the
+ * mean shrinks by (N - n) / (N - 1) as the sample approaches the whole.
+ */
+static double stats_fpc(uint64_t n, uint64_t population)
+{
+	if (population <= 1 || n >= population) {
+		return 0.0;
+	}
+	return (double)(population - n) / (population - 1);
+}
+
+double stats_running_ci95(const struct stats_running_s *r, uint64_t population)
+{
+	if (r->count < 2) {
+		return INFINITY;
+	}
+	return stats_t95(r->count - 1) * sqrt(stats_running_variance(r) / r->count * stats_fpc(r->count, population));
+}
+
+void stats_proportion_ci95(uint64_t hits, uint64_t n, uint64_t population, double *lo, double *hi)
+{
+	if (n == 0) {
+		*lo = 0.0;
+		*hi = 1.0;
+		return;
+	}
+
+	/* Wilson score, the correction scales z^2. Stays honest at 0 or n hits where
+	 * the Wald interval collapses to zero width, a census collapses to p exactly.
+	 */
+	double p = (double)hits / n;
+	double z2 = 1.96 * 1.96 * stats_fpc(n, population);
+	double d = 1.0 + z2 / n;
+	double center = (p + z2 / (2.0 * n)) / d;
+	double hw = sqrt(z2 * (p * (1.0 - p) / n + z2 / (4.0 * n * n))) / d;
+
+	*lo = center - hw < 0.0 ? 0.0 : center - hw;
+	*hi = center + hw > 1.0 ? 1.0 : center + hw;
+}
+
+void stats_hist_reset(struct stats_hist_s *h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+void stats_hist_add(struct stats_hist_s *h, double mse)
+{
+	h->count++;
+
+	if (mse <= 0.0) {
+		h->zero++;
+		return;
+	}
+
+	int bin = (int)(log2(1.0 + mse) * STATS_HIST_BINS_PER_OCTAVE);
+	if (bin >= STATS_HIST_BINS) {
+		bin = STATS_HIST_BINS - 1;
+	}
+	h->bins[bin]++;
+}
+
+/* Return the MSE value at percentile pct (0..100), or 0 when no data. */
+double stats_hist_percentile(const struct stats_hist_s *h, double pct)
+{
+	if (h->count == 0) {
+		return 0.0;
+	}
+
+	/* Nearest rank */
+	uint64_t rank = (uint64_t)ceil((pct / 100.0) * h->count);
+	if (rank < 1) {
+		rank = 1;
+	}
+
+	uint64_t seen = h->zero;
+	if (seen >= rank) {
+		return 0.0;
+	}
+
+	for (int i = 0; i < STATS_HIST_BINS; i++) {
+		seen += h->bins[i];
+		if (seen >= rank) {
+			/* Geometric bin center */
+			return exp2((i + 0.5) / STATS_HIST_BINS_PER_OCTAVE) - 1.0;
+		}
+	}
+
+	return 65025.0;
+}
+
+double stats_psnr_from_sse(double sse, uint64_t pixels, double max_pixel_value)
+{
+	if (sse <= 0.0) {
+		return INFINITY;  // Perfect match
+	}
+	return 10.0 * log10((max_pixel_value * max_pixel_value * pixels) / sse);
+}
+
+void stats_aggregate_init(struct stats_aggregate_s *a, int width, int height)
+{
+	memset(a, 0, sizeof(*a));
+
+	a->plane[0].pixels = (uint64_t)width * height;
+	a->plane[1].pixels = (uint64_t)(width / 2) * (height / 2);
+	a->plane[2].pixels = (uint64_t)(width / 2) * (height / 2);
+
+	for (int i = 0; i < 3; i++) {
+		stats_running_reset(&a->plane[i].mse);
+		stats_running_reset(&a->plane[i].psnr);
+		stats_hist_reset(&a->plane[i].hist);
+	}
+	stats_running_reset(&a->sharpness[0]);
+	stats_running_reset(&a->sharpness[1]);
+	stats_running_reset(&a->hamming);
+}
+
+void stats_aggregate_add(struct stats_aggregate_s *a, const double mse[3], const double psnr[3],
+	const double sharpness[2], int hamming)
+{
+	a->frames++;
+
+	for (int i = 0; i < 3; i++) {
+		struct stats_plane_s *p = &a->plane[i];
+
+		p->sse += mse[i] * p->pixels;
+		stats_running_add(&p->mse, mse[i]);
+		if (isfinite(psnr[i])) {
+			stats_running_add(&p->psnr, psnr[i]);
+		}
+		stats_hist_add(&p->hist, mse[i]);
+	}
+
+	stats_running_add(&a->sharpness[0], sharpness[0]);
+	stats_running_add(&a->sharpness[1], sharpness[1]);
+	stats_running_add(&a->hamming, hamming);
+}
+
+void stats_aggregate_print(const struct stats_aggregate_s *a, FILE *fh, const char *label)
+{
+	static const char *planes[] = { "Y", "U", "V" };
+	const double max_pixel_value = 255.0;
+
+	fprintf(fh, "# %s: %" PRIu64 " frames\n", label, a->frames);
+	if (a->frames == 0) {
+		return;
+	}
+
+	fprintf(fh, "# %5s %9s %9s %9s %9s %9s %9s %9s | %9s %9s %9s %9s %9s %9s\n",
+		"Plane", "MSE mean", "stddev", "min", "max", "p50", "p95", "p99",
+		"PSNR glob", "mean", "hmean", "min", "p1", "p5");
+
+	for (int i = 0; i < 3; i++) {
+		const struct stats_plane_s *p = &a->plane[i];
+
+		/* Global PSNR from the summed SSE, not the mean of per frame dB values */
+		double global = stats_psnr_from_sse(p->sse, p->pixels * a->frames, max_pixel_value);
+
+		fprintf(fh, "# %5s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f | %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+			planes[i],
+			p->mse.mean, stats_running_stddev(&p->mse), p->mse.min, p->mse.max,
+			stats_hist_percentile(&p->hist, 50.0),
+			stats_hist_percentile(&p->hist, 95.0),
+			stats_hist_percentile(&p->hist, 99.0),
+			global,
+			/* All frames identical leaves no finite PSNR values, report inf */
+			p->psnr.count ? p->psnr.mean : INFINITY,
+			p->psnr.count ? stats_running_harmonic_mean(&p->psnr) : INFINITY,
+			stats_psnr_from_sse(p->mse.max * p->pixels, p->pixels, max_pixel_value),
+			stats_psnr_from_sse(stats_hist_percentile(&p->hist, 99.0) * p->pixels, p->pixels, max_pixel_value),
+			stats_psnr_from_sse(stats_hist_percentile(&p->hist, 95.0) * p->pixels, p->pixels, max_pixel_value));
+	}
+
+	fprintf(fh, "# %5s %9s %9s %9s %9s\n", "", "mean", "stddev", "min", "max");
+	for (int i = 0; i < 2; i++) {
+		fprintf(fh, "# %4s%d %9.2f %9.2f %9.2f %9.2f\n", "Shp", i + 1,
+			a->sharpness[i].mean, stats_running_stddev(&a->sharpness[i]),
+			a->sharpness[i].min, a->sharpness[i].max);
+	}
+	fprintf(fh, "# %5s %9.2f %9.2f %9.0f %9.0f\n", "Hamm",
+		a->hamming.mean, stats_running_stddev(&a->hamming), a->hamming.min, a->hamming.max);
+}
+
+int stats_window_alloc(struct stats_window_s *w, int size, int width, int height)
+{
+	memset(w, 0, sizeof(*w));
+	w->size = size;
+	w->pixels[0] = (uint64_t)width * height;
+	w->pixels[1] = (uint64_t)(width / 2) * (height / 2);
+	w->pixels[2] = (uint64_t)(width / 2) * (height / 2);
+
+	for (int i = 0; i < 3; i++) {
+		w->sse[i] = (double *)calloc(size, sizeof(double));
+		if (w->sse[i] == NULL) {
+			stats_window_free(w);
+			return -1;
+		}
+	}
+
+	return 0; /* Success */
+}
+
+void stats_window_free(struct stats_window_s *w)
+{
+	for (int i = 0; i < 3; i++) {
+		free(w->sse[i]);
+		w->sse[i] = NULL;
+	}
+}
+
+void stats_window_add(struct stats_window_s *w, const double mse[3])
+{
+	for (int i = 0; i < 3; i++) {
+		double sse = mse[i] * w->pixels[i];
+		w->sum[i] += sse - w->sse[i][w->pos];
+		w->sse[i][w->pos] = sse;
+	}
+
+	if (w->count < w->size) {
+		w->count++;
+	}
+
+	if (++w->pos == w->size) {
+		w->pos = 0;
+
+		/* Rebase the running sums once per lap so add/subtract rounding can't drift */
+		for (int i = 0; i < 3; i++) {
+			w->sum[i] = 0;
+			for (int j = 0; j < w->count; j++) {
+				w->sum[i] += w->sse[i][j];
+			}
+		}
+	}
+}
+
+int stats_window_full(const struct stats_window_s *w)
+{
+	return w->size > 0 && w->count == w->size;
+}
+
+double stats_window_psnr(const struct stats_window_s *w, int plane)
+{
+	return stats_psnr_from_sse(w->sum[plane], w->pixels[plane] * w->count, 255.0);
+}
+
+double stats_window_mse(const struct stats_window_s *w, int plane)
+{
+	if (w->count == 0) {
+		return 0.0;
+	}
+	return w->sum[plane] / (w->pixels[plane] * w->count);
+}
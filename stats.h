@@ -0,0 +1,103 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+/* Constant memory running aggregates for the per frame measurements.
+ * Nothing here depends on the number of frames processed, so a multi hour
+ * file costs the same as a short clip.
+ */
+
+/* Log domain MSE histogram, 256 bins per octave of (1 + mse), covering
+ * the full 8bit range (mse <= 65025). Worst case error is ~0.3% of the MSE,
+ * far below anything visible in a PSNR to two decimal places.
+ * PSNR is monotonic in MSE, so PSNR percentiles are read from the same
+ * histogram (PSNR p1 == MSE p99).
+ */
+#define STATS_HIST_BINS_PER_OCTAVE 256
+#define STATS_HIST_BINS (17 * STATS_HIST_BINS_PER_OCTAVE)
+
+struct stats_hist_s
+{
+	uint64_t count;
+	uint64_t zero;  /* Identical frames, mse == 0, psnr == inf */
+	uint64_t bins[STATS_HIST_BINS];
+};
+
+/* Welford mean / variance, min and max, plus a harmonic mean accumulator. */
+struct stats_running_s
+{
+	uint64_t count;
+	double mean;
+	double m2;
+	double min;
+	double max;
+	double sum_reciprocal;
+	uint64_t count_reciprocal;
+};
+
+struct stats_plane_s
+{
+	uint64_t pixels;          /* Per frame */
+	double sse;               /* Summed squared error, all frames */
+	struct stats_running_s mse;
+	struct stats_running_s psnr; /* Finite values only */
+	struct stats_hist_s hist;
+};
+
+struct stats_aggregate_s
+{
+	uint64_t frames;
+	struct stats_plane_s plane[3]; /* Y, U, V */
+	struct stats_running_s sharpness[2];
+	struct stats_running_s hamming;
+};
+
+/* Sliding window over the last N frames, a ring of per frame SSE values. */
+struct stats_window_s
+{
+	int size;
+	int count;
+	int pos;
+	uint64_t pixels[3];
+	double *sse[3];
+	double sum[3];
+};
+
+void   stats_running_reset(struct stats_running_s *r);
+void   stats_running_add(struct stats_running_s *r, double value);
+double stats_running_variance(const struct stats_running_s *r);
+double stats_running_stddev(const struct stats_running_s *r);
+double stats_running_harmonic_mean(const struct stats_running_s *r);
+
+/* 95% confidence intervals when the values are a random sample of population
+ * frames, both with the finite population correction. The mean's half width uses
+ * Student t, the proportion (hits of n) gets Wilson score bounds in 0..1.
+ */
+double stats_running_ci95(const struct stats_running_s *r, uint64_t population);
+void   stats_proportion_ci95(uint64_t hits, uint64_t n, uint64_t population, double *lo, double *hi);
+
+void   stats_hist_reset(struct stats_hist_s *h);
+void   stats_hist_add(struct stats_hist_s *h, double mse);
+double stats_hist_percentile(const struct stats_hist_s *h, double pct);
+
+double stats_psnr_from_sse(double sse, uint64_t pixels, double max_pixel_value);
+
+/* Plane dimensions are needed up front, so that SSE can be recovered from the per frame MSE */
+void   stats_aggregate_init(struct stats_aggregate_s *a, int width, int height);
+void   stats_aggregate_add(struct stats_aggregate_s *a, const double mse[3], const double psnr[3],
+	const double sharpness[2], int hamming);
+void   stats_aggregate_print(const struct stats_aggregate_s *a, FILE *fh, const char *label);
+
+int    stats_window_alloc(struct stats_window_s *w, int size, int width, int height);
+void   stats_window_free(struct stats_window_s *w);
+void   stats_window_add(struct stats_window_s *w, const double mse[3]);
+int    stats_window_full(const struct stats_window_s *w);
+double stats_window_psnr(const struct stats_window_s *w, int plane);
+double stats_window_mse(const struct stats_window_s *w, int plane);
+
+#endif /* STATS_H */
@@ -0,0 +1,57 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vmafcsv.h"
+
+int vmafcsv_load(const char *fn, float **scores, float **aggregates, int *count)
+{
+	FILE *fh = fopen(fn, "rb");
+	if (fh == NULL) {
+		return -1;
+	}
+
+	int c = 0, allocated = 0;
+	float *s = NULL, *a = NULL;
+
+	char line[128];
+	while (fgets(&line[0], sizeof(line), fh)) {
+		if (line[0] == ' ' || line[0] == ';' || line[0] == '#') {
+			continue;
+		}
+
+		int f;
+		float x, y;
+		if (sscanf(&line[0], "%d,%f,%f", &f, &x, &y) != 3) {
+			break;
+		}
+
+		if (c == allocated) {
+			allocated = allocated ? allocated * 2 : 4096;
+			float *ns = (float *)realloc(s, allocated * sizeof(float));
+			float *na = (float *)realloc(a, allocated * sizeof(float));
+			if (ns == NULL || na == NULL) {
+				free(ns ? ns : s);
+				free(na ? na : a);
+				fclose(fh);
+				return -1;
+			}
+			s = ns;
+			a = na;
+		}
+
+		s[c] = x;
+		a[c] = y;
+		c++;
+	}
+
+	fclose(fh);
+
+	*scores = s;
+	*aggregates = a;
+	*count = c;
+
+	return 0; /* Success */
+}
@@ -0,0 +1,15 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef VMAFCSV_H
+#define VMAFCSV_H
+
+/* The per frame VMAF csv picvmaf consumes, one "frame,score,aggregate" line per
+ * frame. Lines starting with ' ', ';' or '#' are skipped, parsing stops at the
+ * first malformed line.
+ *
+ * On success *scores and *aggregates are malloc'd arrays of *count values,
+ * owned by the caller. Returns 0 on success, -1 if the file can't be read.
+ */
+int vmafcsv_load(const char *fn, float **scores, float **aggregates, int *count);
+
+#endif /* VMAFCSV_H */
@@ -0,0 +1,662 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "vmaftools.h"
+#include "kernels.h"
+#include "dcthash.h"
+#include "blockmse.h"
+#include "align.h"
+#include "overlay.h"
+
+using namespace cv;
+
+struct vmaftools_context_s
+{
+	char error[256];
+
+	int dx;
+	int dy;
+
+	/* Scratch, reused from call to call so steady state rendering doesn't allocate */
+	Mat chart;
+	uint8_t *plane[2];      /* Contiguous copies of strided planes, for the align search */
+	size_t plane_size;
+	struct overlay_s *overlay;  /* Glyph atlas and cached labels, built on first use */
+};
+
+static const uint8_t title_colour[3] = { 255, 255, 255 };
+static const uint8_t score_colour[3] = { 150, 250, 250 };   /* BGR */
+
+static int set_error(vmaftools_context_t *ctx, const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(ctx->error, sizeof(ctx->error), fmt, ap);
+	va_end(ap);
+
+	return -1;
+}
+
+static int plane_valid(const struct vmaftools_plane_s *p, int width, int height)
+{
+	return p->data && p->width == width && p->height == height && p->stride >= width;
+}
+
+static int image_valid(const struct vmaftools_image_s *i)
+{
+	return i && i->data && i->width > 0 && i->height > 0 && i->stride >= i->width * 3;
+}
+
+static Mat image_mat(const struct vmaftools_image_s *i)
+{
+	return Mat(i->height, i->width, CV_8UC3, i->data, i->stride);
+}
+
+/* Draw text with its baseline at (x, y), returns the pen x after it. Labels are
+ * cached whole when cache is set, see overlay.h.
+ */
+static int draw_text(vmaftools_context_t *ctx, uint8_t *data, int stride, int width, int height, int channels,
+	const char *text, int x, int y, const uint8_t colour[3], int cache)
+{
+	if (ctx->overlay == NULL && (ctx->overlay = overlay_alloc()) == NULL) {
+		return x;
+	}
+	return overlay_text(ctx->overlay, data, stride, width, height, channels, text, x, y, colour, cache);
+}
+
+static double psnr_from_mse(double mse)
+{
+	if (mse == 0) {
+		return INFINITY; /* Perfect match */
+	}
+	return 10.0 * log10((255.0 * 255.0) / mse);
+}
+
+int vmaftools_api_version(void)
+{
+	return VMAFTOOLS_API_VERSION;
+}
+
+vmaftools_context_t *vmaftools_context_alloc(void)
+{
+	vmaftools_context_t *ctx = new (std::nothrow) vmaftools_context_s();
+	if (ctx == NULL) {
+		return NULL;
+	}
+	strcpy(ctx->error, "no error");
+
+	return ctx;
+}
+
+void vmaftools_context_free(vmaftools_context_t *ctx)
+{
+	if (ctx == NULL) {
+		return;
+	}
+
+	free(ctx->plane[0]);
+	free(ctx->plane[1]);
+	overlay_free(ctx->overlay);
+	delete ctx;
+}
+
+const char *vmaftools_error(vmaftools_context_t *ctx)
+{
+	return ctx->error;
+}
+
+const char *vmaftools_kernels(void)
+{
+	return kernels_get()->name;
+}
+
+void vmaftools_set_offset(vmaftools_context_t *ctx, int dx, int dy)
+{
+	ctx->dx = dx;
+	ctx->dy = dy;
+}
+
+int vmaftools_frame_stats(vmaftools_context_t *ctx, const struct vmaftools_frame_s *ref,
+	const struct vmaftools_frame_s *dist, struct vmaftools_frame_stats_s *stats)
+{
+	int width = ref->plane[0].width;
+	int height = ref->plane[0].height;
+
+	memset(stats, 0, sizeof(*stats));
+
+	const struct vmaftools_frame_s *frames[2] = { ref, dist };
+	for (int i = 0; i < 2; i++) {
+		if (frames[i] == NULL) {
+			continue;
+		}
+		if (!plane_valid(&frames[i]->plane[0], width, height) ||
+			!plane_valid(&frames[i]->plane[1], width / 2, height / 2) ||
+			!plane_valid(&frames[i]->plane[2], width / 2, height / 2)) {
+			return set_error(ctx, "frame %d isn't a valid %dx%d 4:2:0 frame", i, width, height);
+		}
+	}
+	if (width < 2 || height < 2) {
+		return set_error(ctx, "frame %dx%d is too small", width, height);
+	}
+
+	if (dist) {
+		if (abs(ctx->dx) >= width / 2 || abs(ctx->dy) >= height / 2) {
+			return set_error(ctx, "offset %d, %d leaves no overlap", ctx->dx, ctx->dy);
+		}
+
+		const uint8_t *a[3], *b[3];
+		int astride[3], bstride[3];
+		for (int p = 0; p < 3; p++) {
+			a[p] = ref->plane[p].data;
+			astride[p] = ref->plane[p].stride;
+			b[p] = dist->plane[p].data;
+			bstride[p] = dist->plane[p].stride;
+		}
+
+		blockmse_frame_420(a, astride, b, bstride, width, height, ctx->dx, ctx->dy, NULL, stats->mse);
+		for (int p = 0; p < 3; p++) {
+			stats->psnr[p] = psnr_from_mse(stats->mse[p]);
+		}
+	}
+
+	try {
+		for (int i = 0; i < 2; i++) {
+			if (frames[i] == NULL) {
+				continue;
+			}
+			const struct vmaftools_plane_s *y = &frames[i]->plane[0];
+			stats->sharpness[i] = kernels_laplacian_variance(y->data, y->stride, y->width, y->height);
+			stats->hash[i] = dcthash_compute(y->data, y->stride, y->width, y->height, &stats->luma_mean[i], NULL);
+		}
+	} catch (const cv::Exception &e) {
+		return set_error(ctx, "%s", e.what());
+	}
+
+	return 0; /* Success */
+}
+
+int vmaftools_dct_hash(vmaftools_context_t *ctx, const struct vmaftools_plane_s *luma, uint64_t *hash, double *mean)
+{
+	if (!plane_valid(luma, luma->width, luma->height) || luma->width < 1 || luma->height < 1) {
+		return set_error(ctx, "invalid luma plane");
+	}
+
+	try {
+		*hash = dcthash_compute(luma->data, luma->stride, luma->width, luma->height, mean, NULL);
+	} catch (const cv::Exception &e) {
+		return set_error(ctx, "%s", e.what());
+	}
+
+	return 0; /* Success */
+}
+
+int vmaftools_align_search(vmaftools_context_t *ctx, const struct vmaftools_plane_s *ref,
+	const struct vmaftools_plane_s *dist, int range, struct vmaftools_offset_s *offset)
+{
+	int width = ref->width;
+	int height = ref->height;
+
+	if (!plane_valid(ref, width, height) || !plane_valid(dist, width, height)) {
+		return set_error(ctx, "planes must be the same size");
+	}
+
+	/* The search wants stride == width, pack strided planes into the context scratch */
+	const uint8_t *p[2] = { ref->data, dist->data };
+	const struct vmaftools_plane_s *src[2] = { ref, dist };
+	size_t size = (size_t)width * height;
+	for (int i = 0; i < 2; i++) {
+		if (src[i]->stride == width) {
+			continue;
+		}
+		if (ctx->plane_size < size) {
+			free(ctx->plane[0]);
+			free(ctx->plane[1]);
+			ctx->plane[0] = (uint8_t *)malloc(size);
+			ctx->plane[1] = (uint8_t *)malloc(size);
+			ctx->plane_size = size;
+			if (ctx->plane[0] == NULL || ctx->plane[1] == NULL) {
+				ctx->plane_size = 0;
+				return set_error(ctx, "out of memory");
+			}
+		}
+		for (int y = 0; y < height; y++) {
+			memcpy(ctx->plane[i] + ((size_t)y * width), src[i]->data + ((size_t)y * src[i]->stride), width);
+		}
+		p[i] = ctx->plane[i];
+	}
+
+	struct spatial_offset_s result;
+	if (align_spatial_search(p[0], p[1], width, height, range, &result, 0) < 0) {
+		return set_error(ctx, "%dx%d is too small to search +/- %d pixels", width, height, range);
+	}
+
+	offset->dx = result.dx;
+	offset->dy = result.dy;
+	offset->sad = result.sad;
+
+	return 0; /* Success */
+}
+
+/* Pass one, absdiff into dst tracking the difference range (and optionally the SSE).
+ * Pass two, when normalizing, rescales dst in place through a 256 entry table.
+ */
+static void diff_rows(const uint8_t *a, int astride, const uint8_t *b, int bstride, uint8_t *dst, int dstride,
+	int n, int rows, int normalize, uint64_t *sse)
+{
+	const struct kernels_s *k = kernels_get();
+	uint8_t dmin = 255, dmax = 0;
+
+	for (int y = 0; y < rows; y++) {
+		const uint8_t *pa = a + ((size_t)y * astride);
+		const uint8_t *pb = b + ((size_t)y * bstride);
+		uint8_t *pd = dst + ((size_t)y * dstride);
+
+		if (normalize) {
+			uint8_t lo, hi;
+			k->absdiff_minmax_u8(pa, pb, pd, n, &lo, &hi);
+			dmin = lo < dmin ? lo : dmin;
+			dmax = hi > dmax ? hi : dmax;
+		} else {
+			k->absdiff_u8(pa, pb, pd, n);
+		}
+		if (sse) {
+			*sse += k->sse_u8(pa, pb, n);
+		}
+	}
+
+	if (!normalize) {
+		return;
+	}
+
+	/* normalize(150, 255, NORM_MINMAX) is a linear map over 256 possible values,
+	 * build it once as a table, same scale/shift/rounding as OpenCV.
+	 */
+	double scale = dmax > dmin ? (255.0 - 150.0) / (dmax - dmin) : 0.0;
+	double shift = 150.0 - dmin * scale;
+	uint8_t lut[256];
+	for (int i = 0; i < 256; i++) {
+		lut[i] = saturate_cast<uint8_t>(i * scale + shift);
+	}
+
+	for (int y = 0; y < rows; y++) {
+		uint8_t *pd = dst + ((size_t)y * dstride);
+		for (int x = 0; x < n; x++) {
+			pd[x] = lut[pd[x]];
+		}
+	}
+}
+
+int vmaftools_render_diff(vmaftools_context_t *ctx, const struct vmaftools_image_s *a,
+	const struct vmaftools_image_s *b, int normalize, const char *title, struct vmaftools_image_s *out)
+{
+	if (!image_valid(a) || !image_valid(b) || !image_valid(out)) {
+		return set_error(ctx, "invalid image");
+	}
+	if (a->width != b->width || a->height != b->height || a->width != out->width || a->height != out->height) {
+		return set_error(ctx, "images are %dx%d, %dx%d and %dx%d, they must match",
+			a->width, a->height, b->width, b->height, out->width, out->height);
+	}
+
+	diff_rows(a->data, a->stride, b->data, b->stride, out->data, out->stride, a->width * 3, a->height, normalize, NULL);
+
+	if (title) {
+		draw_text(ctx, out->data, out->stride, out->width, out->height, 3, title, 10, 40, title_colour, 1);
+	}
+
+	return 0; /* Success */
+}
+
+int vmaftools_render_diff_luma(vmaftools_context_t *ctx, const struct vmaftools_plane_s *a,
+	const struct vmaftools_plane_s *b, int normalize, const char *title, uint8_t *out, int out_stride, double *mse)
+{
+	if (!plane_valid(a, a->width, a->height) || !plane_valid(b, a->width, a->height) || a->width < 1 || a->height < 1) {
+		return set_error(ctx, "planes must be the same size");
+	}
+	if (out == NULL || out_stride < a->width) {
+		return set_error(ctx, "invalid output plane");
+	}
+
+	uint64_t sse = 0;
+	diff_rows(a->data, a->stride, b->data, b->stride, out, out_stride, a->width, a->height, normalize, &sse);
+
+	if (mse) {
+		*mse = (double)sse / ((double)a->width * a->height);
+	}
+
+	if (title) {
+		draw_text(ctx, out, out_stride, a->width, a->height, 1, title, 10, 40, title_colour, 1);
+	}
+
+	return 0; /* Success */
+}
+
+int vmaftools_render_mosaic(vmaftools_context_t *ctx, const struct vmaftools_image_s *tiles[],
+	const char *titles[], int cols, int rows, int scale, struct vmaftools_image_s *out)
+{
+	if (cols <= 0 || rows <= 0) {
+		return set_error(ctx, "invalid %dx%d grid", cols, rows);
+	}
+	if (!image_valid(out) || out->width < cols || out->height < rows) {
+		return set_error(ctx, "invalid output image");
+	}
+	for (int i = 0; i < cols * rows; i++) {
+		if (tiles[i] && !image_valid(tiles[i])) {
+			return set_error(ctx, "invalid tile %d", i);
+		}
+	}
+
+	int cw = out->width / cols;
+	int ch = out->height / rows;
+
+	try {
+		Mat mOutput = image_mat(out);
+
+		for (int i = 0; i < cols * rows; i++) {
+			Mat cell = mOutput(Rect((i % cols) * cw, (i / cols) * ch, cw, ch));
+
+			if (tiles[i] == NULL) {
+				cell.setTo(Scalar(0, 0, 0));
+				continue;
+			}
+
+			Mat tile = image_mat(tiles[i]);
+			if (tile.data == cell.data && tile.cols == cw && tile.rows == ch) {
+				/* Decoded straight into its cell by the caller, nothing to move */
+			} else if (scale) {
+				resize(tile, cell, cell.size(), 0, 0, tile.cols > cw ? INTER_AREA : INTER_LINEAR);
+			} else {
+				/* Top left, cropped to the cell, the remainder cleared */
+				int w = tile.cols < cw ? tile.cols : cw;
+				int h = tile.rows < ch ? tile.rows : ch;
+				if (w < cw || h < ch) {
+					cell.setTo(Scalar(0, 0, 0));
+				}
+				Mat dst = cell(Rect(0, 0, w, h));
+				tile(Rect(0, 0, w, h)).copyTo(dst);
+			}
+
+			if (titles && titles[i]) {
+				draw_text(ctx, cell.data, (int)cell.step, cell.cols, cell.rows, 3, titles[i], 10, 40, title_colour, 1);
+			}
+		}
+
+		/* Rounding slack right and bottom of the grid */
+		if (out->width > cw * cols) {
+			mOutput(Rect(cw * cols, 0, out->width - (cw * cols), out->height)).setTo(Scalar(0, 0, 0));
+		}
+		if (out->height > ch * rows) {
+			mOutput(Rect(0, ch * rows, out->width, out->height - (ch * rows))).setTo(Scalar(0, 0, 0));
+		}
+	} catch (const cv::Exception &e) {
+		return set_error(ctx, "%s", e.what());
+	}
+
+	return 0; /* Success */
+}
+
+int vmaftools_render_composite(vmaftools_context_t *ctx, const struct vmaftools_image_s *tiles[4],
+	const char *titles[4], struct vmaftools_image_s *out)
+{
+	int max_cols = 0, max_rows = 0;
+
+	for (int i = 0; i < 4; i++) {
+		if (tiles[i] == NULL) {
+			continue;
+		}
+		if (!image_valid(tiles[i])) {
+			return set_error(ctx, "invalid tile %d", i);
+		}
+		max_cols = tiles[i]->width > max_cols ? tiles[i]->width : max_cols;
+		max_rows = tiles[i]->height > max_rows ? tiles[i]->height : max_rows;
+	}
+	if (max_cols == 0) {
+		return set_error(ctx, "no tiles");
+	}
+	if (!image_valid(out) || out->width != max_cols * 2 || out->height != max_rows * 2) {
+		return set_error(ctx, "output must be %dx%d", max_cols * 2, max_rows * 2);
+	}
+
+	return vmaftools_render_mosaic(ctx, tiles, titles, 2, 2, 0, out);
+}
+
+int vmaftools_render_chart(vmaftools_context_t *ctx, const float *scores, const float *aggregates,
+	int count, int cursor, const char *title, struct vmaftools_image_s *out)
+{
+	if (count <= 0 || scores == NULL) {
+		return set_error(ctx, "no scores");
+	}
+	if (cursor < 0 || cursor >= count) {
+		return set_error(ctx, "cursor %d is outside frames 0..%d", cursor, count - 1);
+	}
+	if (!image_valid(out)) {
+		return set_error(ctx, "invalid output image");
+	}
+
+	try {
+		/* A mat where vertical represents vmaf score, right is the number of frame measurements */
+		ctx->chart.create(100, count, CV_8UC3);
+		ctx->chart.setTo(Scalar(0, 0, 0));
+		for (int i = 0; i < count; i++) {
+			cv::line(ctx->chart, Point(i, ctx->chart.rows), Point(i, 100 - scores[i]), Scalar(0, 128, 0), 1, LINE_8);
+		}
+
+		/* Draw the cursor column */
+		cv::line(ctx->chart, Point(cursor, ctx->chart.rows), Point(cursor, 0), Scalar(0, 0, 250), 2, LINE_8);
+
+		Mat mOutput = image_mat(out);
+		cv::resize(ctx->chart, mOutput, mOutput.size(), 0, 0, INTER_LINEAR);
+
+		if (title) {
+			draw_text(ctx, out->data, out->stride, out->width, out->height, 3, title, 40, 800, title_colour, 1);
+
+			/* Captions are cached, only the digits change from frame to frame */
+			char value[64];
+			int x = draw_text(ctx, out->data, out->stride, out->width, out->height, 3, "VMAF_score: ", 40, 840, score_colour, 1);
+			sprintf(value, "%5.2f%%", scores[cursor]);
+			draw_text(ctx, out->data, out->stride, out->width, out->height, 3, value, x, 840, score_colour, 0);
+
+			if (aggregates) {
+				x = draw_text(ctx, out->data, out->stride, out->width, out->height, 3, "VMAF_average: ", 40, 880, score_colour, 1);
+				sprintf(value, "%5.2f%%", aggregates[cursor]);
+				draw_text(ctx, out->data, out->stride, out->width, out->height, 3, value, x, 880, score_colour, 0);
+			}
+		}
+	} catch (const cv::Exception &e) {
+		return set_error(ctx, "%s", e.what());
+	}
+
+	return 0; /* Success */
+}
+
+struct vmaftools_chart_s
+{
+	int count;
+	int width;
+	int height;
+	int top;                /* Plot area rows, captions go below */
+	int bottom;
+
+	int nseries;
+	struct vmaftools_series_s series[VMAFTOOLS_CHART_SERIES_MAX];
+	char prefix[VMAFTOOLS_CHART_SERIES_MAX][64];   /* "VMAF (mean 93.40): ", cached as a strip */
+
+	Mat background;         /* Series and legend, copied under every cursor frame */
+};
+
+static float series_value(const struct vmaftools_series_s *s, int frame)
+{
+	return *(const float *)((const uint8_t *)s->values + ((size_t)frame * s->stride));
+}
+
+vmaftools_chart_t *vmaftools_chart_alloc(vmaftools_context_t *ctx, const struct vmaftools_series_s *series,
+	int nseries, int count, int width, int height)
+{
+	if (nseries <= 0 || nseries > VMAFTOOLS_CHART_SERIES_MAX || count <= 0) {
+		set_error(ctx, "%d series over %d frames, 1..%d series are supported", nseries, count, VMAFTOOLS_CHART_SERIES_MAX);
+		return NULL;
+	}
+	if (width < 2 || height < 20) {
+		set_error(ctx, "chart %dx%d is too small", width, height);
+		return NULL;
+	}
+	for (int i = 0; i < nseries; i++) {
+		if (series[i].values == NULL || series[i].stride < (int)sizeof(float)) {
+			set_error(ctx, "invalid series %d", i);
+			return NULL;
+		}
+	}
+
+	vmaftools_chart_t *chart = new (std::nothrow) vmaftools_chart_s();
+	if (chart == NULL) {
+		set_error(ctx, "out of memory");
+		return NULL;
+	}
+	chart->count = count;
+	chart->width = width;
+	chart->height = height;
+	chart->top = height / 20;
+	chart->bottom = (height * 7) / 10;
+	chart->nseries = nseries;
+
+	try {
+		chart->background = Mat::zeros(height, width, CV_8UC3);
+		int plot = chart->bottom - chart->top;
+
+		for (int i = 0; i < nseries; i++) {
+			struct vmaftools_series_s *s = &chart->series[i];
+			*s = series[i];
+
+			/* Axis range and mean, once */
+			double sum = 0;
+			int n = 0;
+			float lo = INFINITY, hi = -INFINITY;
+			for (int f = 0; f < count; f++) {
+				float v = series_value(s, f);
+				if (!isfinite(v)) {
+					continue;
+				}
+				lo = v < lo ? v : lo;
+				hi = v > hi ? v : hi;
+				sum += v;
+				n++;
+			}
+			if (s->min == s->max) {
+				s->min = n ? lo : 0;
+				s->max = n ? hi : 1;
+				if (s->min == s->max) {
+					s->min -= 1;
+					s->max += 1;
+				}
+			}
+
+			if (n) {
+				snprintf(chart->prefix[i], sizeof(chart->prefix[i]), "%s (mean %.2f): ", s->name ? s->name : "", sum / n);
+			} else {
+				snprintf(chart->prefix[i], sizeof(chart->prefix[i]), "%s: ", s->name ? s->name : "");
+			}
+
+			/* Decimate to one min/max span per column, joined to the previous column so the
+			 * trace has no gaps, and draw it into the background.
+			 */
+			double scale = plot / (double)(s->max - s->min);
+			int last = -1;
+			for (int x = 0; x < width; x++) {
+				int f0 = (int)(((int64_t)x * count) / width);
+				int f1 = (int)(((int64_t)(x + 1) * count) / width);
+				if (f1 <= f0) {
+					f1 = f0 + 1;
+				}
+
+				int ylo = INT32_MAX, yhi = -1, y = -1;
+				for (int f = f0; f < f1; f++) {
+					float v = series_value(s, f);
+					if (!isfinite(v)) {
+						continue;
+					}
+					y = chart->bottom - (int)lrint((v - s->min) * scale);
+					y = y < chart->top ? chart->top : y > chart->bottom ? chart->bottom : y;
+					ylo = y < ylo ? y : ylo;
+					yhi = y > yhi ? y : yhi;
+				}
+				if (y < 0) {
+					last = -1;
+					continue; /* No measurements in this column */
+				}
+				if (last >= 0) {
+					ylo = last < ylo ? last : ylo;
+					yhi = last > yhi ? last : yhi;
+				}
+				cv::line(chart->background, Point(x, ylo), Point(x, yhi), Scalar(s->colour[0], s->colour[1], s->colour[2]), 1, LINE_8);
+				last = y;
+			}
+
+			/* Legend, the axis range in the series colour */
+			char legend[96];
+			snprintf(legend, sizeof(legend), "%s %.2f .. %.2f", s->name ? s->name : "", s->min, s->max);
+			draw_text(ctx, chart->background.data, (int)chart->background.step, width, height, 3, legend,
+				40, chart->top + 40 + (i * 40), s->colour, 0);
+		}
+	} catch (const cv::Exception &e) {
+		set_error(ctx, "%s", e.what());
+		delete chart;
+		return NULL;
+	}
+
+	return chart;
+}
+
+void vmaftools_chart_free(vmaftools_chart_t *chart)
+{
+	delete chart;
+}
+
+int vmaftools_render_chart_series(vmaftools_context_t *ctx, vmaftools_chart_t *chart, int cursor,
+	const char *title, struct vmaftools_image_s *out)
+{
+	if (cursor < 0 || cursor >= chart->count) {
+		return set_error(ctx, "cursor %d is outside frames 0..%d", cursor, chart->count - 1);
+	}
+	if (!image_valid(out) || out->width != chart->width || out->height != chart->height) {
+		return set_error(ctx, "output must be %dx%d", chart->width, chart->height);
+	}
+
+	for (int y = 0; y < out->height; y++) {
+		memcpy(out->data + ((size_t)y * out->stride), chart->background.ptr<uint8_t>(y), (size_t)out->width * 3);
+	}
+
+	/* Cursor, in the middle of the frame's columns */
+	int x = (int)((((int64_t)cursor * 2 + 1) * chart->width) / ((int64_t)chart->count * 2));
+	Mat mOutput = image_mat(out);
+	cv::line(mOutput, Point(x, chart->bottom), Point(x, chart->top), Scalar(0, 0, 250), 2, LINE_8);
+
+	if (title) {
+		int y = chart->bottom + 50;
+		draw_text(ctx, out->data, out->stride, out->width, out->height, 3, title, 40, y, title_colour, 1);
+
+		/* Captions are cached with the mean, only the value changes from frame to frame */
+		for (int i = 0; i < chart->nseries; i++) {
+			const struct vmaftools_series_s *s = &chart->series[i];
+			y += 40;
+			int px = draw_text(ctx, out->data, out->stride, out->width, out->height, 3, chart->prefix[i], 40, y, s->colour, 1);
+
+			char value[32];
+			float v = series_value(s, cursor);
+			if (isfinite(v)) {
+				snprintf(value, sizeof(value), "%.2f", v);
+			} else {
+				snprintf(value, sizeof(value), "-");
+			}
+			draw_text(ctx, out->data, out->stride, out->width, out->height, 3, value, px, y, s->colour, 0);
+		}
+	}
+
+	return 0; /* Success */
+}
@@ -0,0 +1,185 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef VMAFTOOLS_H
+#define VMAFTOOLS_H
+
+#include <stdint.h>
+
+/* In process API for the metric kernels and renderers behind yuvmse, picdiff,
+ * pic2x2 and picvmaf, built as libvmaftools.so.
+ *
+ * Every frame and image is caller owned, nothing is copied or retained past the
+ * call. All state lives in a context, there are no globals beyond the cpu kernel
+ * selection (kernels.h), which is fixed once detected. A context must only be
+ * used by one thread at a time, use one context per thread for parallel work.
+ *
+ * Functions return 0 on success, -1 on failure with a reason from vmaftools_error().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VMAFTOOLS_API_VERSION 1
+
+#if defined(__GNUC__)
+#define VMAFTOOLS_API __attribute__((visibility("default")))
+#else
+#define VMAFTOOLS_API
+#endif
+
+/* An 8bit plane, stride in bytes */
+struct vmaftools_plane_s
+{
+	const uint8_t *data;
+	int stride;
+	int width;
+	int height;
+};
+
+/* A 4:2:0 8bit frame, Y then U then V. Chroma planes are width / 2 x height / 2. */
+struct vmaftools_frame_s
+{
+	struct vmaftools_plane_s plane[3];
+};
+
+/* A packed BGR image, 3 bytes per pixel, stride in bytes. Inputs are read only,
+ * outputs are written in place and must already be allocated at the size the
+ * function documents.
+ */
+struct vmaftools_image_s
+{
+	uint8_t *data;
+	int stride;
+	int width;
+	int height;
+};
+
+/* Per frame pair statistics, index 0 is the reference, 1 the distorted frame */
+struct vmaftools_frame_stats_s
+{
+	double mse[3];          /* Y, U, V */
+	double psnr[3];         /* dB, INFINITY when identical */
+	double sharpness[2];    /* Variance of the luma Laplacian */
+	uint64_t hash[2];       /* Luma DCT hash */
+	double luma_mean[2];
+};
+
+struct vmaftools_offset_s
+{
+	int dx;
+	int dy;
+	double sad;             /* Mean absolute difference per pixel at the offset */
+};
+
+typedef struct vmaftools_context_s vmaftools_context_t;
+
+/* VMAFTOOLS_API_VERSION the library was built with, callers should check it matches */
+VMAFTOOLS_API int vmaftools_api_version(void);
+
+VMAFTOOLS_API vmaftools_context_t *vmaftools_context_alloc(void);
+VMAFTOOLS_API void vmaftools_context_free(vmaftools_context_t *ctx);
+
+/* Reason for the last failure on this context, never NULL */
+VMAFTOOLS_API const char *vmaftools_error(vmaftools_context_t *ctx);
+
+/* Name of the cpu kernel path in use, scalar, sse42, avx2 or avx512 */
+VMAFTOOLS_API const char *vmaftools_kernels(void);
+
+/* Spatial offset applied by vmaftools_frame_stats(), the distorted pixel at
+ * (x + dx, y + dy) is compared with the reference pixel at (x, y). Default 0, 0.
+ */
+VMAFTOOLS_API void vmaftools_set_offset(vmaftools_context_t *ctx, int dx, int dy);
+
+/* MSE/PSNR per plane, sharpness, hash and luma mean of a frame pair. dist may be
+ * NULL, then only the reference sharpness, hash and mean are filled in.
+ */
+VMAFTOOLS_API int vmaftools_frame_stats(vmaftools_context_t *ctx, const struct vmaftools_frame_s *ref,
+	const struct vmaftools_frame_s *dist, struct vmaftools_frame_stats_s *stats);
+
+/* Luma DCT hash, mean may be NULL */
+VMAFTOOLS_API int vmaftools_dct_hash(vmaftools_context_t *ctx, const struct vmaftools_plane_s *luma,
+	uint64_t *hash, double *mean);
+
+/* Search +/- range pixels for the translation of dist against ref. Same size planes. */
+VMAFTOOLS_API int vmaftools_align_search(vmaftools_context_t *ctx, const struct vmaftools_plane_s *ref,
+	const struct vmaftools_plane_s *dist, int range, struct vmaftools_offset_s *offset);
+
+/* picdiff. Absolute difference of two same size images into out (same size),
+ * when normalize is set the difference is stretched to 150..255 gray.
+ * title, when not NULL, is rendered top left.
+ */
+VMAFTOOLS_API int vmaftools_render_diff(vmaftools_context_t *ctx, const struct vmaftools_image_s *a,
+	const struct vmaftools_image_s *b, int normalize, const char *title, struct vmaftools_image_s *out);
+
+/* picdiff -Y. Absolute difference of two same size luma planes into out, an 8bit
+ * plane of the same size, normalized as above when asked. mse, when not NULL,
+ * receives the plane MSE, the same value yuvmse reports for Y.
+ */
+VMAFTOOLS_API int vmaftools_render_diff_luma(vmaftools_context_t *ctx, const struct vmaftools_plane_s *a,
+	const struct vmaftools_plane_s *b, int normalize, const char *title, uint8_t *out, int out_stride, double *mse);
+
+/* pic2x2. Composite up to four images, top left, top right, bottom left, bottom right,
+ * into out, which is 2 * the largest tile width x 2 * the largest tile height.
+ * NULL tiles are black. titles may be NULL, or hold a NULL or a title per tile.
+ */
+VMAFTOOLS_API int vmaftools_render_composite(vmaftools_context_t *ctx, const struct vmaftools_image_s *tiles[4],
+	const char *titles[4], struct vmaftools_image_s *out);
+
+/* pic2x2 -g. Composite a cols x rows grid of tiles, row major, into out. Every cell is
+ * out->width / cols x out->height / rows. A tile is resized to fill its cell when scale is
+ * set, else copied top left and cropped to the cell. Uncovered pixels are cleared, NULL
+ * tiles give a black cell. A tile that already is its cell of out (the caller decoded
+ * it in place) is left untouched. titles as above.
+ */
+VMAFTOOLS_API int vmaftools_render_mosaic(vmaftools_context_t *ctx, const struct vmaftools_image_s *tiles[],
+	const char *titles[], int cols, int rows, int scale, struct vmaftools_image_s *out);
+
+/* picvmaf. Chart count VMAF scores (0..100) with a cursor at frame cursor, scaled
+ * to out's size. The cursor frame's score and aggregate are printed under the title
+ * when title is not NULL. aggregates may be NULL.
+ */
+VMAFTOOLS_API int vmaftools_render_chart(vmaftools_context_t *ctx, const float *scores, const float *aggregates,
+	int count, int cursor, const char *title, struct vmaftools_image_s *out);
+
+/* A metric series for vmaftools_chart_alloc(). values holds count floats, stride bytes
+ * apart, so a series can be read straight out of interleaved records, NaN where a frame
+ * has no measurement. Each series gets its own axis, min..max, or the range of its
+ * values when min == max.
+ */
+struct vmaftools_series_s
+{
+	const char *name;
+	const float *values;
+	int stride;
+	float min;
+	float max;
+	uint8_t colour[3];      /* BGR */
+};
+
+#define VMAFTOOLS_CHART_SERIES_MAX 8
+
+typedef struct vmaftools_chart_s vmaftools_chart_t;
+
+/* picvmaf, metrics files. Build a width x height chart of up to VMAFTOOLS_CHART_SERIES_MAX
+ * series over count frames once. Each series is decimated to a min/max span per pixel
+ * column and drawn, with its legend, into a cached background. The series values are
+ * read again for the captions, they must stay valid until the chart is freed.
+ * Returns NULL on failure, with the reason in vmaftools_error(ctx).
+ */
+VMAFTOOLS_API vmaftools_chart_t *vmaftools_chart_alloc(vmaftools_context_t *ctx, const struct vmaftools_series_s *series,
+	int nseries, int count, int width, int height);
+VMAFTOOLS_API void vmaftools_chart_free(vmaftools_chart_t *chart);
+
+/* Render a chart built by vmaftools_chart_alloc() with a cursor at frame cursor into out,
+ * which is the chart's size. Each series' value at the cursor and its mean are printed
+ * under title when title is not NULL. Only the cursor and captions are drawn per call.
+ */
+VMAFTOOLS_API int vmaftools_render_chart_series(vmaftools_context_t *ctx, vmaftools_chart_t *chart, int cursor,
+	const char *title, struct vmaftools_image_s *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VMAFTOOLS_H */
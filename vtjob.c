@@ -0,0 +1,168 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include "jobd.h"
+
+#define RENDER_TITLE_DEFAULT 1
+
+struct tool_context_s {
+	struct jobd_request_s req;
+	int verbose;
+};
+
+void usage()
+{
+	printf("A client for vtjobd, runs picdiff, pic2x2 and picvmaf jobs in the warm server process.\n");
+	printf("Takes the same flags as the tool it replaces, or link it as picdiff/pic2x2/picvmaf.\n");
+	printf("The server socket is $%s [def: %s]\n", JOBD_SOCKET_ENV, JOBD_SOCKET_DEFAULT);
+	printf("Usage:\n");
+	printf("  vtjob picdiff -1 image1.png -2 image2.png [-n] [-t 0|1] [-v] -o output.png\n");
+	printf("  vtjob picdiff -Y [-W width] [-H height] [-f frame] -1 file1.yuv -2 file2.yuv [-n] [-t 0|1] [-v] -o output.png\n");
+	printf("  vtjob pic2x2 [-1 tl.png] [-2 tr.png] [-3 bl.png] [-4 br.png] [-t 0|1] [-v] -o output.png\n");
+	printf("  vtjob picvmaf -i vmaf.csv -c framenumber [-t 0|1] [-v] -o output.png\n");
+	printf("The kernel path (-x) is the server's, start vtjobd with -x to change it.\n");
+}
+
+static void set_string(char *dst, const char *src)
+{
+	if (strlen(src) >= JOBD_PATH_MAX) {
+		fprintf(stderr, "%s is too long, aborting\n", src);
+		exit(1);
+	}
+	strcpy(dst, src);
+}
+
+int main(int argc, char *argv[])
+{
+	struct tool_context_s tool_ctx, *ctx = &tool_ctx;
+	memset(ctx, 0, sizeof(*ctx));
+
+	struct jobd_request_s *req = &ctx->req;
+	req->magic = JOBD_MAGIC;
+	req->version = JOBD_VERSION;
+	req->render_title = RENDER_TITLE_DEFAULT;
+	req->width = 1920;
+	req->height = 1080;
+
+	/* Invoked through a picdiff/pic2x2/picvmaf link, or as vtjob <tool> ... */
+	int tool = jobd_tool_lookup(basename(argv[0]));
+	if (tool < 0) {
+		if (argc < 2 || (tool = jobd_tool_lookup(argv[1])) < 0) {
+			usage();
+			exit(1);
+		}
+		argc--;
+		argv++;
+	}
+	req->tool = tool;
+
+	const char *opts = "?h1:2:f:no:t:vx:H:W:Y";
+	if (tool == JOBD_PIC2X2) {
+		opts = "?h1:2:3:4:o:t:v";
+	} else if (tool == JOBD_PICVMAF) {
+		opts = "?hc:i:o:t:v";
+	}
+
+	int ch;
+
+	while ((ch = getopt(argc, argv, opts)) != -1) {
+		switch (ch) {
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+			set_string(req->fn[ch - '1'], optarg);
+			break;
+		case 'c':
+			req->cursor = atoi(optarg);
+			break;
+		case 'f':
+			req->frame = atoi(optarg);
+			break;
+		case 'H':
+			req->height = atoi(optarg);
+			break;
+		case 'W':
+			req->width = atoi(optarg);
+			break;
+		case 'Y':
+			req->luma = 1;
+			break;
+		case 'i':
+			set_string(req->fn[0], optarg);
+			break;
+		case 'n':
+			req->normalize = 1;
+			break;
+		case 'o':
+			set_string(req->outfn, optarg);
+			break;
+		case 't':
+			req->render_title = atoi(optarg);
+			break;
+		case 'v':
+			ctx->verbose++;
+			break;
+		case 'x':
+			/* One kernel path per process, the server's is shared by every job */
+			fprintf(stderr, "-x %s can't be set per job, start vtjobd with -x %s, aborting\n", optarg, optarg);
+			exit(1);
+		default:
+		case '?':
+		case 'h':
+			usage();
+			exit(1);
+		}
+	}
+	req->verbose = ctx->verbose;
+
+	if (req->outfn[0] == 0) {
+		fprintf(stderr, "No output file, -o is required\n");
+		exit(1);
+	}
+
+	if (getcwd(req->cwd, sizeof(req->cwd)) == NULL) {
+		fprintf(stderr, "Unable to determine the working directory, aborting\n");
+		exit(1);
+	}
+
+	const char *path = jobd_socket_path();
+	if (path == NULL) {
+		fprintf(stderr, "The socket directory isn't private to this user, set $%s, aborting\n", JOBD_SOCKET_ENV);
+		exit(1);
+	}
+	int fd = jobd_connect(path);
+	if (fd < 0) {
+		fprintf(stderr, "Unable to connect to vtjobd at %s, is it running?\n", path);
+		exit(1);
+	}
+
+	struct jobd_reply_s reply;
+	if (jobd_write(fd, req, sizeof(*req)) < 0 || jobd_read(fd, &reply, sizeof(reply)) < 0 || reply.magic != JOBD_MAGIC) {
+		fprintf(stderr, "Lost the connection to vtjobd at %s\n", path);
+		close(fd);
+		exit(1);
+	}
+	close(fd);
+
+	reply.message[sizeof(reply.message) - 1] = 0;
+	if (reply.status < 0) {
+		fprintf(stderr, "%s\n", reply.message);
+		exit(1);
+	}
+	reply.output[sizeof(reply.output) - 1] = 0;
+	if (reply.output[0]) {
+		printf("%s\n", reply.output);
+	}
+	if (ctx->verbose) {
+		printf("%s\n", reply.message);
+	}
+
+	return 0;
+}
@@ -0,0 +1,593 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "jobd.h"
+#include "workpool.h"
+#include "vmaftools.h"
+#include "vmafcsv.h"
+#include "kernels.h"
+
+using namespace cv;
+
+#define CACHE_ENTRIES_DEFAULT 64
+#define JOB_TIMEOUT_SECS 30
+#define LUMA_DIMENSION_MAX 16384  /* picdiff -Y -W/-H from a client */
+
+/* Loaded reference images and parsed VMAF series, keyed by path and invalidated
+ * when the file's mtime or size changes. Entries are refcounted Mats so a job
+ * keeps its copy alive even if the entry is evicted underneath it.
+ */
+struct cache_entry_s
+{
+	char fn[JOBD_PATH_MAX];
+	struct timespec mtime;
+	off_t size;
+	Mat mat;
+	uint64_t used;          /* LRU clock */
+};
+
+struct cache_s
+{
+	const char *name;
+	int (*load)(const char *fn, Mat &mat);
+
+	std::mutex lock;
+	std::vector<struct cache_entry_s> entries;
+	int max;
+	uint64_t clock;
+	uint64_t hits;
+	uint64_t misses;
+};
+
+/* Connections being served, the accept loop stops taking more past a limit so
+ * the kernel backlog, not the worker deques, queues the surplus in arrival order.
+ */
+struct jobs_s
+{
+	std::mutex lock;
+	std::condition_variable cond;
+	int inflight;
+	int max_inflight;
+	uint64_t done;
+	uint64_t failed;
+};
+
+struct tool_context_s {
+	char *sockfn;
+	int threads;
+	int cache_entries;
+	int verbose;
+
+	int listenfd;
+	struct workpool_s *pool;
+	vmaftools_context_t **vt;       /* One per worker thread */
+
+	struct cache_s *images;
+	struct cache_s *series;
+	struct jobs_s *jobs;
+};
+
+struct job_s
+{
+	struct tool_context_s *ctx;
+	int fd;
+};
+
+static volatile sig_atomic_t shutdown_requested = 0;
+
+static void signal_handler(int signo)
+{
+	shutdown_requested = 1;
+}
+
+static int image_load(const char *fn, Mat &mat)
+{
+	mat = imread(fn, IMREAD_COLOR);
+	return mat.rows == 0 ? -1 : 0;
+}
+
+/* A VMAF series is a 2 x frames float Mat, scores then aggregates */
+static int series_load(const char *fn, Mat &mat)
+{
+	float *scores, *aggregates;
+	int count;
+	if (vmafcsv_load(fn, &scores, &aggregates, &count) < 0) {
+		return -1;
+	}
+	if (count == 0) {
+		free(scores);
+		free(aggregates);
+		return -1;
+	}
+
+	mat.create(2, count, CV_32F);
+	memcpy(mat.ptr<float>(0), scores, count * sizeof(float));
+	memcpy(mat.ptr<float>(1), aggregates, count * sizeof(float));
+	free(scores);
+	free(aggregates);
+
+	return 0; /* Success */
+}
+
+static int cache_get(struct cache_s *cache, const char *fn, Mat &mat)
+{
+	struct stat s;
+	if (stat(fn, &s) < 0) {
+		return -1;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(cache->lock);
+		for (size_t i = 0; i < cache->entries.size(); i++) {
+			struct cache_entry_s *e = &cache->entries[i];
+			if (strcmp(e->fn, fn) == 0 && e->size == s.st_size &&
+				e->mtime.tv_sec == s.st_mtim.tv_sec && e->mtime.tv_nsec == s.st_mtim.tv_nsec) {
+				e->used = ++cache->clock;
+				cache->hits++;
+				mat = e->mat;
+				return 0;
+			}
+		}
+		cache->misses++;
+	}
+
+	/* Load outside the lock, concurrent misses on the same file both load, last one wins */
+	if (cache->load(fn, mat) < 0) {
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> guard(cache->lock);
+
+	/* Replace a stale version of the same file, else use a free slot, else the least recently used */
+	struct cache_entry_s *victim = NULL;
+	for (size_t i = 0; i < cache->entries.size(); i++) {
+		if (strcmp(cache->entries[i].fn, fn) == 0) {
+			victim = &cache->entries[i];
+			break;
+		}
+	}
+	if (victim == NULL && (int)cache->entries.size() < cache->max) {
+		cache->entries.push_back(cache_entry_s());
+		victim = &cache->entries.back();
+	}
+	for (size_t i = 0; victim == NULL && i < cache->entries.size(); i++) {
+		if (i == 0 || cache->entries[i].used < victim->used) {
+			victim = &cache->entries[i];
+		}
+	}
+	if (victim == NULL) {
+		return 0; /* Caching disabled */
+	}
+
+	snprintf(victim->fn, sizeof(victim->fn), "%s", fn);
+	victim->mtime = s.st_mtim;
+	victim->size = s.st_size;
+	victim->mat = mat;
+	victim->used = ++cache->clock;
+
+	return 0; /* Success */
+}
+
+static struct cache_s *cache_alloc(const char *name, int max, int (*load)(const char *fn, Mat &mat))
+{
+	struct cache_s *cache = new cache_s;
+	cache->name = name;
+	cache->load = load;
+	cache->max = max;
+	cache->clock = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->entries.reserve(max);
+
+	return cache;
+}
+
+static int reply_error(struct jobd_reply_s *reply, const char *fmt, const char *arg)
+{
+	snprintf(reply->message, sizeof(reply->message), fmt, arg);
+	reply->status = -1;
+	return -1;
+}
+
+static struct vmaftools_image_s image_wrap(Mat &m)
+{
+	struct vmaftools_image_s i = { m.data, (int)m.step, m.cols, m.rows };
+	return i;
+}
+
+static int job_save(const char *fn, const Mat &m, struct jobd_reply_s *reply)
+{
+	try {
+		if (!cv::imwrite(fn, m, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 })) {
+			return reply_error(reply, "Unable to write %s", fn);
+		}
+	} catch (const cv::Exception &e) {
+		return reply_error(reply, "Unable to write %s", fn);
+	}
+
+	snprintf(reply->message, sizeof(reply->message), "Created %s", fn);
+	return 0; /* Success */
+}
+
+/* The luma plane of one frame of a raw YUV 4:2:0 file, frames change per job so they aren't cached */
+static int luma_load(const char *fn, int width, int height, int frame, Mat &mat)
+{
+	size_t frame_size = ((size_t)width * height * 3) / 2; /* YUV420 */
+
+	FILE *fh = fopen(fn, "rb");
+	if (fh == NULL) {
+		return -1;
+	}
+
+	mat.create(height, width, CV_8UC1);
+	if (fseeko(fh, (off_t)frame * frame_size, SEEK_SET) < 0 ||
+		fread(mat.data, 1, (size_t)width * height, fh) != (size_t)width * height) {
+		fclose(fh);
+		return -1;
+	}
+	fclose(fh);
+
+	return 0; /* Success */
+}
+
+static int job_picdiff_luma(struct tool_context_s *ctx, vmaftools_context_t *vt, struct jobd_request_s *req,
+	char fn[][JOBD_PATH_MAX], const char *outfn, struct jobd_reply_s *reply)
+{
+	if (req->width <= 0 || req->height <= 0 || req->width > LUMA_DIMENSION_MAX || req->height > LUMA_DIMENSION_MAX) {
+		return reply_error(reply, "Bad luma dimensions, %s", req->outfn);
+	}
+	if (req->frame < 0) {
+		return reply_error(reply, "Bad frame number, %s", req->outfn);
+	}
+
+	Mat plane[2];
+	for (int i = 0; i < 2; i++) {
+		if (luma_load(fn[i], req->width, req->height, req->frame, plane[i]) < 0) {
+			return reply_error(reply, "Error reading frame from %s, aborting.", req->fn[i][0] ? fn[i] : "(none)");
+		}
+	}
+
+	Mat mOutput = Mat(req->height, req->width, CV_8UC1);
+	struct vmaftools_plane_s a = { plane[0].data, req->width, req->width, req->height };
+	struct vmaftools_plane_s b = { plane[1].data, req->width, req->width, req->height };
+
+	double mse;
+	if (vmaftools_render_diff_luma(vt, &a, &b, req->normalize, req->render_title ? req->outfn : NULL,
+		mOutput.data, mOutput.step, &mse) < 0) {
+		return reply_error(reply, "Failed to render difference, %s", vmaftools_error(vt));
+	}
+	snprintf(reply->output, sizeof(reply->output), "# frame %08d Y mse %9.3f psnr %9.3f", req->frame, mse,
+		mse == 0 ? INFINITY : 10.0 * log10((255.0 * 255.0) / mse));
+
+	return job_save(outfn, mOutput, reply);
+}
+
+static int job_picdiff(struct tool_context_s *ctx, vmaftools_context_t *vt, struct jobd_request_s *req,
+	char fn[][JOBD_PATH_MAX], const char *outfn, struct jobd_reply_s *reply)
+{
+	if (req->luma) {
+		return job_picdiff_luma(ctx, vt, req, fn, outfn, reply);
+	}
+
+	Mat mat[2];
+	for (int i = 0; i < 2; i++) {
+		if (cache_get(ctx->images, fn[i], mat[i]) < 0) {
+			return reply_error(reply, "Error reading file %s, aborting.", req->fn[i][0] ? fn[i] : "(none)");
+		}
+	}
+	if (mat[0].size() != mat[1].size()) {
+		return reply_error(reply, "Images are different sizes, %s", req->outfn);
+	}
+
+	Mat mOutput = Mat(mat[0].rows, mat[0].cols, CV_8UC3);
+	struct vmaftools_image_s a = image_wrap(mat[0]);
+	struct vmaftools_image_s b = image_wrap(mat[1]);
+	struct vmaftools_image_s o = image_wrap(mOutput);
+
+	if (vmaftools_render_diff(vt, &a, &b, req->normalize, req->render_title ? req->outfn : NULL, &o) < 0) {
+		return reply_error(reply, "Failed to render difference, %s", vmaftools_error(vt));
+	}
+
+	return job_save(outfn, mOutput, reply);
+}
+
+static int job_pic2x2(struct tool_context_s *ctx, vmaftools_context_t *vt, struct jobd_request_s *req,
+	char fn[][JOBD_PATH_MAX], const char *outfn, struct jobd_reply_s *reply)
+{
+	Mat mat[JOBD_INPUTS_MAX];
+	struct vmaftools_image_s img[JOBD_INPUTS_MAX];
+	const struct vmaftools_image_s *tiles[JOBD_INPUTS_MAX];
+	const char *titles[JOBD_INPUTS_MAX];
+	int max_cols = 0, max_rows = 0;
+
+	for (int i = 0; i < JOBD_INPUTS_MAX; i++) {
+		tiles[i] = NULL;
+		titles[i] = req->render_title ? req->fn[i] : NULL;
+		if (req->fn[i][0] == 0) {
+			continue;
+		}
+		if (cache_get(ctx->images, fn[i], mat[i]) < 0) {
+			return reply_error(reply, "Error reading file %s, aborting.", fn[i]);
+		}
+		img[i] = image_wrap(mat[i]);
+		tiles[i] = &img[i];
+		max_cols = mat[i].cols > max_cols ? mat[i].cols : max_cols;
+		max_rows = mat[i].rows > max_rows ? mat[i].rows : max_rows;
+	}
+	if (max_cols == 0) {
+		return reply_error(reply, "No input images for %s", req->outfn);
+	}
+
+	Mat mOutput = Mat(max_rows * 2, max_cols * 2, CV_8UC3);
+	struct vmaftools_image_s o = image_wrap(mOutput);
+	if (vmaftools_render_composite(vt, tiles, titles, &o) < 0) {
+		return reply_error(reply, "Failed to composite, %s", vmaftools_error(vt));
+	}
+
+	return job_save(outfn, mOutput, reply);
+}
+
+static int job_picvmaf(struct tool_context_s *ctx, vmaftools_context_t *vt, struct jobd_request_s *req,
+	char fn[][JOBD_PATH_MAX], const char *outfn, struct jobd_reply_s *reply)
+{
+	Mat series;
+	if (cache_get(ctx->series, fn[0], series) < 0) {
+		return reply_error(reply, "Unable to read %s", req->fn[0][0] ? fn[0] : "(none)");
+	}
+
+	Mat mOutputResized = Mat(1080, 1920, CV_8UC3);
+	struct vmaftools_image_s o = image_wrap(mOutputResized);
+	if (vmaftools_render_chart(vt, series.ptr<float>(0), series.ptr<float>(1), series.cols, req->cursor,
+		req->render_title ? req->outfn : NULL, &o) < 0) {
+		return reply_error(reply, "Failed to render chart, %s", vmaftools_error(vt));
+	}
+
+	return job_save(outfn, mOutputResized, reply);
+}
+
+static void job_task(void *arg, int worker)
+{
+	struct job_s *job = (struct job_s *)arg;
+	struct tool_context_s *ctx = job->ctx;
+
+	struct jobd_request_s *req = (struct jobd_request_s *)calloc(1, sizeof(*req));
+	struct jobd_reply_s reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.magic = JOBD_MAGIC;
+
+	int ret = -1;
+	if (req && jobd_read(job->fd, req, sizeof(*req)) == 0) {
+		if (req->magic != JOBD_MAGIC || req->version != JOBD_VERSION) {
+			reply_error(&reply, "Protocol mismatch, client and %s versions differ", "vtjobd");
+		} else {
+			/* Client strings are untrusted, terminate them before use */
+			char fn[JOBD_INPUTS_MAX][JOBD_PATH_MAX];
+			char outfn[JOBD_PATH_MAX];
+			req->cwd[JOBD_PATH_MAX - 1] = 0;
+			req->outfn[JOBD_PATH_MAX - 1] = 0;
+			for (int i = 0; i < JOBD_INPUTS_MAX; i++) {
+				req->fn[i][JOBD_PATH_MAX - 1] = 0;
+				jobd_path_resolve(req->cwd, req->fn[i], fn[i], JOBD_PATH_MAX);
+			}
+			jobd_path_resolve(req->cwd, req->outfn, outfn, JOBD_PATH_MAX);
+
+			vmaftools_context_t *vt = ctx->vt[worker];
+			switch (req->tool) {
+			case JOBD_PICDIFF:
+				ret = job_picdiff(ctx, vt, req, fn, outfn, &reply);
+				break;
+			case JOBD_PIC2X2:
+				ret = job_pic2x2(ctx, vt, req, fn, outfn, &reply);
+				break;
+			case JOBD_PICVMAF:
+				ret = job_picvmaf(ctx, vt, req, fn, outfn, &reply);
+				break;
+			default:
+				reply_error(&reply, "Unknown tool %s", "");
+			}
+		}
+
+		reply.status = ret;
+		jobd_write(job->fd, &reply, sizeof(reply));
+
+		if (ctx->verbose) {
+			printf("# worker %2d: %-7s %s\n", worker, jobd_tool_name(req->tool), reply.message);
+		}
+	}
+
+	close(job->fd);
+	free(req);
+	free(job);
+
+	std::lock_guard<std::mutex> guard(ctx->jobs->lock);
+	ctx->jobs->inflight--;
+	if (ret == 0) {
+		ctx->jobs->done++;
+	} else {
+		ctx->jobs->failed++;
+	}
+	ctx->jobs->cond.notify_one();
+}
+
+void usage()
+{
+	printf("A server that keeps one warm process for picdiff, pic2x2 and picvmaf jobs, submitted with vtjob.\n");
+	printf("Reference images and parsed VMAF series are cached between jobs, jobs run on a thread pool.\n");
+	printf("Usage:\n");
+	printf("  -s socket path [def: $%s or %s]\n", JOBD_SOCKET_ENV, JOBD_SOCKET_DEFAULT);
+	printf("  -j number of worker threads [def: 0, one per cpu]\n");
+	printf("  -c cached images / vmaf series, each [def: %d]\n", CACHE_ENTRIES_DEFAULT);
+	printf("  -v raise verbosity, log every job\n");
+	printf("  -x isa force the kernel path for every job, scalar, sse42, avx2 or avx512 [def: best for this cpu]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct tool_context_s tool_ctx, *ctx = &tool_ctx;
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->cache_entries = CACHE_ENTRIES_DEFAULT;
+
+	int ch;
+
+	while ((ch = getopt(argc, argv, "?hc:j:s:vx:")) != -1) {
+		switch (ch) {
+		case 'c':
+			ctx->cache_entries = atoi(optarg);
+			break;
+		case 'j':
+			ctx->threads = atoi(optarg);
+			break;
+		case 's':
+			ctx->sockfn = strdup(optarg);
+			break;
+		case 'v':
+			ctx->verbose++;
+			break;
+		case 'x':
+			if (kernels_force(optarg) < 0) {
+				fprintf(stderr, "kernel path %s unknown or not supported by this cpu, aborting\n", optarg);
+				exit(1);
+			}
+			break;
+		default:
+		case '?':
+		case 'h':
+			usage();
+			exit(1);
+		}
+	}
+
+	if (ctx->sockfn == NULL) {
+		const char *path = jobd_socket_path();
+		if (path == NULL) {
+			fprintf(stderr, "The socket directory isn't private to this user, use -s or $%s, aborting\n",
+				JOBD_SOCKET_ENV);
+			exit(1);
+		}
+		ctx->sockfn = strdup(path);
+	}
+	if (ctx->cache_entries < 0) {
+		ctx->cache_entries = 0;
+	}
+
+	ctx->listenfd = jobd_listen(ctx->sockfn);
+	if (ctx->listenfd < 0) {
+		fprintf(stderr, "Unable to listen on %s, %s, aborting\n", ctx->sockfn, strerror(errno));
+		exit(1);
+	}
+
+	/* No SA_RESTART, a signal breaks the accept loop */
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = signal_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	/* Workers inherit a blocked mask, so signals always land on the accept loop */
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &mask, NULL);
+	ctx->pool = workpool_alloc(ctx->threads);
+	pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+	ctx->threads = workpool_threads(ctx->pool);
+	ctx->vt = (vmaftools_context_t **)calloc(ctx->threads, sizeof(vmaftools_context_t *));
+	for (int i = 0; i < ctx->threads; i++) {
+		ctx->vt[i] = vmaftools_context_alloc();
+	}
+	ctx->images = cache_alloc("images", ctx->cache_entries, image_load);
+	ctx->series = cache_alloc("series", ctx->cache_entries, series_load);
+	ctx->jobs = new jobs_s;
+	ctx->jobs->inflight = 0;
+	ctx->jobs->max_inflight = ctx->threads * 2;
+	ctx->jobs->done = 0;
+	ctx->jobs->failed = 0;
+
+	printf("# socket: %s\n", ctx->sockfn);
+	printf("# threads: %d\n", ctx->threads);
+	printf("# cache entries: %d\n", ctx->cache_entries);
+	printf("# kernels: %s\n", vmaftools_kernels());
+	fflush(stdout);
+
+	while (!shutdown_requested) {
+		{
+			std::unique_lock<std::mutex> guard(ctx->jobs->lock);
+			ctx->jobs->cond.wait(guard, [ctx] { return ctx->jobs->inflight < ctx->jobs->max_inflight; });
+		}
+
+		int fd = accept(ctx->listenfd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			fprintf(stderr, "accept failed, %s\n", strerror(errno));
+			break;
+		}
+
+		/* Jobs read and write files as us, other users don't get to submit them */
+		if (jobd_peer_check(fd) < 0) {
+			if (ctx->verbose) {
+				printf("# rejected a connection from another user\n");
+			}
+			close(fd);
+			continue;
+		}
+
+		/* A client that connects and never sends must not pin a worker */
+		struct timeval tv = { JOB_TIMEOUT_SECS, 0 };
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+		struct job_s *job = (struct job_s *)malloc(sizeof(*job));
+		job->ctx = ctx;
+		job->fd = fd;
+
+		{
+			std::lock_guard<std::mutex> guard(ctx->jobs->lock);
+			ctx->jobs->inflight++;
+		}
+		workpool_submit(ctx->pool, job_task, job);
+	}
+
+	/* Drain, the jobs already accepted still get their replies */
+	close(ctx->listenfd);
+	unlink(ctx->sockfn);
+	workpool_free(ctx->pool);
+
+	printf("# jobs: %" PRIu64 " done, %" PRIu64 " failed\n", ctx->jobs->done, ctx->jobs->failed);
+	struct cache_s *caches[2] = { ctx->images, ctx->series };
+	for (int i = 0; i < 2; i++) {
+		printf("# %s cache: %" PRIu64 " hits, %" PRIu64 " misses\n", caches[i]->name, caches[i]->hits, caches[i]->misses);
+		delete caches[i];
+	}
+
+	for (int i = 0; i < ctx->threads; i++) {
+		vmaftools_context_free(ctx->vt[i]);
+	}
+	free(ctx->vt);
+	delete ctx->jobs;
+	free(ctx->sockfn);
+
+	return 0;
+}
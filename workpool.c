@@ -0,0 +1,169 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "workpool.h"
+
+struct workpool_task_s
+{
+	workpool_fn fn;
+	void *arg;
+};
+
+struct workpool_queue_s
+{
+	std::mutex lock;
+	std::deque<struct workpool_task_s> tasks;
+};
+
+struct workpool_s
+{
+	int threads;
+	std::vector<std::thread> workers;
+	struct workpool_queue_s *queues;
+
+	std::mutex lock;
+	std::condition_variable work_cond;  /* Signalled on submit and shutdown */
+	std::condition_variable idle_cond;  /* Signalled when pending reaches zero */
+	long queued;                        /* Tasks sitting in any deque */
+	long pending;                       /* Tasks submitted but not yet complete */
+	int terminate;
+	unsigned int next;
+};
+
+static int workpool_take(struct workpool_s *pool, int id, struct workpool_task_s *task)
+{
+	/* Own deque first, newest task (LIFO keeps the working set warm) */
+	{
+		struct workpool_queue_s *q = &pool->queues[id];
+		std::lock_guard<std::mutex> guard(q->lock);
+		if (!q->tasks.empty()) {
+			*task = q->tasks.back();
+			q->tasks.pop_back();
+			return 1;
+		}
+	}
+
+	/* Steal the oldest task from a sibling */
+	for (int i = 1; i < pool->threads; i++) {
+		struct workpool_queue_s *q = &pool->queues[(id + i) % pool->threads];
+		std::lock_guard<std::mutex> guard(q->lock);
+		if (!q->tasks.empty()) {
+			*task = q->tasks.front();
+			q->tasks.pop_front();
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void workpool_worker(struct workpool_s *pool, int id)
+{
+	while (1) {
+		struct workpool_task_s task;
+
+		if (workpool_take(pool, id, &task)) {
+			{
+				std::lock_guard<std::mutex> guard(pool->lock);
+				pool->queued--;
+			}
+
+			task.fn(task.arg, id);
+
+			std::lock_guard<std::mutex> guard(pool->lock);
+			if (--pool->pending == 0) {
+				pool->idle_cond.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(pool->lock);
+		pool->work_cond.wait(guard, [pool] { return pool->terminate || pool->queued > 0; });
+		if (pool->terminate && pool->queued == 0) {
+			return;
+		}
+	}
+}
+
+struct workpool_s *workpool_alloc(int threads)
+{
+	if (threads <= 0) {
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+		if (threads <= 0) {
+			threads = 1;
+		}
+	}
+
+	struct workpool_s *pool = new workpool_s;
+	pool->threads = threads;
+	pool->queues = new workpool_queue_s[threads];
+	pool->queued = 0;
+	pool->pending = 0;
+	pool->terminate = 0;
+	pool->next = 0;
+
+	for (int i = 0; i < threads; i++) {
+		pool->workers.push_back(std::thread(workpool_worker, pool, i));
+	}
+
+	return pool;
+}
+
+void workpool_free(struct workpool_s *pool)
+{
+	if (pool == NULL) {
+		return;
+	}
+
+	workpool_wait(pool);
+
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->terminate = 1;
+	}
+	pool->work_cond.notify_all();
+
+	for (size_t i = 0; i < pool->workers.size(); i++) {
+		pool->workers[i].join();
+	}
+
+	delete [] pool->queues;
+	delete pool;
+}
+
+int workpool_threads(struct workpool_s *pool)
+{
+	return pool->threads;
+}
+
+void workpool_submit(struct workpool_s *pool, workpool_fn fn, void *arg)
+{
+	struct workpool_task_s task = { fn, arg };
+
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->pending++;
+		pool->queued++;
+	}
+
+	struct workpool_queue_s *q = &pool->queues[__atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED) % pool->threads];
+	{
+		std::lock_guard<std::mutex> guard(q->lock);
+		q->tasks.push_back(task);
+	}
+
+	pool->work_cond.notify_one();
+}
+
+void workpool_wait(struct workpool_s *pool)
+{
+	std::unique_lock<std::mutex> guard(pool->lock);
+	pool->idle_cond.wait(guard, [pool] { return pool->pending == 0; });
+}
@@ -0,0 +1,27 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+/* A small work stealing thread pool. Each worker owns a deque, it pops its
+ * own newest task first and, when empty, steals the oldest task from a
+ * sibling. Tasks are plain function pointers with an opaque argument.
+ */
+
+struct workpool_s;
+
+typedef void (*workpool_fn)(void *arg, int worker);
+
+/* threads <= 0 uses one worker per online cpu */
+struct workpool_s *workpool_alloc(int threads);
+void workpool_free(struct workpool_s *pool);
+
+int  workpool_threads(struct workpool_s *pool);
+
+/* Queue a task, tasks are spread round robin over the worker deques */
+void workpool_submit(struct workpool_s *pool, workpool_fn fn, void *arg);
+
+/* Block until every submitted task has completed */
+void workpool_wait(struct workpool_s *pool);
+
+#endif /* WORKPOOL_H */
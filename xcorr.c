@@ -0,0 +1,105 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <opencv2/core/core.hpp>
+#include <opencv2/opencv.hpp>
+
+#include "xcorr.h"
+
+using namespace cv;
+
+/* Zero mean, unit variance copy into a zero padded row of length n */
+static void xcorr_normalize(const float *src, int count, Mat &dst, int n)
+{
+	double mean = 0, var = 0;
+	for (int i = 0; i < count; i++) {
+		mean += src[i];
+	}
+	mean /= count;
+	for (int i = 0; i < count; i++) {
+		var += (src[i] - mean) * (src[i] - mean);
+	}
+	double scale = var > 0.0 ? 1.0 / sqrt(var / count) : 0.0;
+
+	dst = Mat::zeros(1, n, CV_32F);
+	float *p = dst.ptr<float>(0);
+	for (int i = 0; i < count; i++) {
+		p[i] = (src[i] - mean) * scale;
+	}
+}
+
+int xcorr_find_peaks(const float *a, int na, const float *b, int nb, int min_overlap,
+	struct xcorr_peak_s *peaks, int max_peaks)
+{
+	if (na <= 0 || nb <= 0 || max_peaks <= 0) {
+		return -1;
+	}
+
+	/* Linear (not circular) correlation needs na + nb - 1 points */
+	int n = getOptimalDFTSize(na + nb - 1);
+
+	Mat ma, mb, fa, fb, spec, corr;
+	xcorr_normalize(a, na, ma, n);
+	xcorr_normalize(b, nb, mb, n);
+
+	dft(ma, fa, DFT_COMPLEX_OUTPUT);
+	dft(mb, fb, DFT_COMPLEX_OUTPUT);
+
+	/* corr[L] = sum a[i] * b[i + L] = IDFT(conj(A) * B) */
+	mulSpectrums(fb, fa, spec, 0, true);
+	dft(spec, corr, DFT_INVERSE | DFT_SCALE | DFT_REAL_OUTPUT);
+
+	const float *c = corr.ptr<float>(0);
+
+	/* Lags -(na - 1) .. (nb - 1), negative lags wrap to the end of the buffer.
+	 * Divide by the overlap so short and long overlaps compare fairly.
+	 */
+	int lags = na + nb - 1;
+	double *score = (double *)malloc(lags * sizeof(double));
+	if (score == NULL) {
+		return -1;
+	}
+
+	for (int i = 0; i < lags; i++) {
+		int lag = i - (na - 1);
+		int start = lag < 0 ? -lag : 0;
+		int end = (nb - lag) < na ? (nb - lag) : na;
+		int overlap = end - start;
+
+		if (overlap < min_overlap || overlap <= 0) {
+			score[i] = -INFINITY;
+			continue;
+		}
+		score[i] = c[lag >= 0 ? lag : n + lag] / overlap;
+	}
+
+	/* Best peaks, suppressing the immediate neighbours of each pick */
+	int found = 0;
+	while (found < max_peaks) {
+		int best = -1;
+		for (int i = 0; i < lags; i++) {
+			if (score[i] > -INFINITY && (best < 0 || score[i] > score[best])) {
+				best = i;
+			}
+		}
+		if (best < 0) {
+			break;
+		}
+
+		peaks[found].lag = best - (na - 1);
+		peaks[found].score = score[best];
+		found++;
+
+		for (int i = best - 2; i <= best + 2; i++) {
+			if (i >= 0 && i < lags) {
+				score[i] = -INFINITY;
+			}
+		}
+	}
+
+	free(score);
+
+	return found;
+}
@@ -0,0 +1,26 @@
+/* Copyright Kernel Labs Inc 2025, All Rights Reserved. */
+
+#ifndef XCORR_H
+#define XCORR_H
+
+/* Global temporal offset between two per frame signature series, found by
+ * FFT cross correlation in O(n log n).
+ * A lag L means b[n + L] lines up with a[n].
+ */
+
+#define XCORR_MAX_PEAKS 8
+
+struct xcorr_peak_s
+{
+	int lag;
+	double score;   /* Normalized correlation, -1 .. 1 */
+};
+
+/* Return the number of peaks found (<= max_peaks), best first, or -1 on error.
+ * Lags whose overlap is shorter than min_overlap frames are ignored.
+ * Signatures are normalized (zero mean, unit variance) internally.
+ */
+int xcorr_find_peaks(const float *a, int na, const float *b, int nb, int min_overlap,
+	struct xcorr_peak_s *peaks, int max_peaks);
+
+#endif /* XCORR_H */
@@ -3,14 +3,44 @@
 #include <stdio.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
 #include <sys/stat.h>
+#include <mutex>
+#include <algorithm>
+#include <condition_variable>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/opencv.hpp>
 
+#include "stats.h"
+#include "segment.h"
+#include "align.h"
+#include "blockmse.h"
+#include "workpool.h"
+#include "xcorr.h"
+#include "drift.h"
+#include "kernels.h"
+#include "dcthash.h"
+#include "metrics.h"
+#include "checkpoint.h"
+#include "framecache.h"
+#include "framereader.h"
+#include "arena.h"
+#include "manifest.h"
+#include "follow.h"
+#include "pyramid.h"
+#include "hashmatrix.h"
+#include "fingerprint.h"
+
 using namespace cv;
 
 #define RENDER_TITLE_DEFAULT 1
+#define BATCH_IO_DEFAULT 4     /* Concurrent reads in batch mode */
+#define FOLLOW_WINDOW_DEFAULT 250 /* Follow mode rolling window without -a, 10s at 25fps */
+#define BESTMATCH_BUDGET (256 << 20) /* Bestmatch resident window frames, bytes */
 
 struct tool_context_s {
 #define MAX_INPUTS 2
@@ -26,6 +56,79 @@ struct tool_context_s {
 	int bestmatch;
 	int dimension_defaults; /* 1, defaults, 0 = user supplied, 2 = detected */
 	int dcthashmatch;
+	int xcorrmatch;
+	int window;     /* Sliding aggregate window in frames, 0 = disabled */
+	int quiet;      /* Suppress per frame rows, summary only */
+	char *segfn;    /* Scene segment list output, "-" for stdout */
+	FILE *segfh;
+	int cut_threshold;
+
+	/* Spatial alignment, detected once and applied to every frame */
+	int shift_range;
+	int shift_valid;
+	struct spatial_offset_s shift;
+
+	/* Per block luma SSE, computed inside the mse kernel */
+	int block_size;
+	char *gridfn;
+	char *heatmapfn;
+	struct block_grid_s *grid; /* Non NULL while the mse pass collects blocks */
+
+	int threads;    /* Worker threads, 0 = one per cpu */
+
+	char *mapoutfn; /* Drift alignment, frame map output */
+	char *mapinfn;  /* Frame map consumed by mse mode */
+
+	char *metricsfn; /* Compact per frame metrics for picvmaf charts */
+	char *vmaffn;    /* libvmaf json or csv, merged into the metrics file */
+
+	/* Checkpointing of the long passes, see checkpoint.h */
+	char *ckptfn;
+	int ckpt_interval; /* Frames between checkpoints, 0 = disabled */
+	int resume;        /* --resume, continue from ckptfn */
+	float *sigs[MAX_INPUTS]; /* Signature lists of completed inputs, for the checkpoint */
+
+	/* Repeated frame short circuit, see framecache.h */
+	int cache_entries; /* 0 = disabled */
+	struct framecache_s cache;
+
+	/* Read ahead for the mse pass, see framereader.h */
+	int io_depth;      /* Frame reads in flight per input, 0 = synchronous */
+	int io_engine;
+	int io_direct;     /* --direct, O_DIRECT into aligned buffers */
+
+	/* Sampled triage, every Nth frame or N stratified random frames */
+	int sample_every;
+	int sample_count;
+	unsigned int sample_seed;
+	double sample_threshold; /* Flag sampled frames below this Y PSNR, 0 = off */
+
+	char *manifestfn;  /* Batch mode, see manifest.h */
+	int io_limit;      /* Concurrent reads across the batch pool */
+
+	/* Live tail of growing files, see follow.h */
+	int follow;
+	int follow_start[MAX_INPUTS]; /* First frame of each file, from -D's alignment */
+	int follow_idle;   /* Stop after this many seconds without a new frame, 0 = never */
+	int follow_poll_ms;
+
+	int hash_band;     /* -D searches offsets +/- this many frames, 0 = every offset */
+	char *matrixfn;    /* -D hash distance matrix, PGM */
+	int xhash;         /* -D matches 256 bit luma, chroma and motion fingerprints, see fingerprint.h */
+	struct fingerprint_list_s prints[MAX_INPUTS];
+
+	int preview;       /* Pyramid level the metrics run on, 0 = full resolution, see pyramid.h */
+};
+
+/* Checkpoint sections */
+enum {
+	CKPT_MSE_PROGRESS = 1,
+	CKPT_MSE_AGGREGATE,
+	CKPT_MSE_SHOT,
+	CKPT_MSE_WINDOW,
+	CKPT_MSE_GRID,
+	CKPT_MSE_SEGMENTER,
+	CKPT_SIGNATURES = 16,   /* + input number */
 };
 
 static struct {
@@ -159,64 +262,20 @@ uint64_t computeDCTHash(struct tool_context_s *ctx, const Mat& image)
 }
 #endif
 
-uint64_t computeDCTHash(struct tool_context_s *ctx, const Mat& image)
+/* Optionally return the mean of the image, which falls out of the DCT for free. */
+uint64_t computeDCTHash(struct tool_context_s *ctx, const Mat& image, double *mean = NULL)
 {
-	Mat resized, floatImage, dctImage;
-
-	/* Get the image down to a meaningful 32x32 sample */
-	resize(image, resized, Size(32, 32), 0, 0, INTER_AREA);
-	//cv::imwrite("out2.png", resized, { cv::ImwriteFlags::IMWRITE_PNG_COMPRESSION, 0 });
-
-	/* DCT func needs floats, convert to */
-	resized.convertTo(floatImage, CV_32F); // Convert to float for DCT
-	dct(floatImage, dctImage);
-
-	/* Get the dct block top left cols 0..7 and rows 00.77 from the dct'd image */
-	Mat dctBlock = dctImage(Rect(0, 0, 8, 8));
-
-	int idx = 0;
 	float values[64];
+	uint64_t hash = dcthash_compute(image.data, image.step, image.cols, image.rows, mean, values);
 
 	if (ctx->verbose) {
 		printf("DCT 8x8 Block:\n");
-	}
-
-	for (int i = 0; i < 8; ++i) {
-		for (int j = 0; j < 8; ++j) {
-			if (ctx->verbose) {
-				printf("%7.2f ", dctBlock.at<float>(i, j));
+		for (int i = 0; i < 8; ++i) {
+			for (int j = 0; j < 8; ++j) {
+				printf("%7.2f ", values[i * 8 + j]);
 			}
-			values[i * 8 + j] = dctBlock.at<float>(i, j);
-		}
-		if (ctx->verbose) {
 			printf("\n");
 		}
-	}
-
-	/* Get the high and low medians, be careful not to disrupt
-	 * the 'values' array, copy and nth_elemtn sort on copy. */
-	float temp[64];
-	std::copy(values, values + 64, temp);
-	std::nth_element(temp, temp + 31, temp + 64);
-	float low = temp[31];
-	std::nth_element(temp, temp + 32, temp + 64);
-	float high = temp[32];
-
-	float median = (low + high) / 2.0f;
-
-	if (ctx->verbose) {
-		printf("median %f h %f l %f\n", median, high, low);
-	}
-
-	/* Compute the hash */
-	uint64_t hash = 0;
-	for (int i = 0; i < 64; ++i) {
-		if (values[i] > median) {
-			hash |= (1ULL << (63 - i));
-		}
-	}
-
-	if (ctx->verbose) {
 		printf("DCT Hash: %" PRIx64 "\n", hash);
 	}
 
@@ -229,18 +288,11 @@ double compute_sharpness(const cv::Mat &image)
 	if (image.channels() == 3) {
 		cvtColor(image, gray, COLOR_BGR2GRAY);
 	} else {
-		gray = image.clone();
+		gray = image;
 	}
 
-	Mat laplacian;
-	Laplacian(gray, laplacian, CV_64F);
-
-	// Calculate the variance of the Laplacian
-	Scalar mean, stddev;
-	meanStdDev(laplacian, mean, stddev);
-
-	// Variance is the square of the standard deviation
-	return stddev[0] * stddev[0];
+	// Variance of the Laplacian, computed in one fused pass by the dispatched kernel
+	return kernels_laplacian_variance(gray.data, gray.step, gray.cols, gray.rows);
 }
 
 double compute_psnr(double mse, double max_pixel_value)
@@ -251,19 +303,21 @@ double compute_psnr(double mse, double max_pixel_value)
     return 10.0 * log10((max_pixel_value * max_pixel_value) / mse);
 }
 
-double compute_luma_mse(const cv::Mat &frame1, const cv::Mat &frame2)
+/* Single pass fused squared error, no intermediate diff images. Frames may be ROIs.
+ * When a block grid is supplied, per block SSE lands in it with the frame
+ * positioned at (gx, gy) in grid coordinates.
+ */
+double compute_luma_mse(const cv::Mat &frame1, const cv::Mat &frame2, struct block_grid_s *grid = NULL, int gx = 0, int gy = 0)
 {
-    if (frame1.size() != frame2.size() || frame1.type() != frame2.type()) {
+    if (frame1.size() != frame2.size() || frame1.type() != frame2.type() || frame1.type() != CV_8UC1) {
         fprintf(stderr, "Error: Frame dimensions or types do not match.\n");
         return -1.0;
     }
 
-    cv::Mat diff;
-    cv::absdiff(frame1, frame2, diff);  // Compute absolute difference
-    diff.convertTo(diff, CV_64F);      // Convert to double for accurate computation
-    diff = diff.mul(diff);            // Square the differences
+    uint64_t sse = blockmse_plane(frame1.data, frame1.step, frame2.data, frame2.step,
+        frame1.cols, frame1.rows, grid, gx, gy);
 
-    double mse = cv::sum(diff)[0] / (frame1.rows * frame1.cols); // Normalize by the number of pixels
+    double mse = (double)sse / (frame1.rows * frame1.cols); // Normalize by the number of pixels
     return mse;
 }
 
@@ -280,10 +334,54 @@ void usage()
         printf("  -W width (pixels def: 1920)\n");
         printf("  -H height (pixels def: 1080)\n");
         printf("  -v raise verbosity\n");
+        printf("  -x isa force the kernel path, scalar, sse42, avx2 or avx512 [def: best for this cpu]\n");
         printf("  -b run best match and try to find frame offsets for best mse match\n");
         printf("    -w number of frames to process [def: 30] (bestmatch)\n");
+        printf("       frames are held in tiles of at most %d MB, larger windows re-read file2\n", BESTMATCH_BUDGET >> 20);
         printf("    -s number of frames from input 1 to skip (bestmatch)\n");
+        printf("    -j number of worker threads [def: 0, one per cpu] (bestmatch, batch)\n");
         printf("  -D run DCT hashes and try to find frame offsets for best aligned match\n");
+        printf("    --band N only search offsets up to +/- N frames [def: 0, every offset]\n");
+        printf("    --matrix dist.pgm write the hash distance matrix as an image, near identical pairs bright\n");
+        printf("    --xhash match 256 bit fingerprints, luma, chroma and motion hashes, for static content\n");
+        printf("  -F cross correlate whole file signatures to find offsets of any size, verified against DCT hashes\n");
+        printf("  -R map.txt drift tolerant alignment, map every file1 frame to a file2 frame through dropped\n");
+        printf("     and duplicated frames, -w sets the search band [def: 30]\n");
+        printf("    -U map.txt compare frames through a frame map from -R (mse mode)\n");
+        printf("  -a N report aggregates over a sliding window of N frames (mse mode)\n");
+        printf("  -q quiet, suppress per frame rows and only report aggregates (mse mode)\n");
+        printf("  -S segments.txt detect scene cuts, black and freeze segments in file1, write the segment list\n");
+        printf("     ('-' for stdout). Without -2 only segmentation runs, with -2 mse mode also reports per shot aggregates.\n");
+        printf("    -T hamming distance between consecutive frames for a scene cut [def: %d]\n", SEGMENT_CUT_THRESHOLD_DEFAULT);
+        printf("  -O N search +/- N pixels for a spatial shift/crop offset of file2, apply it to mse/psnr (mse mode)\n");
+        printf("  -B N luma block size for per block SSE [def: %d] (mse mode)\n", BLOCKMSE_SIZE_DEFAULT);
+        printf("    -G grid.bin write the per frame block SSE grid to a binary sidecar\n");
+        printf("    -M heatmap.png render the block MSE, over all frames, as a heatmap\n");
+        printf("  -m metrics.bin write per frame Y PSNR, Y MSE and sharpness to a binary file for picvmaf (mse mode)\n");
+        printf("    -V vmaf.json merge libvmaf's per frame scores (json log or picvmaf csv) into the metrics file\n");
+        printf("  -C state.ckpt checkpoint file for long mse, -F and -R passes [def: yuvmse.ckpt with -K or --resume]\n");
+        printf("    -K N write a checkpoint every N frames [def: %d with -C]\n", CHECKPOINT_INTERVAL_DEFAULT);
+        printf("    --resume continue from the checkpoint, append stdout to the earlier output\n");
+        printf("  -Q N frame reads in flight per input, 0 reads synchronously [def: %d] (mse mode)\n", FRAMEREADER_DEPTH_DEFAULT);
+        printf("    -E engine read ahead engine, io_uring, threads or sync [def: io_uring when available]\n");
+        printf("    --direct read with O_DIRECT, huge captures don't evict the page cache\n");
+        printf("  --hugepages off|thp|hugetlb back frame buffers with huge pages [def: thp, or VMAF_TOOLS_HUGEPAGES]\n");
+        printf("  -n N sampled triage, compare every Nth frame and estimate the aggregates with 95%% confidence intervals\n");
+        printf("  -r N sampled triage, compare N random frames, one from each of N equal stretches of the file\n");
+        printf("    -e seed sample seed [def: 1]\n");
+        printf("    -t dB flag sampled frames below this Y PSNR and estimate the share of the file below it\n");
+        printf("  -J manifest.txt batch, compare every pair in the manifest on one shared pool, a report per pair\n");
+        printf("     exits non zero when any pair failed\n");
+        printf("    -I N concurrent frame reads across the pool [def: %d]\n", BATCH_IO_DEFAULT);
+        printf("  -f, --follow compare the files as they're written, each frame pair as soon as both are complete\n");
+        printf("    --start A,B begin at file1 frame A and file2 frame B, as reported by -D [def: 0,0]\n");
+        printf("    --idle N stop after N seconds without a new frame pair [def: 0, run until interrupted]\n");
+        printf("    --poll ms longest wait between size checks [def: %d]\n", FOLLOW_POLL_MS_DEFAULT);
+        printf("    -a N rolling window [def: %d], -t dB alarm when the window Y PSNR drops below dB\n", FOLLOW_WINDOW_DEFAULT);
+        printf("  -z, --preview 2|4 screening run, metrics on a 2x or 4x box downsampled pyramid level (mse, bestmatch,\n");
+        printf("     -D, -S, sampling, follow and batch modes) [def: 1, full resolution]\n");
+        printf("  -L N cache the stats of the last N distinct frame pairs, repeats skip the metrics, try 256 for\n");
+        printf("     content with freezes, slates or black runs [def: %d, off]\n", FRAMECACHE_ENTRIES_DEFAULT);
 }
 
 struct frame_stats_s
@@ -292,46 +390,117 @@ struct frame_stats_s
 	double y_psnr, u_psnr, v_psnr;
 	double sharpness[2];
 	uint64_t hash[2];
+	double luma_mean[2];
 };
 
-int compute_frame_stats(struct tool_context_s *ctx, unsigned char *b1, unsigned char *b2, struct frame_stats_s *stats)
+/* MSE and PSNR for each plane of a frame pair. Touches only the mse/psnr
+ * fields of stats and no shared state besides ctx->grid, so it's safe to call
+ * from worker threads when no grid is being collected.
+ */
+int compute_frame_mse(struct tool_context_s *ctx, unsigned char *b1, unsigned char *b2, struct frame_stats_s *stats)
 {
-	// MMM
-	memset(stats, 0, sizeof(*stats));
+	/* With a spatial offset only the overlapping regions are compared */
+	int dx = 0, dy = 0;
+	if (ctx->shift_valid) {
+		dx = ctx->shift.dx;
+		dy = ctx->shift.dy;
+	}
 
-	Mat y1 = Mat(ctx->height, ctx->width, CV_8UC1, b1);
+	int cw = ctx->width / 2;
+	int ch = ctx->height / 2;
+	const uint8_t *p1[3] = { b1, b1 + (ctx->width * ctx->height), b1 + (ctx->width * ctx->height) + (cw * ch) };
+	const uint8_t *p2[3] = { b2, b2 + (ctx->width * ctx->height), b2 + (ctx->width * ctx->height) + (cw * ch) };
+	const int stride[3] = { ctx->width, cw, cw };
 
-	Mat y2;
+	double mse[3];
+	blockmse_frame_420(p1, stride, p2, stride, ctx->width, ctx->height, dx, dy, ctx->grid, mse);
+	stats->y_mse = mse[0];
+	stats->u_mse = mse[1];
+	stats->v_mse = mse[2];
+
+	const double max_pixel_value = 255.0;
+	stats->y_psnr = compute_psnr(stats->y_mse, max_pixel_value);
+	stats->u_psnr = compute_psnr(stats->u_mse, max_pixel_value);
+	stats->v_psnr = compute_psnr(stats->v_mse, max_pixel_value);
+
+	return 0; /* Success */
+}
+
+/* Preview, the same options at the pyramid level's geometry. A spatial offset found at
+ * full resolution shrinks with the frame.
+ */
+static void preview_context(const struct tool_context_s *ctx, struct tool_context_s *lvl)
+{
+	*lvl = *ctx;
+	lvl->width = ctx->width >> ctx->preview;
+	lvl->height = ctx->height >> ctx->preview;
+	lvl->shift.dx = ctx->shift.dx / (1 << ctx->preview);
+	lvl->shift.dy = ctx->shift.dy / (1 << ctx->preview);
+	lvl->preview = 0;
+}
+
+static const char *preview_label(const struct tool_context_s *ctx, const char *label, char *buf, size_t len)
+{
+	if (ctx->preview == 0) {
+		return label;
+	}
+	snprintf(buf, len, "%s, preview %dx (%dx%d)", label, 1 << ctx->preview,
+		ctx->width >> ctx->preview, ctx->height >> ctx->preview);
+	return buf;
+}
+
+int compute_frame_stats(struct tool_context_s *ctx, unsigned char *b1, unsigned char *b2, struct frame_stats_s *stats);
+
+/* The pyramid is built from the frames just read into thread scratch, and everything
+ * below runs at the reduced level unchanged.
+ */
+static int compute_frame_stats_preview(struct tool_context_s *ctx, unsigned char *b1, unsigned char *b2,
+	struct frame_stats_s *stats)
+{
+	struct arena_s *a = arena_thread();
+	size_t mark = arena_mark(a);
+
+	uint8_t *l1[PYRAMID_LEVELS_MAX], *l2[PYRAMID_LEVELS_MAX];
+	for (int l = 0; l < ctx->preview; l++) {
+		size_t len = pyramid_level_size(ctx->width, ctx->height, l + 1);
+		l1[l] = (uint8_t *)arena_alloc(a, len);
+		l2[l] = b2 ? (uint8_t *)arena_alloc(a, len) : NULL;
+		if (l1[l] == NULL || (b2 && l2[l] == NULL)) {
+			fprintf(stderr, "unable to allocate memory for the preview pyramid, aborting\n");
+			exit(1);
+		}
+	}
+	pyramid_build(b1, ctx->width, ctx->height, ctx->preview, l1);
 	if (b2) {
-		y2 = Mat(ctx->height, ctx->width, CV_8UC1, b2);
-		stats->y_mse = compute_luma_mse(y1, y2);
+		pyramid_build(b2, ctx->width, ctx->height, ctx->preview, l2);
 	}
 
-	int chroma_width = ctx->width / 2;
-	int chroma_height = ctx->height / 2;
+	struct tool_context_s lvl;
+	preview_context(ctx, &lvl);
+	compute_frame_stats(&lvl, l1[ctx->preview - 1], b2 ? l2[ctx->preview - 1] : NULL, stats);
 
-	unsigned char *u1 = b1 + (ctx->width * ctx->height);
-	unsigned char *u2 = b2 + (ctx->width * ctx->height);
+	arena_release(a, mark);
 
-	Mat u1_mat = Mat(chroma_height, chroma_width, CV_8UC1, u1);
-	if (b2) {
-		Mat u2_mat = Mat(chroma_height, chroma_width, CV_8UC1, u2);
-		stats->u_mse = compute_luma_mse(u1_mat, u2_mat);
+	return 0; /* Success */
+}
+
+int compute_frame_stats(struct tool_context_s *ctx, unsigned char *b1, unsigned char *b2, struct frame_stats_s *stats)
+{
+	if (ctx->preview) {
+		return compute_frame_stats_preview(ctx, b1, b2, stats);
 	}
 
-	unsigned char *v1 = u1 + (chroma_width * chroma_height);
-	unsigned char *v2 = u2 + (chroma_width * chroma_height);
-	Mat v1_mat = Mat(chroma_height, chroma_width, CV_8UC1, v1);
+	// MMM
+	memset(stats, 0, sizeof(*stats));
+
 	if (b2) {
-		Mat v2_mat = Mat(chroma_height, chroma_width, CV_8UC1, v2);
-		stats->v_mse = compute_luma_mse(v1_mat, v2_mat);
+		compute_frame_mse(ctx, b1, b2, stats);
 	}
 
+	Mat y1 = Mat(ctx->height, ctx->width, CV_8UC1, b1);
+	Mat y2;
 	if (b2) {
-		const double max_pixel_value = 255.0;
-		stats->y_psnr = compute_psnr(stats->y_mse, max_pixel_value);
-		stats->u_psnr = compute_psnr(stats->u_mse, max_pixel_value);
-		stats->v_psnr = compute_psnr(stats->v_mse, max_pixel_value);
+		y2 = Mat(ctx->height, ctx->width, CV_8UC1, b2);
 	}
 
 	stats->sharpness[0] = compute_sharpness(y1);
@@ -339,19 +508,163 @@ int compute_frame_stats(struct tool_context_s *ctx, unsigned char *b1, unsigned
 		stats->sharpness[1] = compute_sharpness(y2);
 	}
 
-	stats->hash[0] = computeDCTHash(ctx, y1);
+	stats->hash[0] = computeDCTHash(ctx, y1, &stats->luma_mean[0]);
 	if (b2) {
-		stats->hash[1] = computeDCTHash(ctx, y2);
+		stats->hash[1] = computeDCTHash(ctx, y2, &stats->luma_mean[1]);
 	}
 
 	return 0; /* Success */
 }
 
-int compute_sequence_bestmatch(struct tool_context_s *ctx)
+/* compute_frame_stats() through the repeated content cache. A pair of frames whose
+ * fingerprints were seen before returns the earlier stats, and block SSE cells when
+ * a grid is being collected, without running the metrics. The cache is sized on
+ * first use in a pass, stats_cache_close() ends it.
+ */
+int compute_frame_stats_cached(struct tool_context_s *ctx, unsigned char *b1, unsigned char *b2, struct frame_stats_s *stats)
 {
-	double low_y_mse = 60000.0;
-	int low_frame = 0;
+	if (ctx->cache_entries <= 0) {
+		return compute_frame_stats(ctx, b1, b2, stats);
+	}
+
+	size_t cells = ctx->grid ? (size_t)ctx->grid->cols * ctx->grid->rows * sizeof(uint32_t) : 0;
+	if (ctx->cache.entries == 0 && framecache_alloc(&ctx->cache, ctx->cache_entries, sizeof(*stats) + cells) < 0) {
+		fprintf(stderr, "unable to allocate memory for the stats cache, aborting\n");
+		exit(1);
+	}
+
+	size_t frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+
+	struct framecache_key_s key;
+	memset(&key, 0, sizeof(key));
+	framecache_fingerprint(b1, frame_size, key.a);
+	if (b2) {
+		framecache_fingerprint(b2, frame_size, key.b);
+	}
+
+	uint8_t *v = (uint8_t *)framecache_lookup(&ctx->cache, &key);
+	if (v) {
+		memcpy(stats, v, sizeof(*stats));
+		if (cells) {
+			memcpy(ctx->grid->sse, v + sizeof(*stats), cells);
+		}
+		return 0; /* Success */
+	}
+
+	compute_frame_stats(ctx, b1, b2, stats);
+
+	v = (uint8_t *)framecache_insert(&ctx->cache, &key);
+	memcpy(v, stats, sizeof(*stats));
+	if (cells) {
+		memcpy(v + sizeof(*stats), ctx->grid->sse, cells);
+	}
+
+	return 0; /* Success */
+}
+
+void stats_cache_close(struct tool_context_s *ctx)
+{
+	if (ctx->cache.entries == 0) {
+		return;
+	}
+	printf("# stats cache: %" PRIu64 " hits, %" PRIu64 " misses\n", ctx->cache.hits, ctx->cache.misses);
+	framecache_free(&ctx->cache);
+}
+
+/* Bestmatch compares every reference frame in the window with every candidate
+ * frame in the window. Each (reference, candidate block) pair is an independent
+ * task on a work stealing pool, sharing the read only window frames.
+ *
+ * Only a tile of reference frames and a tile of candidate frames are resident
+ * at once, each bounded to half of BESTMATCH_BUDGET. Candidate tiles stream
+ * past each reference tile, results land in a per tile table of
+ * refs * window candidates and are reduced per reference frame, in order,
+ * before the next reference tile is read. When the whole window fits in the
+ * budget every frame is read exactly once.
+ */
+#define BESTMATCH_TASK_CANDIDATES 4
+
+struct bestmatch_s
+{
+	struct tool_context_s *ctx;
+	int frame_size;
+	int refs;               /* Reference frames in this tile, file 1 */
+	int cands;              /* Candidate frames in the window, file 2 */
+	int cand_first;         /* Window candidate number of cand_frames[0] */
+	unsigned char *ref_frames;
+	unsigned char *cand_frames;
+	struct frame_stats_s *results; /* refs * cands */
+};
+
+struct bestmatch_task_s
+{
+	struct bestmatch_s *bm;
+	int ref;
+	int cand_start;
+	int cand_end;
+};
+
+static void bestmatch_task(void *arg, int worker)
+{
+	struct bestmatch_task_s *t = (struct bestmatch_task_s *)arg;
+	struct bestmatch_s *bm = t->bm;
+
+	unsigned char *b1 = bm->ref_frames + ((size_t)t->ref * bm->frame_size);
+	for (int c = t->cand_start; c < t->cand_end; c++) {
+		unsigned char *b2 = bm->cand_frames + ((size_t)(c - bm->cand_first) * bm->frame_size);
+		compute_frame_mse(bm->ctx, b1, b2, &bm->results[(t->ref * bm->cands) + c]);
+	}
+}
+
+static int bestmatch_read_window(const char *fn, int first, int count, int frame_size, unsigned char *dst)
+{
+	FILE *fh = fopen(fn, "rb");
+	if (!fh) {
+		return -1;
+	}
+
+	if (fseeko(fh, (off_t)first * frame_size, SEEK_SET) < 0) {
+		fclose(fh);
+		return -1;
+	}
+
+	int nr = 0;
+	while (nr < count) {
+		if (fread(dst + ((size_t)nr * frame_size), 1, frame_size, fh) != (size_t)frame_size) {
+			break;
+		}
+		nr++;
+	}
+
+	fclose(fh);
+	return nr;
+}
+
+/* Decimate a window of frames to their top pyramid level, packed the same way into dst */
+static void bestmatch_preview_window(struct tool_context_s *ctx, unsigned char *frames, int count, int frame_size, unsigned char *dst)
+{
+	size_t level_size[PYRAMID_LEVELS_MAX];
+	for (int l = 0; l < ctx->preview; l++) {
+		level_size[l] = pyramid_level_size(ctx->width, ctx->height, l + 1);
+	}
+
+	unsigned char *tmp = ctx->preview > 1 ? (unsigned char *)arena_buffer_alloc(level_size[0]) : NULL;
+	if (ctx->preview > 1 && tmp == NULL) {
+		fprintf(stderr, "unable to allocate memory for the preview window, aborting\n");
+		exit(1);
+	}
+
+	for (int i = 0; i < count; i++) {
+		uint8_t *levels[PYRAMID_LEVELS_MAX] = { tmp, NULL };
+		levels[ctx->preview - 1] = dst + ((size_t)i * level_size[ctx->preview - 1]);
+		pyramid_build(frames + ((size_t)i * frame_size), ctx->width, ctx->height, ctx->preview, levels);
+	}
 
+	arena_buffer_free(tmp);
+}
+
+int compute_sequence_bestmatch(struct tool_context_s *ctx)
+{
 	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
 
 	/* Check the files are a perfect multiple of frame_size */
@@ -373,71 +686,150 @@ int compute_sequence_bestmatch(struct tool_context_s *ctx)
 		exit(1);
 	}
 
-	unsigned char *b1 = (unsigned char *)malloc(frame_size);
-	unsigned char *b2 = (unsigned char *)malloc(frame_size);
-	if (b1 == NULL || b2 == NULL) {
-		fprintf(stderr, "unable to allocate memory for frame, aborting\n");
+	/* The window, file 1 frames skipframes..windowsize, file 2 frames 0..windowsize,
+	 * clipped to the length of the files.
+	 */
+	int frames = s1.st_size / frame_size;
+	int ref_first = ctx->skipframes;
+	int ref_count = ctx->windowsize - ctx->skipframes + 1;
+	if (ref_count > frames - ref_first) {
+		ref_count = frames - ref_first;
+	}
+	int cand_count = ctx->windowsize + 1 < frames ? ctx->windowsize + 1 : frames;
+	if (ref_count <= 0 || cand_count <= 0) {
+		return 0;
+	}
+
+	/* Tile sizes in full size frames, half the budget each */
+	int tile = (BESTMATCH_BUDGET / 2) / frame_size;
+	if (tile < 1) {
+		tile = 1;
+	}
+	int ref_tile = ref_count < tile ? ref_count : tile;
+	int cand_tile = cand_count < tile ? cand_count : tile;
+
+	struct bestmatch_s bm;
+	memset(&bm, 0, sizeof(bm));
+	bm.ctx = ctx;
+	bm.frame_size = frame_size;
+	bm.cands = cand_count;
+
+	unsigned char *ref_buf = (unsigned char *)arena_buffer_alloc((size_t)ref_tile * frame_size);
+	unsigned char *cand_buf = (unsigned char *)arena_buffer_alloc((size_t)cand_tile * frame_size);
+	bm.results = (struct frame_stats_s *)calloc((size_t)ref_tile * cand_count, sizeof(struct frame_stats_s));
+	if (ref_buf == NULL || cand_buf == NULL || bm.results == NULL) {
+		fprintf(stderr, "unable to allocate memory for %d + %d window frames, aborting\n", ref_tile, cand_tile);
 		exit(1);
 	}
+	bm.ref_frames = ref_buf;
+	bm.cand_frames = cand_buf;
+
+	/* Preview, each tile frame is decimated once after it's read and every comparison runs on the level */
+	struct tool_context_s lvl;
+	unsigned char *ref_lvl = NULL, *cand_lvl = NULL;
+	if (ctx->preview) {
+		preview_context(ctx, &lvl);
+		bm.ctx = &lvl;
+		bm.frame_size = pyramid_level_size(ctx->width, ctx->height, ctx->preview);
+		ref_lvl = (unsigned char *)arena_buffer_alloc((size_t)ref_tile * bm.frame_size);
+		cand_lvl = (unsigned char *)arena_buffer_alloc((size_t)cand_tile * bm.frame_size);
+		if (ref_lvl == NULL || cand_lvl == NULL) {
+			fprintf(stderr, "unable to allocate memory for the preview window, aborting\n");
+			exit(1);
+		}
+		bm.ref_frames = ref_lvl;
+		bm.cand_frames = cand_lvl;
+		printf("# bestmatch: preview %dx, %dx%d\n", 1 << ctx->preview, lvl.width, lvl.height);
+	}
 
-	FILE *fh1 = fopen(ctx->fn[0], "rb");
-	if (!fh1) {
-		fprintf(stderr, "input file 1 not found, aborting\n");
+	struct workpool_s *pool = workpool_alloc(ctx->threads);
+	if (ctx->verbose) {
+		printf("# bestmatch: %d x %d comparisons on %d threads, tiles of %d x %d frames\n",
+			ref_count, cand_count, workpool_threads(pool), ref_tile, cand_tile);
+	}
+
+	int blocks = (cand_tile + BESTMATCH_TASK_CANDIDATES - 1) / BESTMATCH_TASK_CANDIDATES;
+	struct bestmatch_task_s *tasks = (struct bestmatch_task_s *)calloc((size_t)ref_tile * blocks + 1, sizeof(*tasks));
+	if (tasks == NULL) {
+		fprintf(stderr, "unable to allocate memory for tasks, aborting\n");
 		exit(1);
 	}
 
-	int nr1 = 0;
-	int skip_frames = ctx->skipframes;
-	while (!feof(fh1)) {
-		FILE *fh2 = fopen(ctx->fn[1], "rb");
-		if (!fh2) {
-			fprintf(stderr, "input file 2 not found, aborting\n");
+	int cand_loaded = -1; /* Window candidate number of the tile in cand_buf */
+	int low_frame = 0;
+	for (int rt = 0; rt < ref_count; rt += ref_tile) {
+		bm.refs = ref_count - rt < ref_tile ? ref_count - rt : ref_tile;
+		if (bestmatch_read_window(ctx->fn[0], ref_first + rt, bm.refs, frame_size, ref_buf) != bm.refs) {
+			fprintf(stderr, "input file 1 read failed, aborting\n");
 			exit(1);
 		}
-		size_t l1 = fread(b1, 1, frame_size, fh1);
-		if (skip_frames-- > 0) {
-			nr1++;
-			continue;
+		if (ctx->preview) {
+			bestmatch_preview_window(ctx, ref_buf, bm.refs, frame_size, ref_lvl);
 		}
 
-		int nr2 = 0;
-
-		low_y_mse = 60000.0;
-		while (!feof(fh2)) {
-			size_t l2 = fread(b2, 1, frame_size, fh2);
+		for (int ct = 0; ct < cand_count; ct += cand_tile) {
+			int count = cand_count - ct < cand_tile ? cand_count - ct : cand_tile;
 
-			if (l1 != frame_size || l2 != frame_size) {
-				break;
+			/* A window that fits in one tile is read once for every reference tile */
+			if (ct != cand_loaded) {
+				if (bestmatch_read_window(ctx->fn[1], ct, count, frame_size, cand_buf) != count) {
+					fprintf(stderr, "input file 2 read failed, aborting\n");
+					exit(1);
+				}
+				if (ctx->preview) {
+					bestmatch_preview_window(ctx, cand_buf, count, frame_size, cand_lvl);
+				}
+				cand_loaded = ct;
+			}
+			bm.cand_first = ct;
+
+			int t = 0;
+			for (int r = 0; r < bm.refs; r++) {
+				for (int c = ct; c < ct + count; c += BESTMATCH_TASK_CANDIDATES) {
+					tasks[t].bm = &bm;
+					tasks[t].ref = r;
+					tasks[t].cand_start = c;
+					tasks[t].cand_end = c + BESTMATCH_TASK_CANDIDATES < ct + count ? c + BESTMATCH_TASK_CANDIDATES : ct + count;
+					workpool_submit(pool, bestmatch_task, &tasks[t]);
+					t++;
+				}
 			}
+			workpool_wait(pool);
+		}
 
-			struct frame_stats_s stats;
-			compute_frame_stats(ctx, b1, b2, &stats);
+		/* Reduce per reference frame, in order */
+		for (int r = 0; r < bm.refs; r++) {
+			int nr1 = ref_first + rt + r;
+			double low_y_mse = 60000.0;
 
-			if (ctx->verbose && stats.y_mse >= 0.0) {
-				printf("frame %08d.%08d, mse Y %8.2f, U %8.2f, V %8.2f, psnr(dB) Y %8.2f, U %8.2f, V %8.2f\n",
-					nr1, nr2,
-					stats.y_mse, stats.u_mse, stats.v_mse,
-					stats.y_psnr, stats.u_psnr, stats.v_psnr);
-			}
-			if (stats.y_mse < low_y_mse) {
-				low_y_mse = stats.y_mse;
-				low_frame = nr2;
-			}
+			for (int nr2 = 0; nr2 < bm.cands; nr2++) {
+				struct frame_stats_s *stats = &bm.results[(r * bm.cands) + nr2];
 
-			if (nr2++ >= ctx->windowsize) {
-				printf("best match for file1.frame %08d, y mse was %8.2f file2.frame %08d\n", nr1, low_y_mse, low_frame);
-				break;
+				if (ctx->verbose && stats->y_mse >= 0.0) {
+					printf("frame %08d.%08d, mse Y %8.2f, U %8.2f, V %8.2f, psnr(dB) Y %8.2f, U %8.2f, V %8.2f\n",
+						nr1, nr2,
+						stats->y_mse, stats->u_mse, stats->v_mse,
+						stats->y_psnr, stats->u_psnr, stats->v_psnr);
+				}
+				if (stats->y_mse < low_y_mse) {
+					low_y_mse = stats->y_mse;
+					low_frame = nr2;
+				}
+
+				if (nr2 >= ctx->windowsize) {
+					printf("best match for file1.frame %08d, y mse was %8.2f file2.frame %08d\n", nr1, low_y_mse, low_frame);
+				}
 			}
 		}
-		fclose(fh2);
-		if (nr1++ >= ctx->windowsize) {
-			break;
-		}
 	}
+	workpool_free(pool);
 
-	free(b1);
-	free(b2);
-	fclose(fh1);
+	free(tasks);
+	free(bm.results);
+	arena_buffer_free(ref_buf);
+	arena_buffer_free(cand_buf);
+	arena_buffer_free(ref_lvl);
+	arena_buffer_free(cand_lvl);
 
 	return 0;
 }
@@ -461,18 +853,30 @@ int compute_sequence_dct_hashes_input(struct tool_context_s *ctx, int inputnr, u
 
 	int frame_count = (s.st_size / frame_size) + 1;
 
-	uint64_t *hlist = (uint64_t *)malloc(sizeof(uint64_t) * frame_count);
+	uint64_t *hlist = (uint64_t *)calloc(frame_count, sizeof(uint64_t));
 	if (hlist == NULL) {
 		fprintf(stderr, "unable to allocate memory for hashlist, aborting\n");
 		exit(1);
 	}
 
-	unsigned char *b1 = (unsigned char *)malloc(frame_size);
+	unsigned char *b1 = (unsigned char *)arena_buffer_alloc(frame_size);
 	if (b1 == NULL) {
 		fprintf(stderr, "unable to allocate memory for frame, aborting\n");
 		exit(1);
 	}
 
+	/* Extended fingerprints need the previous luma plane for the motion word */
+	struct fingerprint_list_s *prints = &ctx->prints[inputnr];
+	unsigned char *prev = NULL;
+	int have_prev = 0;
+	if (ctx->xhash) {
+		prev = (unsigned char *)arena_buffer_alloc(ctx->width * ctx->height);
+		if (prev == NULL || fingerprint_list_alloc(prints, frame_count) < 0) {
+			fprintf(stderr, "unable to allocate memory for fingerprints, aborting\n");
+			exit(1);
+		}
+	}
+
 	int nr = 0;
 
 	int line = 0;
@@ -483,6 +887,10 @@ int compute_sequence_dct_hashes_input(struct tool_context_s *ctx, int inputnr, u
 			break;
 		}
 		if (skip_frames-- > 0) {
+			if (prev) {
+				memcpy(prev, b1, ctx->width * ctx->height);
+				have_prev = 1;
+			}
 			nr++;
 			continue;
 		}
@@ -491,19 +899,35 @@ int compute_sequence_dct_hashes_input(struct tool_context_s *ctx, int inputnr, u
 		}
 
 		struct frame_stats_s stats;
-		compute_frame_stats(ctx, b1, NULL, &stats);
+		compute_frame_stats_cached(ctx, b1, NULL, &stats);
 
 		hlist[nr] = stats.hash[0];
 
-		if (ctx->verbose) {
+		if (prev) {
+			uint64_t words[FINGERPRINT_WORDS];
+			fingerprint_frame(b1, have_prev ? prev : NULL, ctx->width, ctx->height, stats.hash[0], words);
+			for (int w = 0; w < FINGERPRINT_WORDS; w++) {
+				prints->word[w][nr] = words[w];
+			}
+			memcpy(prev, b1, ctx->width * ctx->height);
+			have_prev = 1;
+		}
+
+		if (ctx->verbose && prev) {
+			printf("frame %08d, fingerprint %016" PRIx64 " %016" PRIx64 " %016" PRIx64 " %016" PRIx64 ", %s\n", nr,
+				prints->word[0][nr], prints->word[1][nr], prints->word[2][nr], prints->word[3][nr], ctx->fn[inputnr]);
+		} else if (ctx->verbose) {
 			printf("frame %08d, hash %" PRIx64 ", %s\n", nr, stats.hash[0], ctx->fn[inputnr]);
 		}
 
 		nr++;
 	}
 
-	free(b1);
+	stats_cache_close(ctx);
+	arena_buffer_free(b1);
+	arena_buffer_free(prev);
 	fclose(fh1);
+	prints->count = nr;
 
 	*hash_count = nr;
 	*hashes = hlist;
@@ -511,44 +935,26 @@ int compute_sequence_dct_hashes_input(struct tool_context_s *ctx, int inputnr, u
 	return 0; /* Success */
 }
 
-/* Function to find the longest matching sequence in two arrays
- * Input arrays must be the same length.
- * return number of matches, else -1 on error.
- * return positions of matching sequence in posA and B
+/* Longest run of near identical hashes along any diagonal of a[0..lenA) x b[0..lenB),
+ * the first of equal runs by offset, then position. One batched popcount pass per row.
+ * Returns the run length with its start in posA and posB, -1 on error or no match.
  */
-static int findLongestMatch(uint64_t *a, uint64_t *b, int len, int *posA, int *posB, int verbose)
-{
-	int maxLen = 0;
-	int startA = 0, startB = 0;
-
-	for (int offset = -len + 1; offset < len; ++offset) {
-		int currentLen = 0;
-		for (int i = 0; i < len; ++i) {
-			int j = i + offset;
-			if (j >= 0 && j < len) {
-				int hd = hamming_distance(a[i], b[j]);
-				if (hd <= 2) {
-					currentLen++;
-					if (currentLen > maxLen) {
-						maxLen = currentLen;
-						startA = i - currentLen + 1;
-						startB = j - currentLen + 1;
-					}
-				} else {
-					currentLen = 0;
-				}
-			}
-		}
+static int findLongestMatch(uint64_t *a, int lenA, uint64_t *b, int lenB, int *posA, int *posB, int verbose)
+{
+	struct hashmatrix_s m;
+	if (hashmatrix_compute(&m, a, lenA, b, lenB, 0, NULL) < 0) {
+		return -1;
 	}
+	hashmatrix_free(&m);
 
-	if (maxLen > 0) {
-		*posA = startA;
-		*posB = startB;
+	if (m.run_len > 0) {
+		*posA = m.run_a;
+		*posB = m.run_b;
 
 		if (verbose) {
 			printf("Matching sequence: ");
-			for (int i = 0; i < maxLen; ++i) {
-				printf("%" PRIx64 " ", a[startA + i]);
+			for (int i = 0; i < m.run_len; ++i) {
+				printf("%" PRIx64 " ", a[m.run_a + i]);
 			}
 			printf("\n");
 		}
@@ -556,7 +962,30 @@ static int findLongestMatch(uint64_t *a, uint64_t *b, int len, int *posA, int *p
 		return -1; /* Error - No matching sequence */
 	}
 
-	return maxLen; /* Success */
+	return m.run_len; /* Success */
+}
+
+void print_trimming_instructions(struct tool_context_s *ctx, int matches, int posA, int posB)
+{
+	if (matches > 0) {
+		printf("# Frame sequence, file 1 begins frame %08d, file 2 begins frame %08d\n", posA, posB);
+		if (posA > 0) {
+			printf("# Trimming instructions:\n");
+			printf("#   dd if=%s of=%s.trimmed bs=%d skip=%d\n",
+				ctx->fn[0], ctx->fn[0],
+				(ctx->width * ctx->height * 3) / 2, posA);
+		}
+		if (posB > 0) {
+			printf("# Trimming instructions:\n");
+			printf("#   dd if=%s of=%s.trimmed bs=%d skip=%d\n",
+				ctx->fn[1], ctx->fn[1],
+				(ctx->width * ctx->height * 3) / 2, posB);
+		}
+		if (posA == 0 && posB == 0) {
+			printf("# No trimming instructions necessary, YUV is already aligned.\n");
+		}
+		printf("# Live captures can be followed from here with --follow --start %d,%d\n", posA, posB);
+	}
 }
 
 /* Product DCT hashes for each YUV file.
@@ -585,135 +1014,1911 @@ int compute_sequence_dct_hashes(struct tool_context_s *ctx)
 		}
 	}
 
-	/* Search hashes for input 2 and align with input 1 */
+	/* Search hashes for input 2 and align with input 1, over the band or the whole matrix */
 	int matches = 0;
 	int match_seq_count = 0;
 	int posA, posB;
 	if (inputs > 1) {
-		matches = findLongestMatch(ctx->hashes[0], ctx->hashes[1], ctx->hash_count[0], &posA, &posB, ctx->verbose);
-	}
-	printf("# hash sequence matches: %d\n", matches);
-	if (matches) {
-		printf("# Frame sequence, file 1 begins frame %08d, file 2 begins frame %08d\n", posA, posB);
-		if (posA > 0) {
-			printf("# Trimming instructions:\n");
-			printf("#   dd if=%s of=%s.trimmed bs=%d skip=%d\n",
-				ctx->fn[0], ctx->fn[0],
-				(ctx->width * ctx->height * 3) / 2, posA);
+		FILE *pgm = NULL;
+		if (ctx->matrixfn) {
+			pgm = fopen(ctx->matrixfn, "wb");
+			if (pgm == NULL) {
+				fprintf(stderr, "unable to create distance matrix %s, aborting\n", ctx->matrixfn);
+				exit(1);
+			}
 		}
-		if (posB > 0) {
-			printf("# Trimming instructions:\n");
-			printf("#   dd if=%s of=%s.trimmed bs=%d skip=%d\n",
-				ctx->fn[1], ctx->fn[1],
-				(ctx->width * ctx->height * 3) / 2, posB);
+
+		/* Extended fingerprints, the word lists side by side, else the 64 bit hashes */
+		const uint64_t *wa[FINGERPRINT_WORDS], *wb[FINGERPRINT_WORDS];
+		int words = ctx->xhash ? FINGERPRINT_WORDS : 1;
+		wa[0] = ctx->hashes[0];
+		wb[0] = ctx->hashes[1];
+		for (int w = 1; w < words; w++) {
+			wa[w] = ctx->prints[0].word[w];
+			wb[w] = ctx->prints[1].word[w];
 		}
-		if (posA == 0 && posB == 0) {
-			printf("# No trimming instructions necessary, YUV is already aligned.\n");
+
+		struct hashmatrix_s m;
+		if (hashmatrix_compute_words(&m, wa, wb, words, ctx->hash_count[0], ctx->hash_count[1],
+			ctx->hash_band, pgm) < 0) {
+			fprintf(stderr, "unable to compute the hash distance matrix%s, aborting\n", pgm ? " or write it" : "");
+			exit(1);
+		}
+		if (pgm) {
+			fclose(pgm);
+			printf("# distance matrix: %s, %d x %d\n", ctx->matrixfn,
+				ctx->hash_band ? m.hi - m.lo + 1 : m.nb, m.na);
+		}
+		hashmatrix_print_histogram(&m, stdout, HASHMATRIX_TOP_DEFAULT);
+		hashmatrix_free(&m);
+
+		if (m.run_len > 0) {
+			matches = m.run_len;
+			posA = m.run_a;
+			posB = m.run_b;
+			if (ctx->verbose) {
+				printf("Matching sequence: ");
+				for (int i = 0; i < matches; ++i) {
+					printf("%" PRIx64 " ", ctx->hashes[0][posA + i]);
+				}
+				printf("\n");
+			}
 		}
 	}
+	printf("# hash sequence matches: %d\n", matches);
+	print_trimming_instructions(ctx, matches, posA, posB);
 
 	for (int i = 0; i < MAX_INPUTS; i++) {
 		if (ctx->fn[i] && ctx->hashes[i]) {
 			free(ctx->hashes[i]);
 			ctx->hashes[i] = NULL;
 		}
+		fingerprint_list_free(&ctx->prints[i]);
 	}
 
 	return 0;
 }
 
-int compute_sequence_mse(struct tool_context_s *ctx)
+/* Whole file pass, a cheap per frame signature (frame to frame change in mean
+ * luma, the DC term of the hash DCT) plus the frame hash for verification.
+ */
+struct signatures_progress_s
 {
-	FILE *fh1 = fopen(ctx->fn[0], "rb");
-	if (!fh1) {
-		fprintf(stderr, "input file 1 not found, aborting\n");
+	int32_t count;
+	int32_t complete;
+	double prev_mean;
+	/* count floats of signature, then count uint64_t hashes */
+};
+
+static int checkpoint_put_signatures(struct checkpoint_s *cp, int inputnr, const float *slist, const uint64_t *hlist,
+	int count, int complete, double prev_mean)
+{
+	size_t len = sizeof(struct signatures_progress_s) + (count * (sizeof(float) + sizeof(uint64_t)));
+	uint8_t *buf = (uint8_t *)malloc(len);
+	if (buf == NULL) {
+		return -1;
+	}
+
+	struct signatures_progress_s *p = (struct signatures_progress_s *)buf;
+	p->count = count;
+	p->complete = complete;
+	p->prev_mean = prev_mean;
+	memcpy(buf + sizeof(*p), slist, count * sizeof(float));
+	memcpy(buf + sizeof(*p) + (count * sizeof(float)), hlist, count * sizeof(uint64_t));
+
+	int ret = checkpoint_put(cp, CKPT_SIGNATURES + inputnr, buf, len);
+	free(buf);
+
+	return ret;
+}
+
+/* Load the state file for --resume. NULL without one, the pass then starts from the
+ * beginning, a state file for other inputs or another mode is fatal.
+ */
+static int checkpoint_resume_load(struct tool_context_s *ctx, struct checkpoint_s *cp, uint32_t mode)
+{
+	struct checkpoint_header_s hdr;
+	checkpoint_identify(&hdr, mode, ctx->width, ctx->height, ctx->fn);
+
+	int ret = checkpoint_load(cp, ctx->ckptfn, &hdr);
+	if (ret == -2) {
+		fprintf(stderr, "checkpoint %s belongs to other inputs or another mode, aborting\n", ctx->ckptfn);
+		exit(1);
+	}
+	if (ret < 0) {
+		printf("# checkpoint: none usable at %s, starting from the beginning\n", ctx->ckptfn);
+	}
+
+	return ret;
+}
+
+static void checkpoint_failed(struct tool_context_s *ctx)
+{
+	/* Keep going, the analysis is still good, only the ability to resume is stale */
+	fprintf(stderr, "unable to write checkpoint %s\n", ctx->ckptfn);
+}
+
+/* The pass completed, a later --resume starts over */
+static void checkpoint_done(struct tool_context_s *ctx)
+{
+	if (ctx->ckptfn && ctx->ckpt_interval) {
+		unlink(ctx->ckptfn);
+	}
+}
+
+/* Checkpoint the signature lists, every input before inputnr is complete */
+static void checkpoint_signatures(struct tool_context_s *ctx, int inputnr, const float *slist, const uint64_t *hlist,
+	int count, int complete, double prev_mean)
+{
+	struct checkpoint_header_s hdr;
+	struct checkpoint_s cp;
+
+	checkpoint_identify(&hdr, CHECKPOINT_SIGNATURES, ctx->width, ctx->height, ctx->fn);
+	if (checkpoint_begin(&cp, ctx->ckptfn, &hdr) < 0) {
+		checkpoint_failed(ctx);
+		return;
+	}
+	for (int i = 0; i < inputnr; i++) {
+		if (checkpoint_put_signatures(&cp, i, ctx->sigs[i], ctx->hashes[i], ctx->hash_count[i], 1, 0) < 0) {
+			checkpoint_free(&cp);
+			checkpoint_failed(ctx);
+			return;
+		}
+	}
+	if (checkpoint_put_signatures(&cp, inputnr, slist, hlist, count, complete, prev_mean) < 0 ||
+		checkpoint_commit(&cp) < 0) {
+		checkpoint_free(&cp);
+		checkpoint_failed(ctx);
+		return;
+	}
+
+	if (ctx->verbose) {
+		printf("# checkpoint: input %d, %d frames\n", inputnr, count);
+	}
+}
+
+int compute_sequence_signatures_input(struct tool_context_s *ctx, int inputnr, float **sig, uint64_t **hashes, int *count)
+{
+	FILE *fh = fopen(ctx->fn[inputnr], "rb");
+	if (!fh) {
+		fprintf(stderr, "input file %d not found, aborting\n", inputnr);
+		exit(1);
+	}
+
+	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+
+	struct stat s;
+	stat(ctx->fn[inputnr], &s);
+	if (s.st_size % frame_size) {
+		fprintf(stderr, "file input %d isn't a perfect multiple of frame_size %d\n", inputnr, frame_size);
+		exit(1);
+	}
+
+	int frame_count = s.st_size / frame_size;
+
+	float *slist = (float *)malloc(sizeof(float) * (frame_count + 1));
+	uint64_t *hlist = (uint64_t *)malloc(sizeof(uint64_t) * (frame_count + 1));
+	unsigned char *b1 = (unsigned char *)arena_buffer_alloc(frame_size);
+	if (slist == NULL || hlist == NULL || b1 == NULL) {
+		fprintf(stderr, "unable to allocate memory for signatures, aborting\n");
+		exit(1);
+	}
+
+	double prev_mean = 0;
+	int nr = 0;
+	int complete = 0;
+
+	if (ctx->resume) {
+		struct checkpoint_s cp;
+		size_t len;
+		const struct signatures_progress_s *p = NULL;
+		if (checkpoint_resume_load(ctx, &cp, CHECKPOINT_SIGNATURES) == 0) {
+			p = (const struct signatures_progress_s *)checkpoint_get(&cp, CKPT_SIGNATURES + inputnr, &len);
+		}
+		if (p && p->count >= 0 && p->count <= frame_count &&
+			len == sizeof(*p) + (p->count * (sizeof(float) + sizeof(uint64_t)))) {
+			nr = p->count;
+			complete = p->complete;
+			prev_mean = p->prev_mean;
+			memcpy(slist, (const uint8_t *)p + sizeof(*p), nr * sizeof(float));
+			memcpy(hlist, (const uint8_t *)p + sizeof(*p) + (nr * sizeof(float)), nr * sizeof(uint64_t));
+			fseeko(fh, (off_t)nr * frame_size, SEEK_SET);
+			printf("# checkpoint: resumed input %d at frame %08d%s\n", inputnr, nr, complete ? ", complete" : "");
+		}
+		checkpoint_free(&cp);
+	}
+
+	while (nr < frame_count && !complete) {
+		if (ctx->ckpt_interval && nr && (nr % ctx->ckpt_interval) == 0) {
+			checkpoint_signatures(ctx, inputnr, slist, hlist, nr, 0, prev_mean);
+		}
+
+		if (fread(b1, 1, frame_size, fh) != (size_t)frame_size) {
+			break;
+		}
+
+		Mat y1 = Mat(ctx->height, ctx->width, CV_8UC1, b1);
+		double mean = 0;
+		hlist[nr] = computeDCTHash(ctx, y1, &mean);
+		slist[nr] = nr ? mean - prev_mean : 0.0;
+		prev_mean = mean;
+
+		if (ctx->verbose > 1) {
+			printf("frame %08d, hash %" PRIx64 ", mean %7.2f, %s\n", nr, hlist[nr], mean, ctx->fn[inputnr]);
+		}
+		nr++;
+	}
+
+	arena_buffer_free(b1);
+	fclose(fh);
+
+	*sig = slist;
+	*hashes = hlist;
+	*count = nr;
+
+	ctx->sigs[inputnr] = slist;
+	ctx->hashes[inputnr] = hlist;
+	ctx->hash_count[inputnr] = nr;
+	if (ctx->ckpt_interval && !complete) {
+		checkpoint_signatures(ctx, inputnr, slist, hlist, nr, 1, prev_mean);
+	}
+
+	return 0; /* Success */
+}
+
+/* Longest run of matching hashes along the diagonal b[i + lag] == a[i] */
+static int diagonal_longest_match(uint64_t *a, int na, uint64_t *b, int nb, int lag, int *posA, int *posB, int *total)
+{
+	int maxLen = 0, currentLen = 0;
+
+	*total = 0;
+	for (int i = 0; i < na; i++) {
+		int j = i + lag;
+		if (j < 0 || j >= nb) {
+			continue;
+		}
+		if (hamming_distance(a[i], b[j]) <= 2) {
+			(*total)++;
+			if (++currentLen > maxLen) {
+				maxLen = currentLen;
+				*posA = i - currentLen + 1;
+				*posB = j - currentLen + 1;
+			}
+		} else {
+			currentLen = 0;
+		}
+	}
+
+	return maxLen;
+}
+
+/* Long range alignment. Signatures for both complete files are cross correlated
+ * with an FFT to find candidate global offsets of any size, then each candidate
+ * is verified locally against the frame hashes.
+ */
+int compute_sequence_xcorr(struct tool_context_s *ctx)
+{
+	float *sig[MAX_INPUTS] = { 0 };
+	int count[MAX_INPUTS] = { 0 };
+
+	for (int i = 0; i < MAX_INPUTS; i++) {
+		if (ctx->fn[i] == NULL) {
+			fprintf(stderr, "xcorr mode needs two input files, aborting\n");
+			exit(1);
+		}
+		compute_sequence_signatures_input(ctx, i, &sig[i], &ctx->hashes[i], &count[i]);
+		ctx->hash_count[i] = count[i];
+	}
+	checkpoint_done(ctx);
+
+	/* Insist on a reasonable overlap, tiny overlaps correlate by chance */
+	int min_overlap = ctx->windowsize;
+	if (min_overlap > count[0] / 4) {
+		min_overlap = count[0] / 4;
+	}
+	if (min_overlap > count[1] / 4) {
+		min_overlap = count[1] / 4;
+	}
+	if (min_overlap < 2) {
+		min_overlap = 2;
+	}
+
+	struct xcorr_peak_s peaks[XCORR_MAX_PEAKS];
+	int found = xcorr_find_peaks(sig[0], count[0], sig[1], count[1], min_overlap, peaks, XCORR_MAX_PEAKS);
+
+	int best = -1, best_matches = 0, posA = 0, posB = 0;
+	for (int i = 0; i < found; i++) {
+		int pa = 0, pb = 0, total;
+		int matches = diagonal_longest_match(ctx->hashes[0], count[0], ctx->hashes[1], count[1], peaks[i].lag, &pa, &pb, &total);
+
+		printf("# xcorr candidate offset %+8d frames, correlation %6.3f, hash matches %d, longest run %d\n",
+			peaks[i].lag, peaks[i].score, total, matches);
+
+		if (matches > best_matches) {
+			best = i;
+			best_matches = matches;
+			posA = pa;
+			posB = pb;
+		}
+	}
+
+	if (best >= 0 && peaks[best].lag >= 0) {
+		printf("# xcorr offset: %+d frames, file2 frame %d lines up with file1 frame 0\n", peaks[best].lag, peaks[best].lag);
+	} else if (best >= 0) {
+		printf("# xcorr offset: %+d frames, file1 frame %d lines up with file2 frame 0\n", peaks[best].lag, -peaks[best].lag);
+	} else {
+		printf("# xcorr offset: not found\n");
+	}
+	printf("# hash sequence matches: %d\n", best_matches);
+	print_trimming_instructions(ctx, best_matches, posA, posB);
+
+	for (int i = 0; i < MAX_INPUTS; i++) {
+		free(sig[i]);
+		free(ctx->hashes[i]);
+		ctx->hashes[i] = NULL;
+		ctx->sigs[i] = NULL;
+	}
+
+	return 0;
+}
+
+/* Drift tolerant alignment. Hash both complete files, seed the band offset
+ * from the -D style longest match over the first window, then run the banded
+ * DP to map every file1 frame to a file2 frame, reporting drops and dups.
+ */
+int compute_sequence_drift(struct tool_context_s *ctx)
+{
+	float *sig[MAX_INPUTS] = { 0 };
+	int count[MAX_INPUTS] = { 0 };
+
+	for (int i = 0; i < MAX_INPUTS; i++) {
+		if (ctx->fn[i] == NULL) {
+			fprintf(stderr, "drift mode needs two input files, aborting\n");
+			exit(1);
+		}
+		compute_sequence_signatures_input(ctx, i, &sig[i], &ctx->hashes[i], &count[i]);
+		ctx->hash_count[i] = count[i];
+	}
+	checkpoint_done(ctx);
+	for (int i = 0; i < MAX_INPUTS; i++) {
+		free(sig[i]);
+		ctx->sigs[i] = NULL;
+	}
+
+	int offset = 0;
+	int posA, posB;
+	int len = ctx->windowsize;
+	if (len > count[0]) {
+		len = count[0];
+	}
+	if (len > count[1]) {
+		len = count[1];
+	}
+	if (findLongestMatch(ctx->hashes[0], len, ctx->hashes[1], len, &posA, &posB, 0) > 0) {
+		offset = posB - posA;
+	}
+	printf("# drift initial offset: %+d frames, band +/- %d frames\n", offset, ctx->windowsize);
+
+	struct drift_step_s *path = NULL;
+	int steps = 0;
+	if (drift_align(ctx->hashes[0], count[0], ctx->hashes[1], count[1], offset, ctx->windowsize, &path, &steps) < 0) {
+		printf("# drift: no alignment found\n");
+	} else {
+		int events[3] = { 0 };
+		for (int i = 0; i < steps; i++) {
+			events[path[i].event]++;
+			if (path[i].event != DRIFT_MATCH) {
+				printf("# drift event: file1 frame %08d, file2 frame %08d, %s\n",
+					path[i].a, path[i].b, drift_event_name(path[i].event));
+			}
+		}
+		printf("# drift: file1 frames %08d-%08d, file2 frames %08d-%08d, %d drops, %d dups\n",
+			path[0].a, path[steps - 1].a, path[0].b, path[steps - 1].b,
+			events[DRIFT_DROP], events[DRIFT_DUP]);
+
+		FILE *fh = strcmp(ctx->mapoutfn, "-") == 0 ? stdout : fopen(ctx->mapoutfn, "wb");
+		if (!fh || drift_map_write(fh, path, steps) < 0) {
+			fprintf(stderr, "unable to write frame map %s, aborting\n", ctx->mapoutfn);
+			exit(1);
+		}
+		if (fh != stdout) {
+			fclose(fh);
+		}
+		printf("# frame map: %s, use with -U in mse mode\n", ctx->mapoutfn);
+	}
+
+	free(path);
+	for (int i = 0; i < MAX_INPUTS; i++) {
+		free(ctx->hashes[i]);
+		ctx->hashes[i] = NULL;
+	}
+
+	return 0;
+}
+
+int segment_output_open(struct tool_context_s *ctx)
+{
+	if (strcmp(ctx->segfn, "-") == 0) {
+		ctx->segfh = stdout;
+	} else {
+		ctx->segfh = fopen(ctx->segfn, "wb");
+		if (!ctx->segfh) {
+			fprintf(stderr, "unable to create segment file %s, aborting\n", ctx->segfn);
+			exit(1);
+		}
+	}
+	segment_print_header(ctx->segfh);
+
+	return 0; /* Success */
+}
+
+void segment_output_close(struct tool_context_s *ctx)
+{
+	if (ctx->segfh && ctx->segfh != stdout) {
+		fclose(ctx->segfh);
+	}
+	ctx->segfh = NULL;
+}
+
+/* Consecutive frame luma mse, used to confirm freeze frames. */
+double segment_prev_mse(struct tool_context_s *ctx, unsigned char *prev, unsigned char *cur, int nr)
+{
+	if (nr == 0) {
+		return -1.0;
+	}
+	Mat y0 = Mat(ctx->height, ctx->width, CV_8UC1, prev);
+	Mat y1 = Mat(ctx->height, ctx->width, CV_8UC1, cur);
+	return compute_luma_mse(y0, y1);
+}
+
+/* Single streaming pass over file 1, hash every frame and
+ * write out shot, black and freeze segments.
+ */
+int compute_sequence_segments(struct tool_context_s *ctx)
+{
+	FILE *fh1 = fopen(ctx->fn[0], "rb");
+	if (!fh1) {
+		fprintf(stderr, "input file 1 not found, aborting\n");
+		exit(1);
+	}
+
+	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+	int luma_size = ctx->width * ctx->height;
+
+	unsigned char *b1 = (unsigned char *)arena_buffer_alloc(frame_size);
+	unsigned char *prev = (unsigned char *)arena_buffer_alloc(luma_size);
+	if (b1 == NULL || prev == NULL) {
+		fprintf(stderr, "unable to allocate memory for frame, aborting\n");
+		exit(1);
+	}
+
+	segment_output_open(ctx);
+
+	struct segmenter_s seg;
+	segmenter_init(&seg, ctx->cut_threshold);
+
+	struct segment_s done;
+	int counts[3] = { 0 };
+
+	int nr = 0;
+	while (1) {
+		size_t l1 = fread(b1, 1, frame_size, fh1);
+		if (l1 != (size_t)frame_size) {
+			break;
+		}
+
+		struct frame_stats_s stats;
+		compute_frame_stats_cached(ctx, b1, NULL, &stats);
+
+		double prev_mse = segment_prev_mse(ctx, prev, b1, nr);
+
+		if (segmenter_push(&seg, nr, stats.hash[0], stats.luma_mean[0], prev_mse, &done)) {
+			segment_print(ctx->segfh, &done);
+			counts[done.type]++;
+		}
+
+		if (ctx->verbose) {
+			printf("frame %08d, hash %" PRIx64 ", luma %6.2f, prev mse %8.2f\n",
+				nr, stats.hash[0], stats.luma_mean[0], prev_mse);
+		}
+
+		memcpy(prev, b1, luma_size);
+		nr++;
+	}
+
+	if (segmenter_flush(&seg, &done)) {
+		segment_print(ctx->segfh, &done);
+		counts[done.type]++;
+	}
+
+	printf("# segments: %d shot, %d black, %d freeze, over %d frames\n",
+		counts[SEGMENT_SHOT], counts[SEGMENT_BLACK], counts[SEGMENT_FREEZE], nr);
+
+	segment_output_close(ctx);
+	stats_cache_close(ctx);
+
+	arena_buffer_free(prev);
+	arena_buffer_free(b1);
+	fclose(fh1);
+
+	return 0;
+}
+
+void segment_aggregate_print(struct stats_aggregate_s *agg, const struct segment_s *seg)
+{
+	char label[96];
+	sprintf(label, "Segment %d, frames %08d-%08d, %s", seg->nr, seg->start, seg->end, segment_type_name(seg->type));
+	stats_aggregate_print(agg, stdout, label);
+}
+
+/* Find the spatial offset of file 2 against file 1, once, on the first frame pair
+ * with usable (non black) content. Both files are rewound afterwards.
+ */
+#define SHIFT_PROBE_FRAMES 100
+int detect_spatial_offset(struct tool_context_s *ctx, FILE *fh1, FILE *fh2, unsigned char *b1, unsigned char *b2)
+{
+	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+	int luma_size = ctx->width * ctx->height;
+	int ret = -1;
+
+	for (int nr = 0; nr < SHIFT_PROBE_FRAMES; nr++) {
+		if (fread(b1, 1, frame_size, fh1) != (size_t)frame_size || fread(b2, 1, frame_size, fh2) != (size_t)frame_size) {
+			break;
+		}
+
+		uint64_t sum = 0;
+		for (int i = 0; i < luma_size; i++) {
+			sum += b1[i];
+		}
+		if ((double)sum / luma_size < SEGMENT_BLACK_LUMA) {
+			continue;
+		}
+
+		ret = align_spatial_search(b1, b2, ctx->width, ctx->height, ctx->shift_range, &ctx->shift, ctx->verbose);
+		if (ret == 0) {
+			ctx->shift_valid = 1;
+			printf("# spatial offset: dx %d, dy %d, mean sad %.2f, detected on frame %08d\n",
+				ctx->shift.dx, ctx->shift.dy, ctx->shift.sad, nr);
+		}
+		break;
+	}
+
+	if (ret < 0) {
+		printf("# spatial offset: not detected, comparing unshifted frames\n");
+	}
+
+	rewind(fh1);
+	rewind(fh2);
+
+	return ret;
+}
+
+/* Where an mse pass got to, everything else it needs is in the other sections */
+struct mse_progress_s
+{
+	int32_t nr;             /* Next file1 frame */
+	int32_t frames;         /* Frame pairs compared */
+	int32_t line;
+	int32_t map_idx;
+	int32_t map_last;
+	int32_t prev_nr;        /* File1 frame held as the segmenter's previous frame, -1 for none */
+	int32_t shift_valid;
+	int32_t reserved;
+	struct spatial_offset_s shift;
+	int64_t grid_length;    /* Sidecar lengths, cut back to these on resume */
+	int64_t metrics_frames; /* Frames in the -m metrics file, the rest are written again */
+	int64_t seg_length;
+};
+
+static int64_t output_length(FILE *fh)
+{
+	if (fh == NULL || fh == stdout) {
+		return 0;
+	}
+	fflush(fh);
+	return ftello(fh);
+}
+
+static void checkpoint_mse(struct tool_context_s *ctx, struct mse_progress_s *p, const struct stats_aggregate_s *agg,
+	const struct stats_aggregate_s *shot, const struct segmenter_s *seg, const struct stats_window_s *win,
+	FILE *gridfh, const struct metrics_writer_s *metrics)
+{
+	p->grid_length = output_length(gridfh);
+	p->metrics_frames = metrics ? metrics->frames : 0;
+	p->seg_length = output_length(ctx->segfh);
+	fflush(stdout);
+
+	struct checkpoint_header_s hdr;
+	struct checkpoint_s cp;
+	checkpoint_identify(&hdr, CHECKPOINT_MSE, ctx->width, ctx->height, ctx->fn);
+	if (checkpoint_begin(&cp, ctx->ckptfn, &hdr) < 0) {
+		checkpoint_failed(ctx);
+		return;
+	}
+
+	int ret = checkpoint_put(&cp, CKPT_MSE_PROGRESS, p, sizeof(*p));
+	ret |= checkpoint_put(&cp, CKPT_MSE_AGGREGATE, agg, sizeof(*agg));
+	if (shot) {
+		ret |= checkpoint_put(&cp, CKPT_MSE_SHOT, shot, sizeof(*shot));
+		ret |= checkpoint_put(&cp, CKPT_MSE_SEGMENTER, seg, sizeof(*seg));
+	}
+	if (win->size) {
+		/* The ring, then its three arrays */
+		size_t len = sizeof(*win) + (3 * win->size * sizeof(double));
+		uint8_t *buf = (uint8_t *)malloc(len);
+		if (buf) {
+			memcpy(buf, win, sizeof(*win));
+			for (int i = 0; i < 3; i++) {
+				memcpy(buf + sizeof(*win) + (i * win->size * sizeof(double)), win->sse[i], win->size * sizeof(double));
+			}
+			ret |= checkpoint_put(&cp, CKPT_MSE_WINDOW, buf, len);
+			free(buf);
+		} else {
+			ret = -1;
+		}
+	}
+	if (ctx->grid) {
+		/* Frame count, then the summed block SSE */
+		size_t cells = ctx->grid->cols * ctx->grid->rows;
+		uint8_t *buf = (uint8_t *)malloc((cells + 1) * sizeof(uint64_t));
+		if (buf) {
+			memcpy(buf, &ctx->grid->frames, sizeof(uint64_t));
+			memcpy(buf + sizeof(uint64_t), ctx->grid->total, cells * sizeof(uint64_t));
+			ret |= checkpoint_put(&cp, CKPT_MSE_GRID, buf, (cells + 1) * sizeof(uint64_t));
+			free(buf);
+		} else {
+			ret = -1;
+		}
+	}
+
+	if (ret < 0 || checkpoint_commit(&cp) < 0) {
+		checkpoint_free(&cp);
+		checkpoint_failed(ctx);
+		return;
+	}
+
+	if (ctx->verbose) {
+		printf("# checkpoint: frame %08d, %d frames compared\n", p->nr, p->frames);
+	}
+}
+
+/* Copy a section back over a fixed size structure, -1 if it's missing or the wrong size */
+static int checkpoint_restore(const struct checkpoint_s *cp, uint32_t tag, void *dst, size_t length)
+{
+	size_t len;
+	const void *src = checkpoint_get(cp, tag, &len);
+	if (src == NULL || len != length) {
+		return -1;
+	}
+	memcpy(dst, src, length);
+
+	return 0; /* Success */
+}
+
+int compute_sequence_mse(struct tool_context_s *ctx)
+{
+	FILE *fh1 = fopen(ctx->fn[0], "rb");
+	if (!fh1) {
+		fprintf(stderr, "input file 1 not found, aborting\n");
+		exit(1);
+	}
+
+	FILE *fh2 = fopen(ctx->fn[1], "rb");
+	if (!fh2) {
+		fprintf(stderr, "input file 2 not found, aborting\n");
+		exit(1);
+	}
+
+	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+
+	/* Check the files are a perfect multiple of frame_size */
+	struct stat s1, s2;
+	if (stat(ctx->fn[0], &s1) < 0) {
+		fprintf(stderr, "file input 1 not found, aborting\n");
+		exit(1);
+	}
+	if (stat(ctx->fn[1], &s2) < 0) {
+		fprintf(stderr, "file input 2 not found, aborting\n");
+		exit(1);
+	}
+	if (s1.st_size != s2.st_size && ctx->mapinfn == NULL) {
+		fprintf(stderr, "file input 1 isn't the same size as input 2, aborting\n");
+		exit(1);
+	}
+	if (s1.st_size % frame_size) {
+		fprintf(stderr, "file input 1 isn't a perfect multiple of frame_size %d\n", frame_size);
+		exit(1);
+	}
+
+	unsigned char *b1 = (unsigned char *)arena_buffer_alloc(frame_size);
+	unsigned char *b2 = (unsigned char *)arena_buffer_alloc(frame_size);
+	if (b1 == NULL || b2 == NULL) {
+		fprintf(stderr, "unable to allocate memory for frame, aborting\n");
+		exit(1);
+	}
+
+	/* --resume, the progress section drives everything that follows */
+	struct checkpoint_s cp;
+	struct mse_progress_s progress;
+	int resumed = 0;
+	memset(&cp, 0, sizeof(cp));
+	memset(&progress, 0, sizeof(progress));
+	progress.prev_nr = -1;
+	if (ctx->resume && checkpoint_resume_load(ctx, &cp, CHECKPOINT_MSE) == 0) {
+		resumed = checkpoint_restore(&cp, CKPT_MSE_PROGRESS, &progress, sizeof(progress)) == 0;
+	}
+
+	if (resumed) {
+		ctx->shift_valid = progress.shift_valid;
+		ctx->shift = progress.shift;
+	} else if (ctx->shift_range > 0) {
+		detect_spatial_offset(ctx, fh1, fh2, b1, b2);
+	}
+
+	struct stats_aggregate_s *agg = (struct stats_aggregate_s *)malloc(sizeof(*agg));
+	if (agg == NULL) {
+		fprintf(stderr, "unable to allocate memory for aggregates, aborting\n");
+		exit(1);
+	}
+	stats_aggregate_init(agg, ctx->width, ctx->height);
+
+	struct stats_window_s win;
+	memset(&win, 0, sizeof(win));
+	if (ctx->window > 0 && stats_window_alloc(&win, ctx->window, ctx->width, ctx->height) < 0) {
+		fprintf(stderr, "unable to allocate memory for aggregate window, aborting\n");
+		exit(1);
+	}
+
+	/* Per block SSE grid, filled in by the mse kernel itself */
+	struct block_grid_s grid;
+	FILE *gridfh = NULL;
+	if (ctx->block_size) {
+		/* In preview the kernel sees the level's geometry */
+		if (blockmse_grid_alloc(&grid, ctx->width >> ctx->preview, ctx->height >> ctx->preview, ctx->block_size) < 0) {
+			fprintf(stderr, "invalid block size %d or unable to allocate grid, aborting\n", ctx->block_size);
+			exit(1);
+		}
+		if (ctx->gridfn && resumed && progress.grid_length) {
+			gridfh = checkpoint_reopen(ctx->gridfn, progress.grid_length);
+			if (!gridfh) {
+				fprintf(stderr, "unable to resume block grid file %s, aborting\n", ctx->gridfn);
+				exit(1);
+			}
+		} else if (ctx->gridfn) {
+			gridfh = fopen(ctx->gridfn, "wb");
+			if (!gridfh || blockmse_write_header(gridfh, &grid) < 0) {
+				fprintf(stderr, "unable to create block grid file %s, aborting\n", ctx->gridfn);
+				exit(1);
+			}
+		}
+		ctx->grid = &grid;
+	}
+
+	/* Per shot aggregates, segmenting the reference (file 1) */
+	struct segmenter_s seg;
+	struct segment_s done;
+	struct stats_aggregate_s *shot = NULL;
+	unsigned char *prev = NULL;
+	if (ctx->segfn) {
+		shot = (struct stats_aggregate_s *)malloc(sizeof(*shot));
+		prev = (unsigned char *)arena_buffer_alloc(ctx->width * ctx->height);
+		if (shot == NULL || prev == NULL) {
+			fprintf(stderr, "unable to allocate memory for segments, aborting\n");
+			exit(1);
+		}
+		stats_aggregate_init(shot, ctx->width, ctx->height);
+		segmenter_init(&seg, ctx->cut_threshold);
+		if (resumed && progress.seg_length && strcmp(ctx->segfn, "-") != 0) {
+			ctx->segfh = checkpoint_reopen(ctx->segfn, progress.seg_length);
+			if (!ctx->segfh) {
+				fprintf(stderr, "unable to resume segment file %s, aborting\n", ctx->segfn);
+				exit(1);
+			}
+		} else {
+			segment_output_open(ctx);
+		}
+	}
+
+	/* A drift map from -R pairs up the frames, skipping dropped and duplicated ones */
+	struct drift_step_s *map = NULL;
+	int map_count = 0, map_idx = 0, map_last = -1;
+	if (ctx->mapinfn) {
+		if (drift_map_read(ctx->mapinfn, &map, &map_count) < 0) {
+			fprintf(stderr, "unable to read frame map %s, aborting\n", ctx->mapinfn);
+			exit(1);
+		}
+		printf("# frame map: %s, %d entries\n", ctx->mapinfn, map_count);
+	}
+
+	/* Per frame metrics for picvmaf, VMAF merged in by frame number */
+	struct metrics_writer_s metricsw, *metrics = NULL;
+	float *vmaf = NULL;
+	int vmaf_count = 0;
+	if (ctx->metricsfn) {
+		if (ctx->vmaffn && metrics_load_vmaf(ctx->vmaffn, &vmaf, &vmaf_count) < 0) {
+			fprintf(stderr, "unable to read vmaf scores %s, aborting\n", ctx->vmaffn);
+			exit(1);
+		}
+		/* Columns sized for every file 1 frame, trimmed to the frames compared on close */
+		if (metrics_writer_open(&metricsw, ctx->metricsfn, s1.st_size / frame_size,
+			resumed && progress.metrics_frames ? progress.metrics_frames : -1) < 0) {
+			fprintf(stderr, "unable to create metrics file %s, aborting\n", ctx->metricsfn);
+			exit(1);
+		}
+		metrics = &metricsw;
+	}
+
+	int nr = 0;
+	int frames = 0;
+	int prev_nr = -1;
+
+	int line = 0;
+
+	if (resumed) {
+		if (checkpoint_restore(&cp, CKPT_MSE_AGGREGATE, agg, sizeof(*agg)) < 0 ||
+			(shot && (checkpoint_restore(&cp, CKPT_MSE_SHOT, shot, sizeof(*shot)) < 0 ||
+				checkpoint_restore(&cp, CKPT_MSE_SEGMENTER, &seg, sizeof(seg)) < 0))) {
+			fprintf(stderr, "checkpoint %s doesn't match these options, aborting\n", ctx->ckptfn);
+			exit(1);
+		}
+
+		if (win.size) {
+			size_t len;
+			const uint8_t *p = (const uint8_t *)checkpoint_get(&cp, CKPT_MSE_WINDOW, &len);
+			const struct stats_window_s *w = (const struct stats_window_s *)p;
+			if (p == NULL || len != sizeof(win) + (3 * win.size * sizeof(double)) || w->size != win.size) {
+				fprintf(stderr, "checkpoint %s doesn't match window -a %d, aborting\n", ctx->ckptfn, ctx->window);
+				exit(1);
+			}
+			win.count = w->count;
+			win.pos = w->pos;
+			for (int i = 0; i < 3; i++) {
+				win.sum[i] = w->sum[i];
+				memcpy(win.sse[i], p + sizeof(win) + (i * win.size * sizeof(double)), win.size * sizeof(double));
+			}
+		}
+
+		if (ctx->grid) {
+			size_t len, cells = ctx->grid->cols * ctx->grid->rows;
+			const uint8_t *p = (const uint8_t *)checkpoint_get(&cp, CKPT_MSE_GRID, &len);
+			if (p == NULL || len != (cells + 1) * sizeof(uint64_t)) {
+				fprintf(stderr, "checkpoint %s doesn't match block size -B %d, aborting\n", ctx->ckptfn, ctx->block_size);
+				exit(1);
+			}
+			memcpy(&ctx->grid->frames, p, sizeof(uint64_t));
+			memcpy(ctx->grid->total, p + sizeof(uint64_t), cells * sizeof(uint64_t));
+		}
+
+		nr = progress.nr;
+		frames = progress.frames;
+		line = progress.line;
+		map_idx = progress.map_idx;
+		map_last = progress.map_last;
+
+		/* The segmenter compares against the previous file1 frame, read it back */
+		if (shot && progress.prev_nr >= 0) {
+			if (fseeko(fh1, (off_t)progress.prev_nr * frame_size, SEEK_SET) < 0 ||
+				fread(prev, 1, ctx->width * ctx->height, fh1) != (size_t)(ctx->width * ctx->height)) {
+				fprintf(stderr, "unable to resume at frame %08d, aborting\n", progress.prev_nr);
+				exit(1);
+			}
+			prev_nr = progress.prev_nr;
+		}
+
+		printf("# checkpoint: resumed at frame %08d, %d frames compared\n", nr, frames);
+	}
+	checkpoint_free(&cp);
+	int resumed_frames = frames;
+
+	/* The probe and resume reads above used b1/b2, from here frames come from the read ahead */
+	arena_buffer_free(b1);
+	arena_buffer_free(b2);
+	struct framereader_s *r1 = framereader_open(ctx->fn[0], frame_size, ctx->io_depth, ctx->io_engine, ctx->io_direct);
+	struct framereader_s *r2 = framereader_open(ctx->fn[1], frame_size, ctx->io_depth, ctx->io_engine, ctx->io_direct);
+	if (r1 == NULL || r2 == NULL) {
+		fprintf(stderr, "unable to open the inputs for reading, aborting\n");
+		exit(1);
+	}
+	printf("# read ahead: %s, depth %d%s\n", framereader_engine_name(r1), ctx->io_depth,
+		framereader_direct(r1) ? ", O_DIRECT" : "");
+
+	while(1) {
+		if (ctx->ckpt_interval && frames != resumed_frames && (frames % ctx->ckpt_interval) == 0) {
+			progress.nr = nr;
+			progress.frames = frames;
+			progress.line = line;
+			progress.map_idx = map_idx;
+			progress.map_last = map_last;
+			progress.prev_nr = prev_nr;
+			progress.shift_valid = ctx->shift_valid;
+			progress.shift = ctx->shift;
+			checkpoint_mse(ctx, &progress, agg, shot, &seg, &win, gridfh, metrics);
+			resumed_frames = frames;
+		}
+
+		int nr2 = nr;
+		if (map) {
+			/* One comparison per file1 frame, the first file2 frame it maps to */
+			while (map_idx < map_count && map[map_idx].a == map_last) {
+				map_idx++;
+			}
+			if (map_idx == map_count) {
+				break;
+			}
+			nr = map_last = map[map_idx].a;
+			nr2 = map[map_idx].b;
+			if (ctx->verbose) {
+				printf("# map file1 frame %08d -> file2 frame %08d, %s\n",
+					map[map_idx].a, map[map_idx].b, drift_event_name(map[map_idx].event));
+			}
+		}
+
+		b1 = framereader_read(r1, nr);
+		b2 = framereader_read(r2, nr2);
+		if (b1 == NULL || b2 == NULL) {
+			break;
+		}
+
+		struct frame_stats_s stats;
+		if (ctx->grid) {
+			blockmse_grid_begin_frame(ctx->grid);
+		}
+		compute_frame_stats_cached(ctx, b1, b2, &stats);
+		if (ctx->grid) {
+			blockmse_grid_end_frame(ctx->grid);
+			if (gridfh && blockmse_write_frame(gridfh, ctx->grid, nr) < 0) {
+				fprintf(stderr, "unable to write block grid file %s, aborting\n", ctx->gridfn);
+				exit(1);
+			}
+		}
+
+		int hd = hamming_distance(stats.hash[0], stats.hash[1]);
+
+		if (metrics) {
+			struct metrics_frame_s m;
+			m.frame_nr = nr;
+			m.value[METRICS_VMAF] = nr < vmaf_count ? vmaf[nr] : NAN;
+			m.value[METRICS_PSNR_Y] = stats.y_psnr;
+			m.value[METRICS_MSE_Y] = stats.y_mse;
+			m.value[METRICS_SHARPNESS] = stats.sharpness[1];
+			m.hash[0] = stats.hash[0];
+			m.hash[1] = stats.hash[1];
+			if (metrics_writer_append(metrics, &m) < 0) {
+				fprintf(stderr, "unable to write metrics file %s, aborting\n", ctx->metricsfn);
+				exit(1);
+			}
+		}
+
+		double mse[3] = { stats.y_mse, stats.u_mse, stats.v_mse };
+		double psnr[3] = { stats.y_psnr, stats.u_psnr, stats.v_psnr };
+		stats_aggregate_add(agg, mse, psnr, stats.sharpness, hd);
+
+		if (shot) {
+			double prev_mse = segment_prev_mse(ctx, prev, b1, nr);
+			if (segmenter_push(&seg, nr, stats.hash[0], stats.luma_mean[0], prev_mse, &done)) {
+				segment_print(ctx->segfh, &done);
+				segment_aggregate_print(shot, &done);
+				stats_aggregate_init(shot, ctx->width, ctx->height);
+			}
+			stats_aggregate_add(shot, mse, psnr, stats.sharpness, hd);
+			memcpy(prev, b1, ctx->width * ctx->height);
+			prev_nr = nr;
+		}
+		frames++;
+
+		if (ctx->window > 0) {
+			stats_window_add(&win, mse);
+			if (stats_window_full(&win)) {
+				printf("# window %08d-%08d, mse Y %8.2f, U %8.2f, V %8.2f, psnr(dB) Y %8.2f, U %8.2f, V %8.2f\n",
+					nr - ctx->window + 1, nr,
+					stats_window_mse(&win, 0), stats_window_mse(&win, 1), stats_window_mse(&win, 2),
+					stats_window_psnr(&win, 0), stats_window_psnr(&win, 1), stats_window_psnr(&win, 2));
+			}
+		}
+
+		if (ctx->quiet) {
+			nr++;
+			continue;
+		}
+
+		if (line == 0) {
+			printf("%8s %9s %9s %9s %9s %9s %9s %9s %27s %17s %8s %21s", "#  Frame", "MSE", "", "", "PSNR", "", "", "Sharp", "DCT Hash", "", "Hamming", "Hash");
+			printf("\n");
+			printf("%8s %9s %9s %9s %9s %9s %9s %9s %9s", "#     Nr", "Y", "U", "V", "Y", "U", "V", "f1", "f2");
+			printf("%18s %17s %8s %21s", "f1", "f2", "Dist", "Assessment");
+			printf("\n");
+			printf("#------> <---------------------------> <---------------------------> <-----------------> <---------------------------------------------------------------->\n");
+		}
+
+		if (line++ > 24) {
+			line = 0;
+		}
+
+		printf("%08d, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f", nr,
+			stats.y_mse, stats.u_mse, stats.v_mse,
+			stats.y_psnr, stats.u_psnr, stats.v_psnr);
+
+		printf(", %8.2f, %8.2f, %" PRIx64 ", %" PRIx64 ", %7d, %20s",
+			stats.sharpness[0], stats.sharpness[1], stats.hash[0], stats.hash[1],
+			hd,
+			hd == 0 ? "Exact Match" :
+			hd <= 10 ? "Near Identical" : "Different");
+
+		printf("\n");
+
+		nr++;
+	}
+
+	if (shot) {
+		if (segmenter_flush(&seg, &done)) {
+			segment_print(ctx->segfh, &done);
+			segment_aggregate_print(shot, &done);
+		}
+		segment_output_close(ctx);
+		free(shot);
+		arena_buffer_free(prev);
+	}
+
+	free(map);
+	checkpoint_done(ctx);
+
+	if (metrics) {
+		uint32_t written = metrics->frames;
+		if (metrics_writer_close(metrics) < 0) {
+			fprintf(stderr, "unable to write metrics file %s, aborting\n", ctx->metricsfn);
+			exit(1);
+		}
+		printf("# metrics: %s, %u frames\n", ctx->metricsfn, written);
+	}
+	free(vmaf);
+
+	char label[96];
+	stats_cache_close(ctx);
+	stats_aggregate_print(agg, stdout, preview_label(ctx, "Aggregates", label, sizeof(label)));
+
+	if (ctx->grid) {
+		if (gridfh) {
+			fclose(gridfh);
+		}
+		if (ctx->heatmapfn) {
+			if (blockmse_write_heatmap(ctx->grid, ctx->heatmapfn) < 0) {
+				fprintf(stderr, "unable to write heatmap %s\n", ctx->heatmapfn);
+			} else {
+				printf("# heatmap: %s\n", ctx->heatmapfn);
+			}
+		}
+		blockmse_grid_free(ctx->grid);
+		ctx->grid = NULL;
+	}
+
+	stats_window_free(&win);
+	free(agg);
+	framereader_close(r1);
+	framereader_close(r2);
+	fclose(fh1);
+	fclose(fh2);
+
+	return 0;
+}
+
+/* splitmix64, a repeatable sample for a given seed */
+static uint64_t sample_random(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* Frame numbers of a sample of total frames, ascending. Every Nth frame from a
+ * random start in the first interval, or one random frame from each of count
+ * equal strata. NULL when out of memory.
+ */
+static int64_t *sample_plan(int every, int count, uint64_t seed, int64_t total, int64_t *planned)
+{
+	int64_t *plan;
+	int64_t n;
+
+	if (every > 0) {
+		int64_t start = sample_random(&seed) % (every < total ? every : total);
+		n = (total - start + every - 1) / every;
+		plan = (int64_t *)malloc(n * sizeof(int64_t));
+		for (int64_t i = 0; plan && i < n; i++) {
+			plan[i] = start + (i * every);
+		}
+	} else {
+		n = count < total ? count : total;
+		plan = (int64_t *)malloc(n * sizeof(int64_t));
+		for (int64_t i = 0; plan && i < n; i++) {
+			int64_t lo = (i * total) / n;
+			int64_t hi = ((i + 1) * total) / n;
+			plan[i] = lo + (int64_t)(sample_random(&seed) % (hi - lo));
+		}
+	}
+
+	*planned = n;
+	return plan;
+}
+
+/* Estimates from sampled frames, see compute_sequence_sample() */
+static void sample_summary_print(FILE *fh, const struct stats_aggregate_s *agg, uint64_t sampled, int64_t total,
+	double threshold, uint64_t flagged)
+{
+	static const char *planes[] = { "Y", "U", "V" };
+	const double max_pixel_value = 255.0;
+
+	fprintf(fh, "# Sampled estimate: %" PRIu64 " of %" PRId64 " frames (%.2f%%), 95%% confidence intervals\n",
+		sampled, total, (100.0 * sampled) / total);
+	fprintf(fh, "# %5s %9s %9s | %9s %9s %9s | %9s %9s\n",
+		"Plane", "MSE mean", "+/-", "PSNR glob", "low", "high", "PSNR mean", "+/-");
+	for (int i = 0; sampled && i < 3; i++) {
+		const struct stats_plane_s *p = &agg->plane[i];
+		double hw = stats_running_ci95(&p->mse, total);
+		double lo = p->mse.mean - hw;
+
+		/* Global PSNR follows the mean MSE, its interval is the MSE interval mapped through */
+		fprintf(fh, "# %5s %9.2f %9.2f | %9.2f %9.2f %9.2f | %9.2f %9.2f\n", planes[i],
+			p->mse.mean, hw,
+			stats_psnr_from_sse(p->mse.mean * p->pixels, p->pixels, max_pixel_value),
+			stats_psnr_from_sse((p->mse.mean + hw) * p->pixels, p->pixels, max_pixel_value),
+			stats_psnr_from_sse((lo > 0.0 ? lo : 0.0) * p->pixels, p->pixels, max_pixel_value),
+			p->psnr.count ? p->psnr.mean : INFINITY,
+			p->psnr.count ? stats_running_ci95(&p->psnr, total) : 0.0);
+	}
+	if (threshold > 0 && sampled) {
+		double lo, hi;
+		stats_proportion_ci95(flagged, sampled, total, &lo, &hi);
+		fprintf(fh, "# below %.2f dB Y PSNR: %" PRIu64 " sampled frames, est. %.2f%% (%.2f%% .. %.2f%%) of the file\n",
+			threshold, flagged, (100.0 * flagged) / sampled, 100.0 * lo, 100.0 * hi);
+	}
+}
+
+/* Sampled triage. Only a subset of the frame pairs is read, at their offsets, with
+ * the read ahead following the sample. Either every Nth frame from a random start
+ * in the first interval (-n), or one random frame from each of N equal strata (-r).
+ * The aggregates are estimates of the whole file, reported with 95% intervals. The
+ * intervals treat the sample as simple random, for systematic and stratified
+ * samples of smooth content that's on the conservative side.
+ */
+int compute_sequence_sample(struct tool_context_s *ctx)
+{
+	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+
+	struct stat s1, s2;
+	if (ctx->fn[1] == NULL || stat(ctx->fn[0], &s1) < 0 || stat(ctx->fn[1], &s2) < 0) {
+		fprintf(stderr, "sampling needs two input files, aborting\n");
+		exit(1);
+	}
+	int64_t total = (s1.st_size < s2.st_size ? s1.st_size : s2.st_size) / frame_size;
+	if (total == 0) {
+		fprintf(stderr, "inputs are shorter than one frame, aborting\n");
+		exit(1);
+	}
+
+	int64_t count;
+	int64_t *plan = sample_plan(ctx->sample_every, ctx->sample_count, ctx->sample_seed, total, &count);
+	if (plan == NULL) {
+		fprintf(stderr, "unable to allocate memory for the sample, aborting\n");
+		exit(1);
+	}
+
+	if (ctx->shift_range > 0) {
+		FILE *fh1 = fopen(ctx->fn[0], "rb");
+		FILE *fh2 = fopen(ctx->fn[1], "rb");
+		unsigned char *b1 = (unsigned char *)arena_buffer_alloc(frame_size);
+		unsigned char *b2 = (unsigned char *)arena_buffer_alloc(frame_size);
+		if (!fh1 || !fh2 || b1 == NULL || b2 == NULL) {
+			fprintf(stderr, "unable to open the inputs for the offset search, aborting\n");
+			exit(1);
+		}
+		detect_spatial_offset(ctx, fh1, fh2, b1, b2);
+		arena_buffer_free(b1);
+		arena_buffer_free(b2);
+		fclose(fh1);
+		fclose(fh2);
+	}
+
+	struct framereader_s *r1 = framereader_open(ctx->fn[0], frame_size, ctx->io_depth, ctx->io_engine, ctx->io_direct);
+	struct framereader_s *r2 = framereader_open(ctx->fn[1], frame_size, ctx->io_depth, ctx->io_engine, ctx->io_direct);
+	if (r1 == NULL || r2 == NULL) {
+		fprintf(stderr, "unable to open the inputs for reading, aborting\n");
+		exit(1);
+	}
+	framereader_plan(r1, plan, count);
+	framereader_plan(r2, plan, count);
+
+	if (ctx->sample_every > 0) {
+		printf("# sample: every %d frames from frame %08" PRId64 ", %" PRId64 " of %" PRId64 " frames\n",
+			ctx->sample_every, plan[0], count, total);
+	} else {
+		printf("# sample: %" PRId64 " stratified random frames of %" PRId64 ", seed %u\n", count, total, ctx->sample_seed);
+	}
+	printf("# read ahead: %s, depth %d%s\n", framereader_engine_name(r1), ctx->io_depth,
+		framereader_direct(r1) ? ", O_DIRECT" : "");
+
+	struct stats_aggregate_s *agg = (struct stats_aggregate_s *)malloc(sizeof(*agg));
+	if (agg == NULL) {
+		fprintf(stderr, "unable to allocate memory for aggregates, aborting\n");
+		exit(1);
+	}
+	stats_aggregate_init(agg, ctx->width, ctx->height);
+
+	uint64_t sampled = 0, flagged = 0;
+	for (int64_t i = 0; i < count; i++) {
+		unsigned char *b1 = framereader_read(r1, plan[i]);
+		unsigned char *b2 = framereader_read(r2, plan[i]);
+		if (b1 == NULL || b2 == NULL) {
+			break;
+		}
+
+		struct frame_stats_s stats;
+		compute_frame_stats_cached(ctx, b1, b2, &stats);
+
+		double mse[3] = { stats.y_mse, stats.u_mse, stats.v_mse };
+		double psnr[3] = { stats.y_psnr, stats.u_psnr, stats.v_psnr };
+		stats_aggregate_add(agg, mse, psnr, stats.sharpness, hamming_distance(stats.hash[0], stats.hash[1]));
+		sampled++;
+
+		int below = ctx->sample_threshold > 0 && stats.y_psnr < ctx->sample_threshold;
+		flagged += below;
+
+		if (ctx->quiet && !below) {
+			continue;
+		}
+		if (sampled == 1) {
+			printf("%8s %9s %9s %9s %9s %9s %9s\n", "#  Frame", "MSE Y", "U", "V", "PSNR Y", "U", "V");
+		}
+		printf("%08" PRId64 ", %8.2f, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f%s\n", plan[i],
+			stats.y_mse, stats.u_mse, stats.v_mse, stats.y_psnr, stats.u_psnr, stats.v_psnr,
+			below ? ", below threshold" : "");
+	}
+
+	stats_cache_close(ctx);
+
+	sample_summary_print(stdout, agg, sampled, total, ctx->sample_threshold, flagged);
+	char label[96];
+	stats_aggregate_print(agg, stdout, preview_label(ctx, "Sampled aggregates", label, sizeof(label)));
+
+	free(agg);
+	framereader_close(r1);
+	framereader_close(r2);
+	free(plan);
+
+	return 0; /* Success */
+}
+
+/* Live tail, yuvmse --follow. Both files are still being written, each complete
+ * frame pair is measured as soon as both halves are on disk. Only the rolling
+ * window, the aggregates and the stats cache are kept, so memory stays flat
+ * however long the capture runs.
+ */
+#define FOLLOW_ALARM_HYSTERESIS 0.5    /* dB above -t before an alarm clears */
+
+static volatile sig_atomic_t follow_stop = 0;
+
+static void follow_signal_handler(int signo)
+{
+	follow_stop = 1;
+}
+
+static double follow_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+int compute_sequence_follow(struct tool_context_s *ctx)
+{
+	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
+
+	if (ctx->fn[1] == NULL) {
+		fprintf(stderr, "follow mode needs two input files, aborting\n");
 		exit(1);
 	}
 
-	FILE *fh2 = fopen(ctx->fn[1], "rb");
-	if (!fh2) {
-		fprintf(stderr, "input file 2 not found, aborting\n");
+	struct follow_s *f = follow_open(ctx->fn, MAX_INPUTS, ctx->follow_poll_ms);
+	if (f == NULL) {
+		fprintf(stderr, "unable to open the inputs to follow, aborting\n");
 		exit(1);
 	}
 
-	int frame_size = (ctx->width * ctx->height * 3) / 2; /* YUV420 */
-
-	/* Check the files are a perfect multiple of frame_size */
-	struct stat s1, s2;
-	if (stat(ctx->fn[0], &s1) < 0) {
-		fprintf(stderr, "file input 1 not found, aborting\n");
+	/* The frames only ever grow past what fstat saw, the reader rechecks the size itself */
+	struct framereader_s *r1 = framereader_open(ctx->fn[0], frame_size, ctx->io_depth, ctx->io_engine, ctx->io_direct);
+	struct framereader_s *r2 = framereader_open(ctx->fn[1], frame_size, ctx->io_depth, ctx->io_engine, ctx->io_direct);
+	if (r1 == NULL || r2 == NULL) {
+		fprintf(stderr, "unable to open the inputs for reading, aborting\n");
 		exit(1);
 	}
-	if (stat(ctx->fn[1], &s2) < 0) {
-		fprintf(stderr, "file input 2 not found, aborting\n");
+
+	int window = ctx->window > 0 ? ctx->window : FOLLOW_WINDOW_DEFAULT;
+	struct stats_window_s win;
+	memset(&win, 0, sizeof(win));
+	struct stats_aggregate_s *agg = (struct stats_aggregate_s *)malloc(sizeof(*agg));
+	if (agg == NULL || stats_window_alloc(&win, window, ctx->width, ctx->height) < 0) {
+		fprintf(stderr, "unable to allocate memory for aggregates, aborting\n");
 		exit(1);
 	}
-	if (s1.st_size != s2.st_size) {
-		fprintf(stderr, "file input 1 isn't the same size as input 2, aborting\n");
-		exit(1);
+	stats_aggregate_init(agg, ctx->width, ctx->height);
+
+	printf("# follow: file1 from frame %08d, file2 from frame %08d, %s every %d ms, window %d frames\n",
+		ctx->follow_start[0], ctx->follow_start[1], follow_method(f),
+		ctx->follow_poll_ms > 0 ? ctx->follow_poll_ms : FOLLOW_POLL_MS_DEFAULT, window);
+	printf("# read ahead: %s, depth %d%s\n", framereader_engine_name(r1), ctx->io_depth,
+		framereader_direct(r1) ? ", O_DIRECT" : "");
+	fflush(stdout);
+
+	/* No SA_RESTART, a signal cuts the wait short and the summary still goes out */
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = follow_signal_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	int64_t nr = 0, available = 0;
+	int64_t last_size[MAX_INPUTS] = { 0, 0 };
+	int alarm = 0, alarms = 0;
+	double last_frame = follow_now();
+
+	while (!follow_stop) {
+		if (nr >= available) {
+			/* Caught up, the results so far go out before waiting */
+			fflush(stdout);
+
+			int truncated = -1;
+			available = INT64_MAX;
+			for (int i = 0; i < MAX_INPUTS; i++) {
+				int64_t size = follow_size(f, i);
+				if (size < last_size[i]) {
+					truncated = i;
+				}
+				last_size[i] = size;
+				int64_t frames = (size / frame_size) - ctx->follow_start[i];
+				available = frames < available ? frames : available;
+			}
+			if (truncated >= 0) {
+				printf("# follow: file%d was truncated, capture restarted? stopping\n", truncated + 1);
+				break;
+			}
+
+			if (nr >= available) {
+				if (ctx->follow_idle > 0 && follow_now() - last_frame >= ctx->follow_idle) {
+					printf("# follow: no new frames for %d s, stopping\n", ctx->follow_idle);
+					break;
+				}
+				follow_wait(f);
+				continue;
+			}
+		}
+
+		int64_t nr1 = ctx->follow_start[0] + nr;
+		unsigned char *b1 = framereader_read(r1, nr1);
+		unsigned char *b2 = framereader_read(r2, ctx->follow_start[1] + nr);
+		if (b1 == NULL || b2 == NULL) {
+			fprintf(stderr, "unable to read frame %08" PRId64 ", aborting\n", nr1);
+			break;
+		}
+		last_frame = follow_now();
+
+		struct frame_stats_s stats;
+		compute_frame_stats_cached(ctx, b1, b2, &stats);
+
+		double mse[3] = { stats.y_mse, stats.u_mse, stats.v_mse };
+		double psnr[3] = { stats.y_psnr, stats.u_psnr, stats.v_psnr };
+		stats_aggregate_add(agg, mse, psnr, stats.sharpness, hamming_distance(stats.hash[0], stats.hash[1]));
+		stats_window_add(&win, mse);
+		nr++;
+
+		if (!ctx->quiet) {
+			if (nr == 1) {
+				printf("%8s %9s %9s %9s %9s %9s %9s\n", "#  Frame", "MSE Y", "U", "V", "PSNR Y", "U", "V");
+			}
+			printf("%08" PRId64 ", %8.2f, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f\n", nr1,
+				stats.y_mse, stats.u_mse, stats.v_mse, stats.y_psnr, stats.u_psnr, stats.v_psnr);
+		}
+
+		if (ctx->sample_threshold > 0) {
+			double y = stats_window_psnr(&win, 0);
+			if (!alarm && y < ctx->sample_threshold) {
+				alarm = 1;
+				alarms++;
+				printf("# ALARM frame %08" PRId64 ", window Y PSNR %.2f dB below %.2f dB\n", nr1, y, ctx->sample_threshold);
+			} else if (alarm && y >= ctx->sample_threshold + FOLLOW_ALARM_HYSTERESIS) {
+				alarm = 0;
+				printf("# alarm cleared frame %08" PRId64 ", window Y PSNR %.2f dB\n", nr1, y);
+			}
+		}
+
+		if ((nr % window) == 0) {
+			printf("# window %08" PRId64 "-%08" PRId64 ", mse Y %8.2f, U %8.2f, V %8.2f, psnr(dB) Y %8.2f, U %8.2f, V %8.2f\n",
+				nr1 - window + 1, nr1,
+				stats_window_mse(&win, 0), stats_window_mse(&win, 1), stats_window_mse(&win, 2),
+				stats_window_psnr(&win, 0), stats_window_psnr(&win, 1), stats_window_psnr(&win, 2));
+		}
 	}
-	if (s1.st_size % frame_size) {
-		fprintf(stderr, "file input 1 isn't a perfect multiple of frame_size %d\n", frame_size);
-		exit(1);
+
+	stats_cache_close(ctx);
+	char label[96];
+	printf("# follow: %" PRId64 " frames compared, %d alarms%s\n", nr, alarms, alarm ? ", alarm still raised" : "");
+	stats_aggregate_print(agg, stdout, preview_label(ctx, "Aggregates", label, sizeof(label)));
+
+	stats_window_free(&win);
+	free(agg);
+	framereader_close(r1);
+	framereader_close(r2);
+	follow_close(f);
+
+	return 0; /* Success */
+}
+
+/* Batch runner, yuvmse -J manifest. Each pair's frames are cut into chunks that run
+ * on one shared work stealing pool, so short pairs keep the cores busy next to a
+ * long one instead of queueing behind it. Pairs are started longest first, only a
+ * bounded number of chunks is in flight, and each pair reduces its chunks in frame
+ * order as they land, so memory doesn't grow with the size of the batch. At most
+ * -I workers read at a time, the others compute.
+ */
+#define BATCH_CHUNK_FRAMES 16
+#define BATCH_INFLIGHT_PER_THREAD 2
+
+struct batch_s;
+struct batch_pair_s;
+
+struct batch_chunk_s
+{
+	struct batch_pair_s *pair;
+	int index;
+	int count;
+	int ok;                 /* Frames read and measured, a short read ends the chunk */
+	struct frame_stats_s stats[BATCH_CHUNK_FRAMES];
+};
+
+struct batch_pair_s
+{
+	struct batch_s *batch;
+	int nr;
+	const struct manifest_pair_s *m;
+	struct tool_context_s ctx;      /* Geometry only, no cache, grid or offset */
+	int frame_size;
+	int64_t total;                  /* Frames in the shorter input */
+	int64_t *plan;                  /* Sampled frames, NULL compares every frame */
+	int64_t count;                  /* Frames to compare */
+	int chunks;
+	int failed;
+
+	/* While running */
+	std::mutex lock;
+	int fd[2];
+	FILE *fh;
+	struct stats_aggregate_s *agg;
+	struct batch_chunk_s **landed;  /* Completed chunks waiting for their turn */
+	int reduced;
+	uint64_t flagged;
+
+	/* Summary, once reduced */
+	uint64_t frames;
+	double y_mse;
+	double y_psnr_global;
+	double y_psnr_mean;
+	double y_psnr_min;
+};
+
+struct batch_s
+{
+	struct tool_context_s *ctx;
+	struct workpool_s *pool;
+	struct batch_pair_s *pairs;
+	int pair_count;
+	int *order;                     /* Longest first */
+
+	std::mutex lock;
+	int next_pair;                  /* Index into order */
+	int next_chunk;
+
+	std::mutex io_lock;
+	std::condition_variable io_cond;
+	int io_busy;
+};
+
+static int batch_detect_geometry(const struct manifest_pair_s *m, int *width, int *height)
+{
+	struct stat s1, s2;
+	if (stat(m->fn[0], &s1) < 0 || stat(m->fn[1], &s2) < 0) {
+		return -1;
 	}
 
-	unsigned char *b1 = (unsigned char *)malloc(frame_size);
-	unsigned char *b2 = (unsigned char *)malloc(frame_size);
-	if (b1 == NULL || b2 == NULL) {
-		fprintf(stderr, "unable to allocate memory for frame, aborting\n");
-		exit(1);
+	int detected = -1, detections = 0;
+	for (size_t i = 0; i < (sizeof(tbl) / sizeof(tbl[0])); i++) {
+		if (s1.st_size && s1.st_size % tbl[i].frame_size == 0 && s2.st_size % tbl[i].frame_size == 0) {
+			detected = i;
+			detections++;
+		}
+	}
+	if (detections != 1) {
+		return -1;
 	}
 
-	int nr = 0;
+	*width = tbl[detected].width;
+	*height = tbl[detected].height;
+	return 0; /* Success */
+}
 
-	int line = 0;
-	while(1) {
-		size_t l1 = fread(b1, 1, frame_size, fh1);
-		size_t l2 = fread(b2, 1, frame_size, fh2);
+static int batch_read(int fd, unsigned char *dst, size_t len, off_t offset)
+{
+	size_t done = 0;
+	while (done < len) {
+		ssize_t l = pread(fd, dst + done, len - done, offset + done);
+		if (l <= 0) {
+			return -1;
+		}
+		done += l;
+	}
+	return 0; /* Success */
+}
 
-		if (l1 != frame_size || l2 != frame_size) {
-			break;
+static void batch_io_begin(struct batch_s *b)
+{
+	std::unique_lock<std::mutex> guard(b->io_lock);
+	b->io_cond.wait(guard, [b] { return b->io_busy < b->ctx->io_limit; });
+	b->io_busy++;
+}
+
+static void batch_io_end(struct batch_s *b)
+{
+	{
+		std::lock_guard<std::mutex> guard(b->io_lock);
+		b->io_busy--;
+	}
+	b->io_cond.notify_one();
+}
+
+/* Called with the pair lock held, or before any chunk was handed out */
+static void batch_pair_finish(struct batch_pair_s *p)
+{
+	struct stats_aggregate_s *agg = p->agg;
+	FILE *fh = p->fh;
+
+	if (p->m->mode != MANIFEST_MSE && agg->frames) {
+		sample_summary_print(fh, agg, agg->frames, p->total, p->batch->ctx->sample_threshold, p->flagged);
+	} else if (p->batch->ctx->sample_threshold > 0) {
+		fprintf(fh, "# below %.2f dB Y PSNR: %" PRIu64 " frames\n", p->batch->ctx->sample_threshold, p->flagged);
+	}
+	char label[96];
+	stats_aggregate_print(agg, fh, preview_label(&p->ctx, "Aggregates", label, sizeof(label)));
+
+	const struct stats_plane_s *y = &agg->plane[0];
+	p->frames = agg->frames;
+	p->y_mse = y->mse.mean;
+	p->y_psnr_global = stats_psnr_from_sse(y->sse, y->pixels * agg->frames, 255.0);
+	p->y_psnr_mean = y->psnr.count ? y->psnr.mean : INFINITY;
+	p->y_psnr_min = stats_psnr_from_sse(y->mse.max * y->pixels, y->pixels, 255.0);
+
+	fclose(fh);
+	close(p->fd[0]);
+	close(p->fd[1]);
+	free(p->landed);
+	free(agg);
+	p->fh = NULL;
+	p->agg = NULL;
+	p->landed = NULL;
+
+	printf("# pair %03d: %" PRIu64 " frames, Y PSNR %.2f dB, report %s\n", p->nr, p->frames, p->y_psnr_global, p->m->reportfn);
+}
+
+/* Open the inputs and report, called under the batch lock as the first chunk is handed out */
+static int batch_pair_start(struct batch_pair_s *p)
+{
+	struct tool_context_s *ctx = p->batch->ctx;
+
+	p->fd[0] = open(p->m->fn[0], O_RDONLY);
+	p->fd[1] = open(p->m->fn[1], O_RDONLY);
+	p->fh = fopen(p->m->reportfn, "wb");
+	p->agg = (struct stats_aggregate_s *)malloc(sizeof(*p->agg));
+	p->landed = (struct batch_chunk_s **)calloc(p->chunks + 1, sizeof(*p->landed));
+	if (p->fd[0] < 0 || p->fd[1] < 0 || p->fh == NULL || p->agg == NULL || p->landed == NULL) {
+		fprintf(stderr, "pair %03d (manifest line %d): unable to open inputs or report %s, skipped\n",
+			p->nr, p->m->line, p->m->reportfn);
+		if (p->fd[0] >= 0) {
+			close(p->fd[0]);
+		}
+		if (p->fd[1] >= 0) {
+			close(p->fd[1]);
 		}
+		if (p->fh) {
+			fclose(p->fh);
+		}
+		free(p->agg);
+		free(p->landed);
+		p->agg = NULL;
+		p->landed = NULL;
+		p->failed = 1;
+		return -1;
+	}
+	posix_fadvise(p->fd[0], 0, 0, POSIX_FADV_SEQUENTIAL);
+	posix_fadvise(p->fd[1], 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	stats_aggregate_init(p->agg, p->ctx.width, p->ctx.height);
+	p->reduced = 0;
+	p->flagged = 0;
+
+	fprintf(p->fh, "# dimensions: %d x %d\n", p->ctx.width, p->ctx.height);
+	fprintf(p->fh, "# file0: %s\n", p->m->fn[0]);
+	fprintf(p->fh, "# file1: %s\n", p->m->fn[1]);
+	fprintf(p->fh, "# mode: %s", manifest_mode_name(p->m->mode));
+	if (p->m->mode != MANIFEST_MSE) {
+		fprintf(p->fh, " %d, seed %u", p->m->n, ctx->sample_seed);
+	}
+	fprintf(p->fh, ", %" PRId64 " of %" PRId64 " frames\n", p->count, p->total);
+	if (!ctx->quiet) {
+		fprintf(p->fh, "%8s %9s %9s %9s %9s %9s %9s\n", "#  Frame", "MSE Y", "U", "V", "PSNR Y", "U", "V");
+	}
 
-		struct frame_stats_s stats;
-		compute_frame_stats(ctx, b1, b2, &stats);
+	if (p->chunks == 0) {
+		batch_pair_finish(p);
+		return -1;
+	}
 
-		if (line == 0) {
-			printf("%8s %9s %9s %9s %9s %9s %9s %9s %27s %17s %8s %21s", "#  Frame", "MSE", "", "", "PSNR", "", "", "Sharp", "DCT Hash", "", "Hamming", "Hash");
-			printf("\n");
-			printf("%8s %9s %9s %9s %9s %9s %9s %9s %9s", "#     Nr", "Y", "U", "V", "Y", "U", "V", "f1", "f2");
-			printf("%18s %17s %8s %21s", "f1", "f2", "Dist", "Assessment");
-			printf("\n");
-			printf("#------> <---------------------------> <---------------------------> <-----------------> <---------------------------------------------------------------->\n");
+	return 0; /* Success */
+}
+
+static void batch_reduce(struct batch_chunk_s *c)
+{
+	struct batch_pair_s *p = c->pair;
+	struct tool_context_s *ctx = p->batch->ctx;
+
+	for (int i = 0; i < c->ok; i++) {
+		const struct frame_stats_s *stats = &c->stats[i];
+		int64_t k = ((int64_t)c->index * BATCH_CHUNK_FRAMES) + i;
+		int64_t nr = p->plan ? p->plan[k] : k;
+
+		double mse[3] = { stats->y_mse, stats->u_mse, stats->v_mse };
+		double psnr[3] = { stats->y_psnr, stats->u_psnr, stats->v_psnr };
+		stats_aggregate_add(p->agg, mse, psnr, stats->sharpness, hamming_distance(stats->hash[0], stats->hash[1]));
+
+		int below = ctx->sample_threshold > 0 && stats->y_psnr < ctx->sample_threshold;
+		p->flagged += below;
+		if (ctx->quiet && !below) {
+			continue;
 		}
+		fprintf(p->fh, "%08" PRId64 ", %8.2f, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f%s\n", nr,
+			stats->y_mse, stats->u_mse, stats->v_mse, stats->y_psnr, stats->u_psnr, stats->v_psnr,
+			below ? ", below threshold" : "");
+	}
+}
 
-		if (line++ > 24) {
-			line = 0;
+/* A chunk completed, reduce whatever is now in order */
+static void batch_land(struct batch_chunk_s *c)
+{
+	struct batch_pair_s *p = c->pair;
+	std::lock_guard<std::mutex> guard(p->lock);
+
+	p->landed[c->index] = c;
+	while (p->reduced < p->chunks && p->landed[p->reduced]) {
+		struct batch_chunk_s *r = p->landed[p->reduced];
+		batch_reduce(r);
+		p->landed[p->reduced++] = NULL;
+		free(r);
+	}
+	if (p->reduced == p->chunks) {
+		batch_pair_finish(p);
+	}
+}
+
+static void batch_task(void *arg, int worker);
+
+/* Hand the next chunk to the pool, 0 when the batch is fully handed out */
+static int batch_feed(struct batch_s *b)
+{
+	struct batch_chunk_s *c = NULL;
+	{
+		std::lock_guard<std::mutex> guard(b->lock);
+		while (c == NULL && b->next_pair < b->pair_count) {
+			struct batch_pair_s *p = &b->pairs[b->order[b->next_pair]];
+			if (p->failed || (b->next_chunk == 0 && batch_pair_start(p) < 0)) {
+				b->next_pair++;
+				continue;
+			}
+
+			c = (struct batch_chunk_s *)malloc(sizeof(*c));
+			if (c == NULL) {
+				fprintf(stderr, "unable to allocate memory for a batch chunk, aborting\n");
+				exit(1);
+			}
+			c->pair = p;
+			c->index = b->next_chunk++;
+			c->count = p->count - ((int64_t)c->index * BATCH_CHUNK_FRAMES);
+			if (c->count > BATCH_CHUNK_FRAMES) {
+				c->count = BATCH_CHUNK_FRAMES;
+			}
+			c->ok = 0;
+
+			if (b->next_chunk == p->chunks) {
+				b->next_pair++;
+				b->next_chunk = 0;
+			}
 		}
+	}
 
-		printf("%08d, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f, %8.2f", nr,
-			stats.y_mse, stats.u_mse, stats.v_mse,
-			stats.y_psnr, stats.u_psnr, stats.v_psnr);
+	if (c == NULL) {
+		return 0;
+	}
+	workpool_submit(b->pool, batch_task, c);
+	return 1;
+}
 
-		int hd = hamming_distance(stats.hash[0], stats.hash[1]);
+static void batch_task(void *arg, int worker)
+{
+	struct batch_chunk_s *c = (struct batch_chunk_s *)arg;
+	struct batch_pair_s *p = c->pair;
+	struct batch_s *b = p->batch;
+
+	/* Both frames in this worker's scratch, reused chunk after chunk */
+	struct arena_s *arena = arena_thread();
+	size_t mark = arena_mark(arena);
+	unsigned char *b1 = (unsigned char *)arena_alloc(arena, p->frame_size);
+	unsigned char *b2 = (unsigned char *)arena_alloc(arena, p->frame_size);
+
+	for (int i = 0; b1 && b2 && i < c->count; i++) {
+		int64_t k = ((int64_t)c->index * BATCH_CHUNK_FRAMES) + i;
+		off_t offset = (off_t)(p->plan ? p->plan[k] : k) * p->frame_size;
+
+		batch_io_begin(b);
+		int ret = batch_read(p->fd[0], b1, p->frame_size, offset);
+		if (ret == 0) {
+			ret = batch_read(p->fd[1], b2, p->frame_size, offset);
+		}
+		batch_io_end(b);
+		if (ret < 0) {
+			break;
+		}
 
-		printf(", %8.2f, %8.2f, %" PRIx64 ", %" PRIx64 ", %7d, %20s",
-			stats.sharpness[0], stats.sharpness[1], stats.hash[0], stats.hash[1],
-			hd,
-			hd == 0 ? "Exact Match" :
-			hd <= 10 ? "Near Identical" : "Different");
+		compute_frame_stats(&p->ctx, b1, b2, &c->stats[i]);
+		c->ok++;
+	}
 
-		printf("\n");
+	arena_release(arena, mark);
 
-		nr++;
+	batch_land(c);
+	batch_feed(b);
+}
+
+int compute_sequence_batch(struct tool_context_s *ctx)
+{
+	struct manifest_pair_s *m;
+	int count;
+	int ret = manifest_load(ctx->manifestfn, &m, &count);
+	if (ret == -1) {
+		fprintf(stderr, "unable to read manifest %s, aborting\n", ctx->manifestfn);
+		exit(1);
+	}
+	if (ret < 0) {
+		fprintf(stderr, "manifest %s line %d is malformed, aborting\n", ctx->manifestfn, -ret - 1);
+		exit(1);
 	}
 
-	free(b1);
-	free(b2);
-	fclose(fh1);
-	fclose(fh2);
+	struct batch_s *b = new batch_s;
+	b->ctx = ctx;
+	b->pairs = new batch_pair_s[count];
+	b->pair_count = count;
+	b->order = (int *)malloc((count + 1) * sizeof(int));
+	b->next_pair = 0;
+	b->next_chunk = 0;
+	b->io_busy = 0;
+	if (ctx->io_limit <= 0) {
+		ctx->io_limit = 1;
+	}
 
-	return 0;
+	for (int i = 0; i < count; i++) {
+		struct batch_pair_s *p = &b->pairs[i];
+		p->batch = b;
+		p->nr = i;
+		p->m = &m[i];
+		p->plan = NULL;
+		p->count = 0;
+		p->chunks = 0;
+		p->failed = 0;
+		p->fh = NULL;
+		p->agg = NULL;
+		p->landed = NULL;
+		p->frames = 0;
+		b->order[i] = i;
+
+		/* A private context, geometry only. compute_frame_stats() is then safe on any worker. */
+		memset(&p->ctx, 0, sizeof(p->ctx));
+		p->ctx.width = ctx->width;
+		p->ctx.height = ctx->height;
+		if (m[i].width) {
+			p->ctx.width = m[i].width;
+			p->ctx.height = m[i].height;
+		} else {
+			batch_detect_geometry(&m[i], &p->ctx.width, &p->ctx.height);
+		}
+		p->frame_size = (p->ctx.width * p->ctx.height * 3) / 2; /* YUV420 */
+		p->ctx.preview = ctx->preview;
+		if (ctx->preview > 0 && !pyramid_level_valid(p->ctx.width, p->ctx.height, ctx->preview)) {
+			fprintf(stderr, "pair %03d (manifest line %d): %dx%d doesn't decimate to preview %dx, skipped\n",
+				i, m[i].line, p->ctx.width, p->ctx.height, 1 << ctx->preview);
+			p->failed = 1;
+			continue;
+		}
+
+		struct stat s1, s2;
+		if (stat(m[i].fn[0], &s1) < 0 || stat(m[i].fn[1], &s2) < 0) {
+			fprintf(stderr, "pair %03d (manifest line %d): input not found, skipped\n", i, m[i].line);
+			p->failed = 1;
+			continue;
+		}
+		p->total = (s1.st_size < s2.st_size ? s1.st_size : s2.st_size) / p->frame_size;
+
+		if (m[i].mode == MANIFEST_MSE) {
+			p->count = p->total;
+		} else if (p->total > 0) {
+			p->plan = sample_plan(m[i].mode == MANIFEST_EVERY ? m[i].n : 0, m[i].n, ctx->sample_seed, p->total, &p->count);
+			if (p->plan == NULL) {
+				fprintf(stderr, "unable to allocate memory for the sample, aborting\n");
+				exit(1);
+			}
+		}
+		p->chunks = (p->count + BATCH_CHUNK_FRAMES - 1) / BATCH_CHUNK_FRAMES;
+	}
+
+	/* Longest first, the short pairs fill in around them */
+	std::sort(b->order, b->order + count, [b](int x, int y) {
+		return (double)b->pairs[x].count * b->pairs[x].frame_size > (double)b->pairs[y].count * b->pairs[y].frame_size;
+	});
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	b->pool = workpool_alloc(ctx->threads);
+	int threads = workpool_threads(b->pool);
+	printf("# batch: %d pairs, %d threads, %d concurrent reads\n", count, threads, ctx->io_limit);
+
+	for (int i = 0; i < threads * BATCH_INFLIGHT_PER_THREAD; i++) {
+		if (batch_feed(b) == 0) {
+			break;
+		}
+	}
+	workpool_wait(b->pool);
+	workpool_free(b->pool);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double seconds = (t1.tv_sec - t0.tv_sec) + ((t1.tv_nsec - t0.tv_nsec) / 1e9);
+
+	/* Combined summary, one row per pair */
+	uint64_t frames = 0;
+	int failed = 0, worst = -1;
+	printf("# %5s %10s %9s %9s %9s %9s  %s\n", "Pair", "Frames", "Y MSE", "PSNR glob", "mean", "min", "Report");
+	for (int i = 0; i < count; i++) {
+		struct batch_pair_s *p = &b->pairs[i];
+		if (p->failed) {
+			printf("# %5d %10s %9s %9s %9s %9s  %s\n", i, "failed", "", "", "", "", m[i].reportfn);
+			failed++;
+			continue;
+		}
+		printf("# %5d %10" PRIu64 " %9.2f %9.2f %9.2f %9.2f  %s\n", i, p->frames,
+			p->y_mse, p->y_psnr_global, p->y_psnr_mean, p->y_psnr_min, m[i].reportfn);
+		frames += p->frames;
+		if (p->frames && (worst < 0 || p->y_psnr_global < b->pairs[worst].y_psnr_global)) {
+			worst = i;
+		}
+	}
+	printf("# Batch: %d pairs (%d failed), %" PRIu64 " frames in %.2f s, %.1f frames/s\n",
+		count, failed, frames, seconds, seconds > 0 ? frames / seconds : 0.0);
+	if (worst >= 0) {
+		printf("# worst: pair %03d, Y PSNR %.2f dB, %s vs %s\n", worst, b->pairs[worst].y_psnr_global,
+			m[worst].fn[0], m[worst].fn[1]);
+	}
+
+	for (int i = 0; i < count; i++) {
+		free(b->pairs[i].plan);
+	}
+	delete [] b->pairs;
+	free(b->order);
+	delete b;
+	free(m);
+
+	return failed ? -1 : 0;
 }
 
 void args_to_console(struct tool_context_s *ctx)
@@ -729,8 +2934,60 @@ void args_to_console(struct tool_context_s *ctx)
 	printf("# windowsize: %d\n", ctx->windowsize);
 	printf("# skipframes: %d\n", ctx->skipframes);
 	printf("# bestmatch: %d\n", ctx->bestmatch);
+	printf("# threads: %d\n", ctx->threads);
 	printf("# verbose: %d\n", ctx->verbose);
+	printf("# kernels: %s\n", kernels_get()->name);
 	printf("# dcthashmatch: %d\n", ctx->dcthashmatch);
+	if (ctx->dcthashmatch && (ctx->hash_band || ctx->matrixfn || ctx->xhash)) {
+		printf("# hash band: %d, matrix: %s, %s\n", ctx->hash_band, ctx->matrixfn ? ctx->matrixfn : "none",
+			ctx->xhash ? "256 bit fingerprints" : "64 bit hashes");
+	}
+	printf("# xcorrmatch: %d\n", ctx->xcorrmatch);
+	if (ctx->mapoutfn) {
+		printf("# drift map output: %s\n", ctx->mapoutfn);
+	}
+	if (ctx->mapinfn) {
+		printf("# frame map input: %s\n", ctx->mapinfn);
+	}
+	printf("# window: %d\n", ctx->window);
+	printf("# quiet: %d\n", ctx->quiet);
+	if (ctx->shift_range) {
+		printf("# spatial search range: %d\n", ctx->shift_range);
+	}
+	if (ctx->block_size) {
+		printf("# block size: %d\n", ctx->block_size);
+		printf("# block grid: %s\n", ctx->gridfn ? ctx->gridfn : "none");
+		printf("# heatmap: %s\n", ctx->heatmapfn ? ctx->heatmapfn : "none");
+	}
+	if (ctx->segfn) {
+		printf("# segments: %s\n", ctx->segfn);
+		printf("# cut threshold: %d\n", ctx->cut_threshold);
+	}
+	if (ctx->ckptfn) {
+		printf("# checkpoint: %s, every %d frames%s\n", ctx->ckptfn, ctx->ckpt_interval, ctx->resume ? ", resuming" : "");
+	}
+	if (ctx->cache_entries > 0) {
+		printf("# stats cache: %d entries\n", ctx->cache_entries);
+	}
+	printf("# io depth: %d%s\n", ctx->io_depth, ctx->io_direct ? ", direct" : "");
+	printf("# huge pages: %s\n", arena_huge_name(arena_huge_mode()));
+	if (ctx->preview) {
+		printf("# preview: %dx, metrics at %dx%d\n", 1 << ctx->preview, ctx->width >> ctx->preview, ctx->height >> ctx->preview);
+	}
+	if (ctx->sample_every > 0 || ctx->sample_count > 0) {
+		printf("# sample: %s %d, seed %u, threshold %.2f dB\n", ctx->sample_every > 0 ? "every" : "stratified",
+			ctx->sample_every > 0 ? ctx->sample_every : ctx->sample_count, ctx->sample_seed, ctx->sample_threshold);
+	}
+	if (ctx->manifestfn) {
+		printf("# batch manifest: %s, %d concurrent reads\n", ctx->manifestfn, ctx->io_limit);
+	}
+	if (ctx->follow) {
+		printf("# follow: start %d,%d, idle %d s\n", ctx->follow_start[0], ctx->follow_start[1], ctx->follow_idle);
+	}
+	if (ctx->metricsfn) {
+		printf("# metrics output: %s\n", ctx->metricsfn);
+		printf("# vmaf input: %s\n", ctx->vmaffn ? ctx->vmaffn : "none");
+	}
 }
 
 int main(int argc, char *argv[])
@@ -741,10 +2998,30 @@ int main(int argc, char *argv[])
 	ctx->width = 1920;
 	ctx->height = 1080;
 	ctx->windowsize = 30;
+	ctx->cut_threshold = SEGMENT_CUT_THRESHOLD_DEFAULT;
+	ctx->cache_entries = FRAMECACHE_ENTRIES_DEFAULT;
+	ctx->io_depth = FRAMEREADER_DEPTH_DEFAULT;
+	ctx->sample_seed = 1;
+	ctx->io_limit = BATCH_IO_DEFAULT;
 
 	int ch, idx, ret;
 
-	while ((ch = getopt(argc, argv, "?h1:2:3:4:bs:vw:DW:H:")) != -1) {
+	static struct option long_options[] = {
+		{ "resume", no_argument, NULL, 'Z' },
+		{ "direct", no_argument, NULL, 'Y' },
+		{ "hugepages", required_argument, NULL, 'X' },
+		{ "follow", no_argument, NULL, 'f' },
+		{ "start", required_argument, NULL, 'P' },
+		{ "idle", required_argument, NULL, 'N' },
+		{ "poll", required_argument, NULL, 'p' },
+		{ "preview", required_argument, NULL, 'z' },
+		{ "band", required_argument, NULL, 'k' },
+		{ "matrix", required_argument, NULL, 'l' },
+		{ "xhash", no_argument, NULL, 'A' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	while ((ch = getopt_long(argc, argv, "?h1:2:3:4:a:bB:C:e:E:fG:I:j:J:K:L:m:M:n:O:qQ:r:R:s:t:U:vV:w:x:z:DFS:T:W:H:", long_options, NULL)) != -1) {
 		switch (ch) {
 		case '1':
 		case '2':
@@ -757,6 +3034,9 @@ int main(int argc, char *argv[])
 				ctx->dimension_defaults = 2;
 			}
 			break;
+		case 'a':
+			ctx->window = atoi(optarg);
+			break;
 		case 'b':
 			ctx->dcthashmatch = 0;
 			ctx->bestmatch = 1;
@@ -764,16 +3044,146 @@ int main(int argc, char *argv[])
 		case 'v':
 			ctx->verbose++;
 			break;
+		case 'B':
+			ctx->block_size = atoi(optarg);
+			break;
+		case 'C':
+			ctx->ckptfn = strdup(optarg);
+			break;
+		case 'K':
+			ctx->ckpt_interval = atoi(optarg);
+			break;
+		case 'L':
+			ctx->cache_entries = atoi(optarg);
+			break;
+		case 'Z':
+			ctx->resume = 1;
+			break;
+		case 'I':
+			ctx->io_limit = atoi(optarg);
+			break;
+		case 'J':
+			ctx->manifestfn = strdup(optarg);
+			break;
+		case 'e':
+			ctx->sample_seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			ctx->sample_every = atoi(optarg);
+			break;
+		case 'r':
+			ctx->sample_count = atoi(optarg);
+			break;
+		case 't':
+			ctx->sample_threshold = atof(optarg);
+			break;
+		case 'E':
+			ctx->io_engine = framereader_engine_lookup(optarg);
+			if (ctx->io_engine < 0) {
+				fprintf(stderr, "read ahead engine %s unknown, aborting\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'Y':
+			ctx->io_direct = 1;
+			break;
+		case 'f':
+			ctx->follow = 1;
+			break;
+		case 'P':
+			if (sscanf(optarg, "%d,%d", &ctx->follow_start[0], &ctx->follow_start[1]) != 2 ||
+				ctx->follow_start[0] < 0 || ctx->follow_start[1] < 0) {
+				fprintf(stderr, "--start needs two frame numbers, A,B, aborting\n");
+				exit(1);
+			}
+			break;
+		case 'N':
+			ctx->follow_idle = atoi(optarg);
+			break;
+		case 'p':
+			ctx->follow_poll_ms = atoi(optarg);
+			break;
+		case 'X':
+			ret = arena_huge_lookup(optarg);
+			if (ret < 0) {
+				fprintf(stderr, "huge page mode %s unknown, aborting\n", optarg);
+				exit(1);
+			}
+			arena_set_huge(ret);
+			break;
+		case 'G':
+			ctx->gridfn = strdup(optarg);
+			break;
+		case 'j':
+			ctx->threads = atoi(optarg);
+			break;
+		case 'm':
+			ctx->metricsfn = strdup(optarg);
+			break;
+		case 'M':
+			ctx->heatmapfn = strdup(optarg);
+			break;
+		case 'O':
+			ctx->shift_range = atoi(optarg);
+			break;
+		case 'q':
+			ctx->quiet = 1;
+			break;
+		case 'Q':
+			ctx->io_depth = atoi(optarg);
+			break;
+		case 'R':
+			ctx->mapoutfn = strdup(optarg);
+			break;
+		case 'U':
+			ctx->mapinfn = strdup(optarg);
+			break;
+		case 'V':
+			ctx->vmaffn = strdup(optarg);
+			break;
 		case 's':
 			ctx->skipframes = atoi(optarg);
 			break;
 		case 'w':
 			ctx->windowsize = atoi(optarg);
 			break;
+		case 'k':
+			ctx->hash_band = atoi(optarg);
+			break;
+		case 'l':
+			ctx->matrixfn = strdup(optarg);
+			break;
+		case 'A':
+			ctx->xhash = 1;
+			break;
+		case 'z':
+			ctx->preview = pyramid_factor_level(atoi(optarg));
+			if (ctx->preview < 0) {
+				fprintf(stderr, "preview factor must be 1, 2 or 4, aborting\n");
+				exit(1);
+			}
+			break;
+		case 'x':
+			if (kernels_force(optarg) < 0) {
+				fprintf(stderr, "kernel path %s unknown or not supported by this cpu, aborting\n", optarg);
+				exit(1);
+			}
+			break;
 		case 'D':
 			ctx->dcthashmatch = 1;
 			ctx->bestmatch = 0;
 			break;
+		case 'S':
+			ctx->segfn = strdup(optarg);
+			break;
+		case 'T':
+			ctx->cut_threshold = atoi(optarg);
+			break;
+		case 'F':
+			ctx->xcorrmatch = 1;
+			ctx->dcthashmatch = 0;
+			ctx->bestmatch = 0;
+			break;
 		case 'H':
 			ctx->height = atoi(optarg);
 			ctx->dimension_defaults = 0;
@@ -794,16 +3204,45 @@ int main(int argc, char *argv[])
 		usage();
 		exit(1);
 	}
+	if ((ctx->gridfn || ctx->heatmapfn) && ctx->block_size == 0) {
+		ctx->block_size = BLOCKMSE_SIZE_DEFAULT;
+	}
+	if ((ctx->resume || ctx->ckpt_interval > 0) && ctx->ckptfn == NULL) {
+		ctx->ckptfn = strdup("yuvmse.ckpt");
+	}
+	if (ctx->ckptfn && ctx->ckpt_interval <= 0) {
+		ctx->ckpt_interval = CHECKPOINT_INTERVAL_DEFAULT;
+	}
+
+	/* Only a preview decimates, full resolution runs take any geometry they did before */
+	if (ctx->manifestfn == NULL && ctx->preview > 0 && !pyramid_level_valid(ctx->width, ctx->height, ctx->preview)) {
+		fprintf(stderr, "%dx%d doesn't decimate evenly to preview %dx, aborting\n", ctx->width, ctx->height, 1 << ctx->preview);
+		exit(1);
+	}
+
 	args_to_console(ctx);
 
 	ctx->windowsize += ctx->skipframes;
 
-	if (ctx->bestmatch) {
-		int ret = compute_sequence_bestmatch(ctx);
+	/* Non zero exit when a mode reports failure, batch does for any failed pair */
+	if (ctx->manifestfn) {
+		ret = compute_sequence_batch(ctx);
+	} else if (ctx->follow) {
+		ret = compute_sequence_follow(ctx);
+	} else if (ctx->bestmatch) {
+		ret = compute_sequence_bestmatch(ctx);
 	} else if (ctx->dcthashmatch) {
-		int ret = compute_sequence_dct_hashes(ctx);
+		ret = compute_sequence_dct_hashes(ctx);
+	} else if (ctx->xcorrmatch) {
+		ret = compute_sequence_xcorr(ctx);
+	} else if (ctx->mapoutfn) {
+		ret = compute_sequence_drift(ctx);
+	} else if (ctx->segfn && ctx->fn[1] == NULL) {
+		ret = compute_sequence_segments(ctx);
+	} else if (ctx->sample_every > 0 || ctx->sample_count > 0) {
+		ret = compute_sequence_sample(ctx);
 	} else {
-		int ret = compute_sequence_mse(ctx);
+		ret = compute_sequence_mse(ctx);
 	}
 
 	for (int i = 0; i < MAX_INPUTS; i++) {
@@ -811,6 +3250,16 @@ int main(int argc, char *argv[])
 			free(ctx->fn[i]);
 		}
 	}
-	return 0;
+	free(ctx->segfn);
+	free(ctx->gridfn);
+	free(ctx->heatmapfn);
+	free(ctx->mapoutfn);
+	free(ctx->mapinfn);
+	free(ctx->metricsfn);
+	free(ctx->vmaffn);
+	free(ctx->ckptfn);
+	free(ctx->manifestfn);
+	free(ctx->matrixfn);
+	return ret < 0 ? 1 : 0;
 }
 